@@ -0,0 +1,386 @@
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include <benchmark/benchmark.h>
+
+#include "viewpoint_interface/layout.hpp"
+#include "viewpoint_interface/scoreboard.hpp"
+
+
+/**
+ * Benchmarks for the display bookkeeping that runs on the render thread every
+ * frame. None of it touches ROS or GL, so these run anywhere. Results are
+ * printed as JSON unless another --benchmark_format is given, e.g.
+ *
+ *      viewpoint_interface_bench --benchmark_out=results.json
+ */
+
+namespace viewpoint_interface
+{
+
+static const int64_t kMinDisplays = 4;
+static const int64_t kMaxDisplays = 64;
+
+static const uint kDisplayWidth = 64;
+static const uint kDisplayHeight = 48;
+
+
+// Exposes the protected display state classes and draws nothing
+class BenchLayout : public Layout
+{
+public:
+    using Layout::DisplayRing;
+    using Layout::LayoutDisplayStates;
+
+    BenchLayout(DisplayManager &displays) : Layout(LayoutType::GRID, displays) {}
+
+    virtual void displayLayoutParams() override {}
+    virtual void draw() override {}
+
+    LayoutDisplayStates& getDisplayStates() { return display_states_; }
+
+    // The geometry part of drawLayoutComponents() for a layout with one primary
+    // window. Uncached, the component and its geometry are rebuilt every frame,
+    // as they were before the geometry was cached
+    void updateFrameGeometry(bool cached)
+    {
+        if (!cached) {
+            layout_components_.clear();
+            geometry_dirty_ = true;
+        }
+
+        num_components_added_ = 0;
+        addLayoutComponent(LayoutComponent::Type::Primary);
+        if (isGeometryStale()) {
+            updateGeometry(layout_components_.front());
+        }
+        benchmark::DoNotOptimize(primary_rects_.data());
+        benchmark::DoNotOptimize(display_bounds_.data());
+    }
+};
+
+static void addDisplays(DisplayManager &displays, uint num_displays)
+{
+    for (uint i(0); i < num_displays; ++i) {
+        std::string name("camera_" + std::to_string(i)), topic("/bench/camera_" + std::to_string(i));
+        displays.addDisplay(Display(name, name, topic, DisplayDims(kDisplayWidth, kDisplayHeight, 3)));
+    }
+}
+
+// Each display count with a single primary display and with half of them primary
+static void addDisplayArgs(benchmark::internal::Benchmark *bench)
+{
+    for (int64_t num(kMinDisplays); num <= kMaxDisplays; num *= 2) {
+        bench->Args({num, 1});
+        bench->Args({num, num / 2});
+    }
+}
+
+
+// --- DisplayRing ---
+
+// Moves the primary displays along the ring, which has to skip the displays
+// that already have the role (see getNextIdWithoutRole())
+static void BM_DisplayRingToNextDisplay(benchmark::State &state)
+{
+    uint num_displays(state.range(0)), num_primary(state.range(1));
+
+    BenchLayout::DisplayRing ring;
+    for (uint i(0); i < num_displays; ++i) {
+        ring.pushDisplay(i);
+    }
+    for (uint i(0); i < num_primary; ++i) {
+        ring.setDisplayRole(ring.getDisplayIdByIx(i), LayoutDisplayRole::Primary);
+    }
+    ring.setActiveFrameByIndex(0);
+
+    for (auto _ : state) {
+        ring.toNextDisplay(LayoutDisplayRole::Primary);
+    }
+    state.counters["displays"] = num_displays;
+    state.counters["primary"] = num_primary;
+}
+BENCHMARK(BM_DisplayRingToNextDisplay)->Apply(addDisplayArgs);
+
+static void BM_DisplayRingGetDisplayRoleList(benchmark::State &state)
+{
+    uint num_displays(state.range(0)), num_primary(state.range(1));
+
+    BenchLayout::DisplayRing ring;
+    for (uint i(0); i < num_displays; ++i) {
+        ring.pushDisplay(i);
+    }
+    for (uint i(0); i < num_primary; ++i) {
+        ring.setDisplayRole(ring.getDisplayIdByIx(i), LayoutDisplayRole::Primary);
+    }
+
+    for (auto _ : state) {
+        BenchLayout::DisplayRing::RoleList primary(ring.getDisplayRoleList(LayoutDisplayRole::Primary));
+        benchmark::DoNotOptimize(primary->data());
+        benchmark::DoNotOptimize(ring.isPrimaryDisplay(num_displays - 1));
+    }
+    state.counters["displays"] = num_displays;
+    state.counters["primary"] = num_primary;
+}
+BENCHMARK(BM_DisplayRingGetDisplayRoleList)->Apply(addDisplayArgs);
+
+// Changing a role rebuilds the role lists, which every frame's lookups then use
+static void BM_DisplayRingRoleChange(benchmark::State &state)
+{
+    uint num_displays(state.range(0));
+
+    BenchLayout::DisplayRing ring;
+    for (uint i(0); i < num_displays; ++i) {
+        ring.pushDisplay(i);
+    }
+    ring.setDisplayRole(0, LayoutDisplayRole::Primary);
+
+    uint id(1);
+    for (auto _ : state) {
+        ring.setDisplayRole(id, LayoutDisplayRole::Secondary);
+        benchmark::DoNotOptimize(ring.getDisplayRoleList(LayoutDisplayRole::Secondary)->data());
+        ring.unsetDisplayRole(id, LayoutDisplayRole::Secondary);
+        id = (id % (num_displays - 1)) + 1;
+    }
+    state.counters["displays"] = num_displays;
+}
+BENCHMARK(BM_DisplayRingRoleChange)->RangeMultiplier(2)->Range(kMinDisplays, kMaxDisplays);
+
+
+// --- LayoutDisplayStates ---
+
+// Displays switched off and back on from the displays list, as in the PiP layouts
+static void BM_LayoutDisplayStatesChurn(benchmark::State &state)
+{
+    uint num_displays(state.range(0));
+
+    DisplayManager displays;
+    addDisplays(displays, num_displays);
+    BenchLayout layout(displays);
+    BenchLayout::LayoutDisplayStates &states(layout.getDisplayStates());
+    states.setNumDisplaysForRole(1, LayoutDisplayRole::Primary);
+    states.setNumDisplaysForRole(1, LayoutDisplayRole::Secondary);
+
+    uint ix(0);
+    for (auto _ : state) {
+        uint id(displays.getDisplayId(ix));
+        states.deactivateDisplay(id);
+        states.activateDisplay(id);
+        ix = (ix + 1) % num_displays;
+    }
+    state.counters["displays"] = num_displays;
+}
+BENCHMARK(BM_LayoutDisplayStatesChurn)->RangeMultiplier(2)->Range(kMinDisplays, kMaxDisplays);
+
+static void BM_LayoutDisplayStatesActiveIx(benchmark::State &state)
+{
+    uint num_displays(state.range(0));
+
+    DisplayManager displays;
+    addDisplays(displays, num_displays);
+    BenchLayout layout(displays);
+    BenchLayout::LayoutDisplayStates &states(layout.getDisplayStates());
+
+    // Every other display is inactive, so each step skips one
+    for (uint i(1); i < num_displays; i += 2) {
+        states.deactivateDisplay(displays.getDisplayId(i));
+    }
+
+    uint ix(0);
+    for (auto _ : state) {
+        ix = states.getNextActiveDisplayIx(ix);
+        benchmark::DoNotOptimize(ix);
+    }
+    state.counters["displays"] = num_displays;
+}
+BENCHMARK(BM_LayoutDisplayStatesActiveIx)->RangeMultiplier(2)->Range(kMinDisplays, kMaxDisplays);
+
+
+// --- LayoutComponent ---
+
+static void BM_DisplayGridFit(benchmark::State &state)
+{
+    uint num_displays(state.range(0)), per_page(state.range(1));
+
+    uint active_ix(0);
+    for (auto _ : state) {
+        DisplayGrid grid(DisplayGrid::fit(num_displays, per_page, active_ix, 1920.0f, 1080.0f, 4.0f / 3.0f));
+        benchmark::DoNotOptimize(grid);
+        active_ix = (active_ix + 1) % num_displays;
+    }
+    state.counters["displays"] = num_displays;
+}
+BENCHMARK(BM_DisplayGridFit)->ArgsProduct({benchmark::CreateRange(kMinDisplays, kMaxDisplays, 2), {0, 16}});
+
+// What Layout::updateGeometry() does for the primary window when the ring or window changes
+static void BM_LayoutComponentPrimaryRects(benchmark::State &state)
+{
+    uint num_displays(state.range(0));
+
+    DisplayManager displays;
+    addDisplays(displays, num_displays);
+    BenchLayout layout(displays);
+    BenchLayout::LayoutDisplayStates &states(layout.getDisplayStates());
+    states.setNumDisplaysForRole(-1, LayoutDisplayRole::Primary);
+
+    LayoutComponent primary(layout, LayoutComponent::Type::Primary, LayoutComponent::Spacing::Auto,
+            LayoutComponent::ComponentPositioning_Auto, 0.0f, 0.0f, ImVec2{-1.0f, -1.0f});
+    primary.setWidth(1920.0f);
+    primary.setHeight(1080.0f);
+    primary.setOffset(ImVec2{0.0f, 0.0f});
+
+    for (auto _ : state) {
+        states.setDisplayGrid(primary.getDisplayGrid());
+        std::vector<DisplayRect> rects(primary.getPrimaryDisplayRects());
+        benchmark::DoNotOptimize(rects.data());
+    }
+    state.counters["displays"] = num_displays;
+}
+BENCHMARK(BM_LayoutComponentPrimaryRects)->RangeMultiplier(2)->Range(kMinDisplays, kMaxDisplays);
+
+// Per-frame geometry cost with the cache against the uncached baseline, with
+// nothing changing between frames
+static void BM_LayoutFrameGeometry(benchmark::State &state)
+{
+    uint num_displays(state.range(0));
+    bool cached(state.range(1) != 0);
+
+    DisplayManager displays;
+    addDisplays(displays, num_displays);
+    BenchLayout layout(displays);
+    layout.getDisplayStates().setNumDisplaysForRole(-1, LayoutDisplayRole::Primary);
+    layout.updateFrameGeometry(cached);
+
+    for (auto _ : state) {
+        layout.updateFrameGeometry(cached);
+    }
+    state.counters["displays"] = num_displays;
+}
+BENCHMARK(BM_LayoutFrameGeometry)->ArgsProduct({benchmark::CreateRange(kMinDisplays, kMaxDisplays, 2), {0, 1}})
+        ->ArgNames({"displays", "cached"});
+
+
+// --- DisplayManager ---
+
+static void BM_DisplayManagerLookupById(benchmark::State &state)
+{
+    uint num_displays(state.range(0));
+
+    DisplayManager displays;
+    addDisplays(displays, num_displays);
+    std::vector<uint> ids;
+    for (uint i(0); i < num_displays; ++i) {
+        ids.push_back(displays.getDisplayId(i));
+    }
+
+    uint ix(0);
+    for (auto _ : state) {
+        const DisplayInfo &info(displays.getDisplayInfoById(ids[ix]));
+        benchmark::DoNotOptimize(&info);
+        benchmark::DoNotOptimize(displays.getDisplayExternalNameById(ids[ix]).size());
+        ix = (ix + 1) % num_displays;
+    }
+    state.counters["displays"] = num_displays;
+}
+BENCHMARK(BM_DisplayManagerLookupById)->RangeMultiplier(2)->Range(kMinDisplays, kMaxDisplays);
+
+// Collision messages and commands name displays that may not exist
+static void BM_DisplayManagerIsValidId(benchmark::State &state)
+{
+    uint num_displays(state.range(0));
+
+    DisplayManager displays;
+    addDisplays(displays, num_displays);
+    uint first_id(displays.getDisplayId(0));
+
+    uint id(0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(displays.isValidId(first_id + id));
+        id = (id + 7) % (2 * num_displays);
+    }
+    state.counters["displays"] = num_displays;
+}
+BENCHMARK(BM_DisplayManagerIsValidId)->RangeMultiplier(2)->Range(kMinDisplays, kMaxDisplays);
+
+} // viewpoint_interface
+
+
+// --- Scoreboard ---
+
+// A burst of messages that have already timed out, expired by the next draw
+// while the live messages stay up
+static void BM_ScoreboardExpiry(benchmark::State &state)
+{
+    uint num_live(state.range(0)), num_expired(state.range(1));
+
+    Scoreboard scoreboard;
+    for (uint i(0); i < num_live; ++i) {
+        scoreboard.addEventMessage("live " + std::to_string(i), 1, 3600);
+    }
+
+    for (auto _ : state) {
+        for (uint i(0); i < num_expired; ++i) {
+            scoreboard.addEventMessage("expired", -1, 0);
+        }
+
+        ImGui::NewFrame();
+        scoreboard.draw();
+        ImGui::EndFrame();
+    }
+    state.counters["live"] = num_live;
+    state.counters["expired_per_frame"] = num_expired;
+}
+BENCHMARK(BM_ScoreboardExpiry)->ArgsProduct({{0, 8, 64}, {1, 8}});
+
+static void BM_ScoreboardNextExpiration(benchmark::State &state)
+{
+    uint num_live(state.range(0));
+
+    Scoreboard scoreboard;
+    for (uint i(0); i < num_live; ++i) {
+        scoreboard.addEventMessage("live " + std::to_string(i), 1, 3600);
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(scoreboard.getNextExpirationMs());
+    }
+    state.counters["live"] = num_live;
+}
+BENCHMARK(BM_ScoreboardNextExpiration)->Arg(0)->Arg(8)->Arg(64);
+
+
+int main(int argc, char **argv)
+{
+    // JSON unless asked otherwise, so results can be compared across releases
+    std::vector<char*> args(argv, argv + argc);
+    bool has_format(false);
+    for (int i(1); i < argc; ++i) {
+        has_format |= strncmp(argv[i], "--benchmark_format", strlen("--benchmark_format")) == 0;
+    }
+    char json_format[] = "--benchmark_format=json";
+    if (!has_format) {
+        args.push_back(json_format);
+    }
+    int num_args(args.size());
+
+    benchmark::Initialize(&num_args, args.data());
+    if (benchmark::ReportUnrecognizedArguments(num_args, args.data())) {
+        return 1;
+    }
+
+    // The scoreboard draws through ImGui, which needs a context and a font
+    // atlas but no renderer
+    ImGui::CreateContext();
+    ImGuiIO &io(ImGui::GetIO());
+    io.DisplaySize = ImVec2(1920.0f, 1080.0f);
+    io.DeltaTime = 1.0f / 60.0f;
+    unsigned char *pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+    benchmark::RunSpecifiedBenchmarks();
+    ImGui::DestroyContext();
+
+    return 0;
+}
@@ -3,6 +3,9 @@
 
 #include <string>
 #include <vector>
+#include <atomic>
+#include <chrono>
+#include <limits>
 
 #include <opencv2/opencv.hpp>
 
@@ -33,10 +36,14 @@ namespace viewpoint_interface
         DisplayDims dimensions;
         std::string internal, external, topic;
         uint id;
+        // Written by the image callback and read by the render thread, hence atomic
+        std::atomic<float> frame_rate; // Smoothed rate at which images arrive, 0 until two have arrived
+        std::atomic<int64_t> last_frame_ns; // steady_clock time of the last image, 0 until one arrives
+        std::atomic<uint64_t> num_frames; // Images received so far
 
         DisplayInfo(std::string &int_name, std::string &ext_name, std::string &topic_name,
                 DisplayDims dims) : internal(int_name), external(ext_name), topic(topic_name),
-                dimensions(dims), matrix(12, 0.0)
+                dimensions(dims), matrix(12, 0.0), frame_rate(0.0f), last_frame_ns(0), num_frames(0)
         {
             data.resize(dimensions.size());
 
@@ -45,6 +52,26 @@ namespace viewpoint_interface
             matrix[5] = 1.0;
             matrix[10] = 1.0;       
         }
+
+        DisplayInfo(const DisplayInfo &other) : data(other.data), matrix(other.matrix),
+                dimensions(other.dimensions), internal(other.internal), external(other.external),
+                topic(other.topic), id(other.id), frame_rate(other.frame_rate.load()),
+                last_frame_ns(other.last_frame_ns.load()), num_frames(other.num_frames.load()) {}
+
+        DisplayInfo& operator=(const DisplayInfo &other)
+        {
+            data = other.data;
+            matrix = other.matrix;
+            dimensions = other.dimensions;
+            internal = other.internal;
+            external = other.external;
+            topic = other.topic;
+            id = other.id;
+            frame_rate = other.frame_rate.load();
+            last_frame_ns = other.last_frame_ns.load();
+            num_frames = other.num_frames.load();
+            return *this;
+        }
     };
 
 
@@ -59,9 +86,9 @@ namespace viewpoint_interface
         }
 
         inline uint getId() const { return info.id; }
-        inline std::string getInternalName() const { return info.internal; }
-        inline std::string getExternalName() const { return info.external; }
-        inline std::string getTopicName() const { return info.topic; }
+        inline const std::string& getInternalName() const { return info.internal; }
+        inline const std::string& getExternalName() const { return info.external; }
+        inline const std::string& getTopicName() const { return info.topic; }
         inline std::vector<uchar>& getData() { return info.data; }
         inline const std::vector<float>& getMatrix() const { return info.matrix; }
         inline const DisplayInfo& getDisplayInfo() const { return info; }
@@ -78,6 +105,17 @@ namespace viewpoint_interface
         void copyImage(const cv::Mat &image)
         {
             info.data.assign(image.data, image.data + image.total()*image.channels());
+
+            int64_t now_ns(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+            int64_t last_ns(info.last_frame_ns.load());
+            if (last_ns != 0 && now_ns > last_ns) {
+                float rate(1e9f / (now_ns - last_ns));
+                float smoothed(info.frame_rate.load());
+                info.frame_rate = (smoothed == 0.0f) ? rate : (0.9f * smoothed) + (0.1f * rate);
+            }
+            info.last_frame_ns = now_ns;
+            ++info.num_frames;
         }
 
         void copyMatrix(const std::vector<float> &matrix)
@@ -92,7 +130,10 @@ namespace viewpoint_interface
     class DisplayManager
     {
     public:
-        DisplayManager() : num_active_displays(0) {}
+        // Returned by getDisplayIxById() for ids that don't belong to any display
+        static const uint kInvalidIx = std::numeric_limits<uint>::max();
+
+        DisplayManager() : num_active_displays(0), id_base(0) {}
 
         void addDisplay(const Display &disp)
         {
@@ -100,6 +141,21 @@ namespace viewpoint_interface
 
             displays.push_back(disp);
             num_active_displays++;
+
+            // Copies of kInvalidIx below, as it has no definition to bind to
+            if (ix_by_id.empty()) {
+                id_base = disp.getId();
+            }
+            else if (disp.getId() < id_base) {
+                ix_by_id.insert(ix_by_id.begin(), id_base - disp.getId(), uint(kInvalidIx));
+                id_base = disp.getId();
+            }
+
+            uint slot(disp.getId() - id_base);
+            if (slot >= ix_by_id.size()) {
+                ix_by_id.resize(slot + 1, uint(kInvalidIx));
+            }
+            ix_by_id[slot] = ix;
         }
 
         uint getDisplayId(uint ix) const
@@ -107,17 +163,17 @@ namespace viewpoint_interface
             return displays[ix].getId();
         }
 
-        std::string getDisplayExternalName(uint ix) const 
+        const std::string& getDisplayExternalName(uint ix) const 
         { 
             return displays[ix].getExternalName(); 
         }
 
-        std::string getDisplayInternalName(uint ix) const 
+        const std::string& getDisplayInternalName(uint ix) const 
         { 
             return displays[ix].getInternalName(); 
         }
 
-        std::string getDisplayTopicName(uint ix) const 
+        const std::string& getDisplayTopicName(uint ix) const 
         { 
             return displays[ix].getTopicName(); 
         }
@@ -137,17 +193,17 @@ namespace viewpoint_interface
             return displays[ix].getDisplayInfo(); 
         }
 
-        std::string getDisplayExternalNameById(uint id) const 
+        const std::string& getDisplayExternalNameById(uint id) const 
         { 
             return displays.at(getDisplayIxById(id)).getExternalName(); 
         }
 
-        std::string getDisplayInternalNameById(uint id) const 
+        const std::string& getDisplayInternalNameById(uint id) const 
         { 
             return displays.at(getDisplayIxById(id)).getInternalName(); 
         }
 
-        std::string getDisplayTopicNameById(uint id) const 
+        const std::string& getDisplayTopicNameById(uint id) const 
         { 
             return displays.at(getDisplayIxById(id)).getTopicName(); 
         }
@@ -171,39 +227,46 @@ namespace viewpoint_interface
 
         uint getNumTotalDisplays() const { return displays.size(); }
 
+        // Returns kInvalidIx for unknown ids, which the ...ById() getters reject with std::out_of_range
         uint getDisplayIxById(uint id) const
         {
-            for (int i = 0; i < displays.size(); i++) {
-                if (displays[i].getId() == id) {
-                    return i;
-                }
-            }
-
-            return 0;
+            return (id >= id_base && id - id_base < ix_by_id.size()) ? ix_by_id[id - id_base] : kInvalidIx;
         }
 
+        bool isValidId(uint id) const { return getDisplayIxById(id) != kInvalidIx; }
+
         void swapDisplays(uint ix1, uint ix2)
         {
             std::vector<Display> &vec(displays);
             std::iter_swap(vec.begin() + ix1, vec.begin() + ix2);
+            std::swap(ix_by_id[vec[ix1].getId() - id_base], ix_by_id[vec[ix2].getId() - id_base]);
         }
 
         void copyImageToDisplay(uint id, const cv::Mat& image)
         {
             uint ix(getDisplayIxById(id));
-            displays[ix].copyImage(image);
+            if (ix != kInvalidIx) {
+                displays[ix].copyImage(image);
+            }
         }
 
         void copyMatrixToDisplay(uint id, const std::vector<float>& matrix)
         {
             uint ix(getDisplayIxById(id));
-            displays[ix].copyMatrix(matrix); 
+            if (ix != kInvalidIx) {
+                displays[ix].copyMatrix(matrix); 
+            }
         }
 
 
     private:       
         uint num_active_displays;
         std::vector<Display> displays;
+        // Indexed by id - id_base. Ids come from one counter shared by every
+        // Display (starting at 100), so a manager's ids are close together but
+        // don't start at zero.
+        std::vector<uint> ix_by_id;
+        uint id_base;
 
 
         uint nextIx(uint ix, uint size) const
@@ -0,0 +1,71 @@
+#ifndef __DISPLAY_COMPOSITOR_HPP__
+#define __DISPLAY_COMPOSITOR_HPP__
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "viewpoint_interface/layout.hpp"
+
+class Shader;
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Draws every camera image for a frame in a single instanced draw call,
+ * underneath the ImGui UI.
+ *
+ * Each display owns one layer of a GL_TEXTURE_2D_ARRAY sized to the largest
+ * display, so drawing never switches textures. Layouts describe where images
+ * go with DisplayQuads; titles and borders are left to ImGui's background
+ * draw list, which is rendered on top of the compositor.
+ */
+class DisplayCompositor
+{
+public:
+    DisplayCompositor();
+    ~DisplayCompositor();
+
+    DisplayCompositor(const DisplayCompositor&) = delete;
+    DisplayCompositor& operator=(const DisplayCompositor&) = delete;
+
+    /**
+     * Must be called with the GL context current. Returns false if the displays
+     * don't fit a texture array or the compositor shader doesn't link, in which
+     * case displays are drawn individually.
+     *
+     * Params:
+     *      displays - all displays that may be drawn, one layer is reserved for each
+     */
+    bool init(const DisplayManager &displays);
+    void destroy();
+    bool isInitialized() const { return texture_array_ != 0; }
+
+    // Returns false if the display has no layer or doesn't fit in one
+    bool uploadDisplay(uint display_id, uint width, uint height, const uchar *data);
+    void draw(const std::vector<DisplayQuad> &quads, float viewport_width, float viewport_height);
+
+    uint getNumQuadsDrawn() const { return num_quads_drawn_; }
+
+private:
+    struct Layer
+    {
+        uint index;
+        float u_max, v_max; // Part of the layer covered by the display's image
+    };
+
+    std::unique_ptr<Shader> shader_;
+    int viewport_size_loc_;
+    uint texture_array_, vao_, instance_vbo_;
+    uint layer_width_, layer_height_;
+    uint64_t texture_bytes_;
+    std::map<uint, Layer> layers_; // Keyed by display ID
+    std::vector<float> instance_data_;
+    uint num_quads_drawn_;
+};
+
+} // viewpoint_interface
+
+#endif // __DISPLAY_COMPOSITOR_HPP__
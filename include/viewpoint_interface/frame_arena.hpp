@@ -0,0 +1,89 @@
+#ifndef __FRAME_ARENA_HPP__
+#define __FRAME_ARENA_HPP__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Bump allocator for temporaries that only live for one frame (state lists,
+ * label strings). Allocating is a pointer increment, freeing is a no-op, and
+ * everything is released at once by reset() at the start of the next frame.
+ *
+ * When the buffer runs out, allocations fall back to the heap and are freed
+ * on reset; the overflow count shows when the capacity should be raised.
+ *
+ * Not thread-safe: the arena returned by getFrameArena() belongs to the
+ * render thread.
+ */
+class FrameArena
+{
+public:
+    static const size_t kDefaultCapacity = 64 * 1024;
+
+    explicit FrameArena(size_t capacity=kDefaultCapacity);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment);
+    void reset();
+
+    size_t getCapacity() const { return capacity_; }
+    size_t getBytesUsed() const { return offset_; }
+    size_t getPeakBytes() const { return peak_; }
+    uint64_t getNumOverflows() const { return num_overflows_; }
+
+private:
+    std::unique_ptr<char[]> buffer_;
+    size_t capacity_, offset_, peak_;
+    std::vector<void*> overflow_blocks_;
+    uint64_t num_overflows_;
+};
+
+FrameArena& getFrameArena();
+
+// Number of times operator new has been called on the calling thread
+uint64_t getThreadHeapAllocations();
+
+
+template <typename T>
+class FrameAllocator
+{
+public:
+    typedef T value_type;
+
+    FrameAllocator() : arena_(&getFrameArena()) {}
+    explicit FrameAllocator(FrameArena &arena) : arena_(&arena) {}
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U> &other) : arena_(other.arena_) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const FrameAllocator<U> &other) const { return arena_ == other.arena_; }
+    template <typename U>
+    bool operator!=(const FrameAllocator<U> &other) const { return arena_ != other.arena_; }
+
+private:
+    FrameArena *arena_;
+
+    template <typename U> friend class FrameAllocator;
+};
+
+typedef std::basic_string<char, std::char_traits<char>, FrameAllocator<char>> FrameString;
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+} // viewpoint_interface
+
+#endif // __FRAME_ARENA_HPP__
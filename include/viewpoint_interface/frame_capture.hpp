@@ -0,0 +1,68 @@
+#ifndef __FRAME_CAPTURE_HPP__
+#define __FRAME_CAPTURE_HPP__
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <sys/types.h>
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Asynchronous readback of the composited framebuffer. Each capture blits the
+ * bound draw framebuffer into a small FBO of the output size (scaling and
+ * flipping it to top-down row order), then starts a glReadPixels into one of
+ * a ring of pixel pack buffers guarded by a fence. Finished readbacks are
+ * handed out by collect() once their fence has signaled, so neither call
+ * waits on the GPU. If every buffer is still in flight the capture is
+ * dropped instead.
+ *
+ * All functions must be called on the thread that owns the GL context.
+ * Frames are RGBA, 8 bits per channel.
+ */
+class FrameCapture
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::function<void(const uint8_t *data, uint width, uint height, Clock::time_point stamp)> FrameHandler;
+
+    static const uint kChannels = 4;
+
+    FrameCapture() : fbo_(0), color_rbo_(0), width_(0), height_(0), next_slot_(0), oldest_slot_(0),
+            num_dropped_(0) {}
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    bool init(uint width, uint height, uint ring_size=3);
+    void destroy();
+    bool isInitialized() const { return fbo_ != 0; }
+
+    bool capture(int src_width, int src_height, Clock::time_point stamp);
+    void collect(const FrameHandler &handler);
+
+    uint getWidth() const { return width_; }
+    uint getHeight() const { return height_; }
+    uint64_t getNumDropped() const { return num_dropped_; }
+
+private:
+    struct Slot
+    {
+        uint pbo;
+        void *fence; // GLsync
+        Clock::time_point stamp;
+    };
+
+    uint fbo_, color_rbo_;
+    uint width_, height_;
+    std::vector<Slot> slots_;
+    uint next_slot_, oldest_slot_;
+    uint64_t num_dropped_;
+};
+
+} // viewpoint_interface
+
+#endif // __FRAME_CAPTURE_HPP__
@@ -0,0 +1,69 @@
+#ifndef __FRAME_MARKER_HPP__
+#define __FRAME_MARKER_HPP__
+
+#include <cstdint>
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Sequence number stamped into the pixels of synthetic camera images, so the
+ * viewer can check end to end that frames arrive in order and count the ones
+ * lost on the way.
+ *
+ * The marker is the first kFrameMarkerPixels pixels of the top row: 16 pixels
+ * of a fixed pattern followed by the 64-bit sequence number, most significant
+ * bit first. Each bit sets every byte of its pixel to 0 or 0xFF, so the marker
+ * reads back the same for any encoding, channel order or bit depth.
+ */
+static const uint16_t kFrameMarkerMagic = 0xA5C3;
+static const uint kFrameMarkerPixels = 16 + 64;
+
+// Returns false if the row is too narrow to hold the marker
+inline bool writeFrameMarker(uint8_t *row, uint width, uint bytes_per_pixel, uint64_t seq)
+{
+    if (width < kFrameMarkerPixels || bytes_per_pixel == 0) {
+        return false;
+    }
+
+    for (uint i(0); i < kFrameMarkerPixels; ++i) {
+        bool bit(i < 16 ? (kFrameMarkerMagic >> (15 - i)) & 1 : (seq >> (63 - (i - 16))) & 1);
+        for (uint b(0); b < bytes_per_pixel; ++b) {
+            row[(i * bytes_per_pixel) + b] = bit ? 0xFF : 0x00;
+        }
+    }
+
+    return true;
+}
+
+// Returns false if the row doesn't start with a marker
+inline bool readFrameMarker(const uint8_t *row, uint width, uint bytes_per_pixel, uint64_t &seq)
+{
+    if (width < kFrameMarkerPixels || bytes_per_pixel == 0) {
+        return false;
+    }
+
+    uint16_t magic(0);
+    uint64_t value(0);
+    for (uint i(0); i < kFrameMarkerPixels; ++i) {
+        bool bit(row[i * bytes_per_pixel] >= 0x80);
+        if (i < 16) {
+            magic = (magic << 1) | bit;
+        }
+        else {
+            value = (value << 1) | bit;
+        }
+    }
+
+    if (magic != kFrameMarkerMagic) {
+        return false;
+    }
+
+    seq = value;
+    return true;
+}
+
+} // viewpoint_interface
+
+#endif // __FRAME_MARKER_HPP__
@@ -0,0 +1,121 @@
+#ifndef __FRAME_PACER_HPP__
+#define __FRAME_PACER_HPP__
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Decides when the main loop starts building a frame and keeps statistics on
+ * how well frames meet their deadlines.
+ *
+ * Modes:
+ *      Fixed - sleep to a fixed loop rate, with vsync off
+ *      VSync - swap on vsync, and delay input polling/image selection so the
+ *          frame is built as late as possible before the next vblank
+ *      Adaptive - pace to the fastest camera currently visible
+ *      Uncapped - no waiting and no vsync, for benchmarking
+ *      OnDemand - swap on vsync, but only draw when something has changed. The
+ *          app idles in between and is woken through requestRedraw()
+ */
+class FramePacer
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum class Mode
+    {
+        Fixed,
+        VSync,
+        Adaptive,
+        Uncapped,
+        OnDemand
+    };
+
+    struct Stats
+    {
+        float mean_ms, std_dev_ms, max_ms;
+        uint missed_in_window;
+        uint64_t missed_total;
+    };
+
+    FramePacer(Mode mode=Mode::VSync, float fixed_rate=60.0f) : mode_(mode), fixed_rate_(fixed_rate),
+            refresh_rate_(60.0f), camera_rate_(0.0f), work_ema_ms_(0.0f), first_frame_(true),
+            swap_interval_dirty_(true), on_demand_available_(true), idle_(false), redraw_requested_(true),
+            settle_frames_(0),
+            redraw_rate_(0.0f), rate_frames_(0), missed_total_(0), next_sample_(0) {}
+
+    static bool stringToMode(const std::string &name, Mode &mode);
+    static const char* modeToString(Mode mode);
+
+    Mode getMode() const { return mode_; }
+    // Ignores OnDemand while it isn't available
+    void setMode(Mode mode);
+    // OnDemand waits on window events, so it isn't available headless
+    void setOnDemandAvailable(bool available) { on_demand_available_ = available; }
+    bool isOnDemandAvailable() const { return on_demand_available_; }
+    void setFixedRate(float hz) { fixed_rate_ = hz; }
+    void setRefreshRate(float hz);
+    void setCameraRate(float hz) { camera_rate_ = hz; }
+    int getSwapInterval() const;
+    bool consumeSwapIntervalChange(int &interval);
+
+    void waitForFrameStart();
+    // Starts the frame's work timer again, after the app idled waiting for a redraw
+    void restartFrame() { frame_start_ = Clock::now(); }
+    // Call once the frame is rendered, just before the swap, which may block on vblank
+    void frameRendered();
+    void frameSwapped();
+
+    // On-demand drawing
+    bool requestRedraw();
+    void markChanged() { settle_frames_ = kSettleFrames; }
+    bool needsRedraw();
+    void setIdle(bool idle) { idle_ = idle; }
+
+    float getTargetRate() const;
+    float getWorkTimeMs() const { return work_ema_ms_; } // Smoothed CPU time to build and render a frame, before the swap
+    Stats getStats() const;
+    void drawPanel();
+
+private:
+    static const uint kWindowSize = 240;
+    static constexpr float kLatchMarginMs = 1.5f; // Slack left before vblank in VSync mode
+    static constexpr float kMissFactor = 1.5f; // Frames longer than this many periods missed their deadline
+    static constexpr float kMinAdaptiveRate = 15.0f;
+    static const uint kSettleFrames = 3; // Extra frames drawn after a change so ImGui state can catch up
+
+    std::atomic<Mode> mode_;
+    float fixed_rate_;
+    float refresh_rate_;
+    float camera_rate_;
+    float work_ema_ms_;
+    bool first_frame_;
+    bool swap_interval_dirty_;
+    bool on_demand_available_;
+    Clock::time_point frame_start_;
+    Clock::time_point last_swap_;
+
+    std::atomic<bool> idle_;
+    std::atomic<bool> redraw_requested_;
+    uint settle_frames_;
+
+    float redraw_rate_;
+    uint rate_frames_;
+    Clock::time_point rate_start_;
+
+    std::vector<float> frame_times_ms_;
+    std::vector<bool> missed_;
+    uint64_t missed_total_;
+    uint next_sample_;
+};
+
+} // viewpoint_interface
+
+#endif // __FRAME_PACER_HPP__
@@ -0,0 +1,98 @@
+#ifndef __GPU_TIMER_HPP__
+#define __GPU_TIMER_HPP__
+
+#include <map>
+#include <cstdint>
+#include <cstring>
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * GPU time taken by stages of the frame, measured with GL_TIME_ELAPSED queries.
+ *
+ * Wrap the GL calls of a stage in a GpuZone. Query results are read
+ * kFrameLatency frames after they were issued, and only if the GPU has
+ * finished with them, so reading them never stalls the render thread. A
+ * result that still isn't ready by then is dropped.
+ *
+ * Elapsed-time queries can't nest, so zones must not overlap. Stages take
+ * the names of the CPU profiler zones they match, and are only timed while
+ * the profiler is enabled or setAlwaysOn() asked for them.
+ */
+class GpuTimer
+{
+public:
+    static const uint kFrameLatency = 4;
+    static const uint kMaxQueriesPerFrame = 16;
+
+    GpuTimer() : initialized_(false), enabled_(false), always_on_(false), next_frame_(0), active_(NULL),
+            frame_total_ms_(0.0f), frame_mean_ms_(0.0f), num_late_(0), num_overflows_(0) {}
+
+    // Must be called with the GL context current
+    void destroy();
+
+    // Time stages even while the profiler is off. Takes effect from the next frameMark()
+    void setAlwaysOn(bool always_on) { always_on_ = always_on; }
+
+    // Call once per frame from the render thread, before any zones
+    void frameMark();
+    // Don't call directly, use GpuZone
+    void begin(const char *stage);
+    void end();
+
+    // Returns false if the stage hasn't been timed yet
+    bool getStageMs(const char *stage, float &mean_ms) const;
+    // Smoothed GPU time of all stages in a frame. Returns false while stages aren't timed
+    bool getFrameMs(float &mean_ms) const;
+    void drawPanel();
+
+private:
+    struct FrameQueries
+    {
+        uint ids[kMaxQueriesPerFrame];
+        const char *stages[kMaxQueriesPerFrame];
+        uint num_issued;
+    };
+
+    struct StageStats
+    {
+        float last_ms, mean_ms, max_ms;
+        float frame_ms; // Accumulates while a frame's results are read
+        bool in_frame;
+    };
+
+    struct NameLess
+    {
+        bool operator()(const char *a, const char *b) const { return strcmp(a, b) < 0; }
+    };
+
+    bool initialized_, enabled_, always_on_;
+    FrameQueries frames_[kFrameLatency];
+    uint next_frame_;
+    const char *active_;
+    std::map<const char*, StageStats, NameLess> stages_;
+    float frame_total_ms_, frame_mean_ms_;
+    uint64_t num_late_, num_overflows_;
+
+    void readFrame(FrameQueries &frame);
+};
+
+
+class GpuZone
+{
+public:
+    GpuZone(GpuTimer &timer, const char *stage) : timer_(timer) { timer_.begin(stage); }
+    ~GpuZone() { timer_.end(); }
+
+    GpuZone(const GpuZone&) = delete;
+    GpuZone& operator=(const GpuZone&) = delete;
+
+private:
+    GpuTimer &timer_;
+};
+
+} // viewpoint_interface
+
+#endif // __GPU_TIMER_HPP__
@@ -3,7 +3,6 @@
 
 #include <string>
 #include <iostream>
-#include <chrono> // TEST
 
 
 /**
@@ -37,18 +36,4 @@ void printText(std::string text, int newlines, bool flush)
 }
 
 
-// TEST
-auto start = std::chrono::high_resolution_clock::now();
-void startTiming()
-{
-    start = std::chrono::high_resolution_clock::now();
-}
-
-void stopTiming()
-{
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-    std::cout << "Time: " << duration.count() << std::endl;
-}
-
 #endif // __HELPERS_HPP__
\ No newline at end of file
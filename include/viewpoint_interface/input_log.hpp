@@ -0,0 +1,79 @@
+#ifndef __INPUT_LOG_HPP__
+#define __INPUT_LOG_HPP__
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <cstdint>
+
+
+namespace viewpoint_interface
+{
+
+// To record a new kind of input follow the following steps:
+// - Add an entry to the end of InputEventType (existing values are stored in
+// log files, so they must not be reordered)
+// - Record it from its callback through App::handleInputEvent()
+// - Apply it in App::dispatchInputEvent()
+enum class InputEventType : uint8_t
+{
+    ControllerPacket,
+    ManualCommand,
+    ActiveDisplay,
+    Grasping,
+    Clutching,
+    Collision
+};
+
+struct InputEvent
+{
+    InputEventType type;
+    int64_t time_ns; // Time since the start of the recording
+    uint64_t frame; // Render loop frames started before the input was applied
+    std::string payload;
+};
+
+
+/**
+ * Writes externally driven inputs to a compact binary log. The file begins
+ * with a magic string and version, followed by one record per event:
+ *
+ *      uint8 type | int64 time_ns | uint64 frame | uint32 payload size | payload bytes
+ *
+ * All values are stored in host byte order. The frame lets a replay apply
+ * each input before the same frame it reached when it was recorded.
+ *
+ * Not thread safe. App queues inputs from the socket and spinner threads and
+ * records them on the render thread as it applies them.
+ */
+class InputRecorder
+{
+public:
+    InputRecorder() : recording_(false) {}
+    ~InputRecorder() { close(); }
+
+    bool open(const std::string &path);
+    void close();
+    bool isRecording() const { return recording_; }
+    void record(InputEventType type, uint64_t frame, const std::string &payload);
+
+private:
+    std::ofstream file_;
+    bool recording_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+
+/**
+ * Reads a log written by InputRecorder. Logs with an unknown input type, a
+ * payload of the wrong size for its type or a truncated record are rejected,
+ * as replaying only part of a session wouldn't reproduce it.
+ *
+ * Returns: false with a description in error if the log can't be replayed
+ */
+bool loadInputLog(const std::string &path, std::vector<InputEvent> &events, std::string &error);
+
+} // viewpoint_interface
+
+#endif // __INPUT_LOG_HPP__
@@ -0,0 +1,80 @@
+#ifndef __LATENCY_TRACKER_HPP__
+#define __LATENCY_TRACKER_HPP__
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Measures input-to-photon latency for commands. Each command carries the
+ * time at which it arrived (socket read, ROS callback or key press). Once a
+ * command has been applied it is latched into the next frame that starts
+ * building, and its latency is recorded when that frame is swapped.
+ */
+class LatencyTracker
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef Clock::time_point TimePoint;
+
+    enum class CommandSource
+    {
+        Controller,
+        Manual,
+        Keyboard
+    };
+
+    struct Sample
+    {
+        CommandSource source;
+        std::string command;
+        double latency_ms;
+    };
+
+    struct Summary
+    {
+        uint count;
+        double mean_ms, p50_ms, p95_ms, p99_ms, max_ms;
+    };
+
+    LatencyTracker(uint window_size=2048) : window_size_(window_size), next_sample_(0) {}
+
+    static TimePoint now() { return Clock::now(); }
+
+    void commandApplied(const std::string &command, TimePoint stamp, CommandSource source);
+    void frameStarted();
+    void frameSwapped();
+
+    Summary getSummary() const;
+    bool exportCsv(const std::string &path) const;
+    void drawPanel(const std::string &csv_path);
+
+private:
+    struct PendingCommand
+    {
+        std::string command;
+        TimePoint stamp;
+        CommandSource source;
+    };
+
+    static const uint kNumBins = 50;
+    static constexpr float kBinWidthMs = 2.0f; // Last bin collects everything above the range
+
+    mutable std::mutex mutex_;
+    std::vector<PendingCommand> pending_;
+    std::vector<PendingCommand> in_flight_;
+    std::vector<Sample> samples_; // Rolling window, oldest sample at next_sample_ once full
+    uint window_size_;
+    uint next_sample_;
+
+    std::vector<Sample> getOrderedSamples() const;
+};
+
+} // viewpoint_interface
+
+#endif // __LATENCY_TRACKER_HPP__
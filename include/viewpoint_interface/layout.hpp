@@ -5,6 +5,7 @@
 #include <list>
 #include <string>
 #include <memory>
+#include <limits>
 #include <algorithm>
 
 #include <glm/vec2.hpp>
@@ -13,6 +14,7 @@
 
 #include "display.hpp"
 #include "layout_component.hpp"
+#include "frame_arena.hpp"
 #include "timer.hpp"
 #include "scoreboard.hpp"
 
@@ -22,10 +24,10 @@ namespace viewpoint_interface
 
 class LayoutManager;
 
-static bool startMenu(std::string title, ImGuiWindowFlags window_flags)
+static bool startMenu(const char *title, ImGuiWindowFlags window_flags)
 {
 
-    if (!ImGui::Begin(title.c_str(), (bool *)NULL, window_flags)) {
+    if (!ImGui::Begin(title, (bool *)NULL, window_flags)) {
         ImGui::End();
         return false;    
     }
@@ -41,6 +43,10 @@ static void endMenu()
 }
 
 
+// Layouts that only arrange existing components can be described in
+// resources/config/layout_config.json instead (see layout_config.hpp), which
+// is reloaded while the interface runs.
+//
 // To add/change layouts follow the following steps:
 // - Add/change enum entry in LayoutType for layout
 // - Edit num_layout_types and layout_names in Layout class (making sure that
@@ -60,7 +66,8 @@ enum LayoutType
     SPLIT,
     TWINNED,
     GRID,
-    CAROUSEL
+    CAROUSEL,
+    CONFIGURED // Layouts from layout_config.json take this value and up, in the order they were first loaded
 };
 
 enum LayoutCommand
@@ -80,7 +87,9 @@ enum LayoutCommand
     ACTIVE_FRAME_UP_RIGHT,
     ACTIVE_FRAME_UP_LEFT,
     ACTIVE_FRAME_DOWN_RIGHT,
-    ACTIVE_FRAME_DOWN_LEFT
+    ACTIVE_FRAME_DOWN_LEFT,
+    PAGE_NEXT,
+    PAGE_PREV
 };
 
 enum class LayoutDisplayRole
@@ -89,21 +98,38 @@ enum class LayoutDisplayRole
     Secondary
 };
 
+// Order in which full-size image uploads are served when the per-frame upload
+// budget runs short. Lower values go first.
+enum class UploadPriority
+{
+    ActiveFrame,
+    Primary,
+    Secondary
+};
+
+
+// Labeled on/off states shown in the corner of a layout, in display order. A
+// label of the form "Name#on_off" shows the given words instead of ACTIVE/INACTIVE
+typedef FrameVector<std::pair<const char*, bool>> StateList;
+
 
 struct DisplayImageRequest
 {
 public:
-    DisplayImageRequest(uint w, uint h, std::vector<uchar> &data, uint id) :
-            width_(w), height_(h), data_(data), disp_id_(id) {}
+    DisplayImageRequest(uint w, uint h, std::vector<uchar> &data, uint id,
+            UploadPriority priority=UploadPriority::Primary) :
+            width_(w), height_(h), data_(data), disp_id_(id), priority_(priority) {}
 
     uint getWidth() const { return width_; }
     uint getHeight() const { return height_; }
     uint getDisplayId() const { return disp_id_; }
+    UploadPriority getPriority() const { return priority_; }
     std::vector<uchar>& getDataVector() { return data_; }
 
 private:
     std::vector<uchar> &data_;
     uint width_, height_, disp_id_;
+    UploadPriority priority_;
 };
 
 struct DisplayImageResponse
@@ -118,13 +144,20 @@ private:
     uint gl_id_, disp_id_;
 };
 
+// Screen-space rectangle a display's image is drawn into by the DisplayCompositor
+struct DisplayQuad
+{
+    uint display_id;
+    ImVec2 pos, size;
+};
+
     
 class Layout
 {
 public:
     LayoutType getLayoutType() const { return layout_type_; } 
-    const std::vector<std::string> getLayoutList() const { return kLayoutNames; }
-    const std::string getLayoutName() const;
+    const std::vector<std::string>& getLayoutList() const { return kLayoutNames; }
+    virtual const std::string& getLayoutName() const;
 
     // TODO: Make these private and make LayoutManager friend class
     static LayoutType intToLayoutType(int ix) {
@@ -139,14 +172,58 @@ public:
     void setClutchingState(bool state) { clutching_ = state; }
     void setActiveFrame(uint index);
     const std::vector<float>& getActiveDisplayMatrix() const;
-    const std::vector<float> getDisplayBounds() const;
+    const std::vector<float>& getDisplayBounds() const;
     std::vector<DisplayImageRequest>& getImageRequestQueue();
     void pushImageResponse(const DisplayImageResponse &response);
 
+    /**
+     * Displays shown as carousel tiles this frame. Tiles are drawn from small
+     * per-display thumbnail textures, which are refreshed at a lower rate
+     * than full-size images; the queue is emptied by whoever refreshes them.
+     */
+    std::vector<uint>& getThumbnailRequestQueue() { return thumbnail_request_queue_; }
+    void pushThumbnailResponse(const DisplayImageResponse &response) { thumbnail_response_queue_.push_back(response); }
+
+    // For textures that were deleted, so they aren't drawn until a new one arrives
+    void forgetImage(uint display_id);
+    void forgetThumbnail(uint display_id);
+
+    /**
+     * When enabled, layout components don't draw camera images themselves but
+     * leave a DisplayQuad for each one, which the compositor draws in a single
+     * pass. The quads are collected anew every frame.
+     */
+    void setBatchedDisplays(bool batched) { batched_displays_ = batched; }
+    bool getBatchedDisplays() const { return batched_displays_; }
+    const std::vector<DisplayQuad>& getDisplayQuads() const { return display_quads_; }
+    void clearDisplayQuads() { display_quads_.clear(); }
+
+    // Primary displays beyond this many are split into pages (0 disables paging)
+    void setMaxDisplaysPerPage(uint num)
+    {
+        if (num != max_displays_per_page_) {
+            max_displays_per_page_ = num;
+            geometry_dirty_ = true;
+        }
+    }
+
+    // False for displays on a page that isn't shown, whose images can be skipped
+    bool isDisplayVisible(uint id) const { return display_states_.isDisplayOnPage(id); }
+
     virtual void displayLayoutParams() = 0;
     virtual void draw() = 0;
 
-    virtual void handleKeyInput(int key, int action, int mods);
+    // Returns: true if the key applied a command, false if the layout ignored it
+    virtual bool handleKeyInput(int key, int action, int mods);
+
+    /**
+     * Used by on-demand drawing to wake up for time-based changes that no
+     * input or camera image will announce.
+     * 
+     * Returns: milliseconds until the layout next needs to be redrawn, or -1
+     *      if nothing is scheduled.
+     */
+    virtual int64_t getNextDeadlineMs() const;
 
     /**
      * This function is intended to serve as a universal translation table
@@ -161,14 +238,22 @@ public:
      * 
      * Returns: command represented by input string. 
      */
-    const LayoutCommand translateStringInputToCommand(std::string input) const;
-    virtual void handleStringInput(std::string input);
+    static const LayoutCommand translateStringInputToCommand(std::string input);
+    // Returns: true if the string applied a command, false if the layout ignored it
+    virtual bool handleStringInput(std::string input);
     virtual void handleCollisionMessage(const std::string &message);
 
 protected:
     DisplayManager &displays_;
     std::vector<DisplayImageRequest> display_image_queue_;
     std::vector<DisplayImageResponse> image_response_queue_;
+    std::vector<DisplayQuad> display_quads_;
+    // Drawn at full size this frame, so their images are requested
+    std::vector<std::pair<uint, UploadPriority>> full_size_displays_;
+    std::vector<uint> thumbnail_request_queue_;
+    std::vector<DisplayImageResponse> thumbnail_response_queue_;
+    bool batched_displays_;
+    uint max_displays_per_page_;
     Scoreboard scoreboard_;
     
     class DisplayStateCache
@@ -207,7 +292,15 @@ protected:
         bool isPrimaryDisplay(uint id) const;
         bool isSecondaryDisplay(uint id) const;
         bool isDisplayRole(uint id, LayoutDisplayRole role) const;
-        std::vector<uint> getDisplayRoleList(LayoutDisplayRole role) const;
+        /**
+         * Displays with the role, in ring order. The list is an immutable snapshot,
+         * replaced rather than changed when roles change, so it stays valid while
+         * the caller changes roles, as the display selectors do. The ring itself
+         * isn't thread safe; App applies commands from other threads on the
+         * render thread.
+         */
+        typedef std::shared_ptr<const std::vector<uint>> RoleList;
+        RoleList getDisplayRoleList(LayoutDisplayRole role) const;
         uint getNumPrimaryDisplays() const;
         uint getNumSecondaryDisplays() const;
         uint getNumForRole(LayoutDisplayRole role) const;
@@ -220,13 +313,33 @@ protected:
         void toPrevActiveFrame();
         void addImageResponseForId(uint display_id, uint gl_id);
         uint getImageIdForDisplayId(uint id) const;
+        void addThumbnailResponseForId(uint display_id, uint gl_id);
+        uint getThumbnailIdForDisplayId(uint id) const;
+        void removeImageForId(uint display_id) { gl_ids_.erase(display_id); }
+        void removeThumbnailForId(uint display_id) { thumbnail_ids_.erase(display_id); }
+
+        // Changes whenever displays are added, removed, reordered or change roles
+        uint getGeneration() const { return generation_; }
 
     private:
+        enum RoleBit : uint8_t
+        {
+            kPrimaryBit = 1 << 0,
+            kSecondaryBit = 1 << 1
+        };
+
         std::vector<uint> ring_;
-        uint active_frame_; // Active frame points to an index position within ring_
+        std::vector<uint8_t> roles_; // Role bits for the display in the same slot of ring_
+        static const uint kInvalidSlot = std::numeric_limits<uint>::max(); // Ids not in the ring
+
+        // Slot in ring_ of each display, indexed by id - id_base_ (see DisplayManager)
+        std::vector<uint> slot_by_id_;
+        uint id_base_;
+        RoleList primary_list_, secondary_list_;
+        uint generation_;
+        uint active_frame_; // Active frame points to an index position within the primary list
         std::map<uint, uint> gl_ids_; // Stores OpenGL ID for displays in ring
-        std::map<uint, bool> primary_displays_;
-        std::map<uint, bool> secondary_displays_;
+        std::map<uint, uint> thumbnail_ids_;
 
         void setPrimaryDisplay(uint id);
         void setSecondaryDisplay(uint id);
@@ -234,7 +347,13 @@ protected:
         void unsetSecondaryDisplay(uint id);
         uint getNextIdWithoutRole(uint start_id, LayoutDisplayRole role);
         uint getPrevIdWithoutRole(uint start_id, LayoutDisplayRole role);
-        uint getIndexForDisplayId(uint id);
+        uint getIndexForDisplayId(uint id) const;
+        void indexSlots(uint first_ix);
+        static uint8_t getRoleBit(LayoutDisplayRole role);
+        void setRoleBit(uint id, uint8_t bit, bool state);
+        void rolesChanged();
+        void ringChanged(); // Displays were added, removed or reordered
+        bool updateRoleList(RoleList &list, uint8_t bit); // Returns whether the list changed
     };
 
     class LayoutDisplayStates
@@ -275,6 +394,11 @@ protected:
         void toNextActiveFrame();
         void toPrevActiveFrame();
         void handleActiveFrameDirectionInput(LayoutCommand command);
+        void setDisplayGrid(const DisplayGrid &grid) { display_grid_ = grid; }
+        const DisplayGrid& getDisplayGrid() const { return display_grid_; }
+        bool isDisplayOnPage(uint id) const;
+        void toNextPage();
+        void toPrevPage();
         void addImageResponseForId(uint display_id, uint gl_id);
         uint getImageIdForDisplayId(uint id) const;
 
@@ -286,6 +410,7 @@ protected:
         int num_secondary_;
         DisplayStateCache display_cache_;
         DisplayRing display_ring_;
+        DisplayGrid display_grid_;
 
         uint nextIx(uint ix, uint size) const;
         uint prevIx(uint ix, uint size) const;
@@ -301,8 +426,24 @@ protected:
 
 
     std::vector<LayoutComponent> layout_components_;
+    uint num_components_added_; // Components added so far this frame
     std::vector<float> display_bounds_;
 
+    // Geometry is only recomputed when something it depends on changes
+    std::vector<DisplayRect> primary_rects_; // One per primary display, in ring order
+    bool geometry_dirty_;
+    ImVec2 geometry_work_pos_, geometry_work_size_;
+    uint geometry_ring_generation_;
+
+    // Position of the carousel ribbon's view along its length, eased toward
+    // the target every frame so the ribbon scrolls smoothly
+    struct CarouselScroll
+    {
+        float pos, target;
+        uint followed_id; // Display the ribbon last centered on
+    };
+    CarouselScroll carousel_scroll_;
+
     struct ColorSet
     {
         ImVec4 base, hovered, active;
@@ -318,8 +459,10 @@ protected:
 
     std::vector<float> kDummyMatrix;
 
-    Layout(LayoutType type, DisplayManager &disp) : layout_type_(type), displays_(disp), kDummyMatrix(12, 0.0),
-            display_states_(displays_)
+    Layout(LayoutType type, DisplayManager &disp) : displays_(disp), batched_displays_(false),
+            max_displays_per_page_(0), display_states_(displays_), num_components_added_(0),
+            geometry_dirty_(true), geometry_ring_generation_(0), carousel_scroll_(), kDummyMatrix(12, 0.0),
+            layout_type_(type)
     {
         primary_color_.base =    ImVec4{10.0/255, 190.0/255, 10.0/255, 150.0/255};
         primary_color_.hovered = ImVec4{10.0/255, 190.0/255, 10.0/255, 200.0/255}; 
@@ -352,11 +495,19 @@ protected:
     void toNextDisplayWithPush(LayoutDisplayRole role);
     void toPrevDisplayWithPush(LayoutDisplayRole role);
     void addImageRequestToQueue(DisplayImageRequest request);
+    // Default handling for commands shared by all layouts
+    // Returns: false for commands the layout doesn't handle
+    bool handleLayoutCommand(LayoutCommand command);
+    void addDisplayQuad(const DisplayQuad &quad) { display_quads_.push_back(quad); }
+    void addFullSizeDisplay(uint id, UploadPriority priority);
+    void addThumbnailRequest(uint id) { thumbnail_request_queue_.push_back(id); }
     void addLayoutComponent(LayoutComponent::Type type, LayoutComponent::Spacing spacing=LayoutComponent::Spacing::Auto,
         LayoutComponent::Positioning positioning=LayoutComponent::ComponentPositioning_Auto, float width=0.0,
         float height=0.0, ImVec2 offset=ImVec2{-1.0, -1.0});
     void drawLayoutComponents();
-    void displayStateValues(std::map<std::string, bool> states) const;
+    bool isGeometryStale();
+    void updateGeometry(LayoutComponent &primary_window);
+    void displayStateValues(const StateList &states) const;
     void drawDisplaysList(uint keep_active_num=0);
     void drawDisplaySelectors();
     void drawDraggableRing();
@@ -4,6 +4,7 @@
 #include <string>
 #include <cmath>
 #include <vector>
+#include <algorithm>
 
 #include <iostream>
 
@@ -17,6 +18,49 @@ namespace viewpoint_interface
 
 class Layout;
 
+/**
+ * Arrangement of the primary displays into rows and columns. Displays beyond
+ * the page size are split into pages; only the page holding the active frame
+ * is shown, and off-page displays are neither drawn nor uploaded.
+ *
+ * Indices are positions in the list of primary displays.
+ */
+struct DisplayGrid
+{
+    uint rows, cols;
+    uint per_page, page, num_pages;
+    uint page_start, page_size; // Displays [page_start, page_start + page_size) are on the current page
+
+    DisplayGrid() : rows(1), cols(1), per_page(0), page(0), num_pages(1), page_start(0), page_size(0) {}
+
+    /**
+     * Picks the number of rows and columns that gives each display the
+     * largest image.
+     *
+     * Params:
+     *      num_displays - total number of primary displays
+     *      max_per_page - page size, 0 fits every display on one page
+     *      active_ix - index of the active frame, which selects the page
+     *      width, height - size of the area the grid fills
+     *      aspect_ratio - width/height of the displays' images
+     */
+    static DisplayGrid fit(uint num_displays, uint max_per_page, uint active_ix, float width, float height,
+            float aspect_ratio);
+
+    bool isOnPage(uint ix) const { return ix >= page_start && ix < page_start + page_size; }
+    uint getRow(uint ix) const { return (ix - page_start) / cols; }
+    uint getCol(uint ix) const { return (ix - page_start) % cols; }
+    uint getNumInRow(uint row) const { return std::min(cols, page_size - (row * cols)); }
+};
+
+// Cached placement of one primary display, in screen coordinates
+struct DisplayRect
+{
+    uint display_id;
+    ImVec2 pos, size; // Cell occupied by the display, empty if it's on another page
+    ImVec2 image_offset, image_size; // Image centered within the cell
+};
+
 class LayoutComponent
 {
 public:
@@ -62,18 +106,31 @@ public:
 
     LayoutComponent(Layout &layout, Type type, Spacing spacing, Positioning positioning, float width,
             float height, ImVec2 offset) : layout_(layout), type_(type), spacing_(spacing),
-            positioning_(positioning), width_(width), height_(height), offset_(offset)
+            positioning_(positioning), width_(width), height_(height), offset_(offset),
+            requested_spacing_(spacing), requested_positioning_(positioning), requested_width_(width),
+            requested_height_(height), requested_offset_(offset)
     {
         checkParameters();
     }
 
+    // Whether the component was created with these arguments, before checkParameters() adjusted them
+    bool wasCreatedWith(Type type, Spacing spacing, Positioning positioning, float width, float height,
+            ImVec2 offset) const
+    {
+        return type == type_ && spacing == requested_spacing_ && positioning == requested_positioning_ &&
+                width == requested_width_ && height == requested_height_ &&
+                offset.x == requested_offset_.x && offset.y == requested_offset_.y;
+    }
+
     inline Type getType() { return type_; }
     inline Spacing getSpacing() { return spacing_; }
     inline Positioning getPositioning() { return positioning_; }
     inline float getWidth() { return width_; }
     inline float getHeight() { return height_; }
     inline ImVec2 getOffset() { return offset_; }
-    const std::vector<float> getDisplayBounds() const;
+    // Bounds as of the last updateDisplayBounds(), as {x0, y0, x1, y1} per display
+    const std::vector<float>& getDisplayBounds() const { return display_bounds_; }
+    void updateDisplayBounds();
 
     void setWidth(float width) { 
         if (width > 0.0) {
@@ -91,6 +148,10 @@ public:
 
     void draw();
 
+    // Only valid for the primary component, once its width and height are set
+    DisplayGrid getDisplayGrid() const;
+    std::vector<DisplayRect> getPrimaryDisplayRects() const;
+
 private:
     Layout &layout_;
     Type type_;
@@ -100,15 +161,23 @@ private:
     float width_;
     float height_;
 
+    Spacing requested_spacing_;
+    Positioning requested_positioning_;
+    float requested_width_, requested_height_;
+    ImVec2 requested_offset_;
+    std::vector<float> display_bounds_;
+
     void checkParameters();
 
-    void getPrimaryDisplayPositionAndSize(uint cur_display, uint num_displays, float &x_pos, float &y_pos,
-        float &width, float &height) const;
+    void getPrimaryDisplayPositionAndSize(uint cur_display, float &x_pos, float &y_pos, float &width,
+        float &height) const;
     void drawPrimaryWindows() const;
-    void getCarouselRibbonPosAndDisplaysPosAndSize(ImVec2 &ribbon_pos, std::vector<ImVec4> &display_dim_data) const;
+    void updateCarouselScroll(const std::vector<uint> &tile_displays, float stride, float tile_length,
+        float ribbon_length) const;
     void drawCarouselRibbon() const;
     void getPiPWindowPosition(ImVec2 &window_pos) const;
     void drawPiPWindow() const;
+    void drawPiPDisplay(uint display_id) const;
     void getDoublePiPWindowPositions(ImVec4 &window_pos) const;
     void drawDoublePiPWindows() const;
 };
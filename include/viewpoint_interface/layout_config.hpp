@@ -0,0 +1,122 @@
+#ifndef __LAYOUT_CONFIG_HPP__
+#define __LAYOUT_CONFIG_HPP__
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include <time.h>
+
+#include "viewpoint_interface/layout.hpp"
+
+
+namespace viewpoint_interface
+{
+
+// One component of a configured layout, with its JSON description resolved
+struct LayoutComponentSpec
+{
+    LayoutComponent::Type type;
+    LayoutComponent::Spacing spacing;
+    LayoutComponent::Positioning positioning;
+    float width, height; // Pixels, or a fraction of the viewport when no larger than 1 (0 is automatic)
+    ImVec2 offset;
+    bool toggled; // Hidden and shown by the toggle command
+};
+
+struct LayoutKeyBinding
+{
+    int key; // GLFW key code
+    LayoutCommand command;
+};
+
+/**
+ * A layout described in layout_config.json instead of a header in layouts/.
+ * Names of component types, positions, keys and commands are all resolved
+ * when the file is loaded, so drawing a configured layout goes through the
+ * same components and cached geometry as a built-in one.
+ */
+struct LayoutSpec
+{
+    std::string name;
+    int num_primary, num_secondary; // -1 gives every display the role
+    std::vector<LayoutComponentSpec> components;
+    std::vector<LayoutKeyBinding> key_bindings; // Checked before the default key handling
+    bool show_states;
+};
+
+/**
+ * Parses the contents of a layout config file. Empty data is a valid config
+ * without any layouts.
+ *
+ * Params:
+ *      data - JSON text
+ *      specs - filled with the layouts in file order, untouched on failure
+ *      error - description of the first problem found
+ */
+bool parseLayoutConfig(const std::string &data, std::vector<LayoutSpec> &specs, std::string &error);
+
+
+/**
+ * Watches a layout config file for changes and parses it on its own thread,
+ * so editing the file never stalls a frame. The render thread picks up the
+ * parsed layouts with takeUpdate() between frames. A file that fails to
+ * parse is reported and otherwise ignored, leaving the previous layouts in
+ * place.
+ */
+class LayoutConfigWatcher
+{
+public:
+    static const uint kPollPeriodMs = 500;
+
+    LayoutConfigWatcher() : watching_(false), stopping_(false), has_update_(false), num_loads_(0),
+            num_failed_loads_(0), num_layouts_(0) {}
+    ~LayoutConfigWatcher() { stop(); }
+
+    /**
+     * Loads the file before returning, so the initial layouts are available
+     * to the first frame.
+     *
+     * Params:
+     *      path - config file, relative to the package directory
+     *      on_change - called from the watcher thread after each reload or failed reload
+     */
+    bool start(const std::string &path, std::function<void()> on_change=std::function<void()>());
+    void stop();
+    bool isWatching() const { return watching_; }
+
+    // Returns true if the file was reloaded since the last call
+    bool takeUpdate(std::vector<LayoutSpec> &specs);
+    // Returns true if a reload failed since the last call
+    bool takeError(std::string &error);
+
+    void drawPanel();
+
+private:
+    std::string path_;
+    std::function<void()> on_change_;
+    bool watching_;
+    timespec mod_time_;
+
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable stop_requested_;
+    bool stopping_;
+    bool has_update_;
+    std::vector<LayoutSpec> pending_;
+    std::string pending_error_, last_error_;
+
+    std::atomic<uint64_t> num_loads_, num_failed_loads_;
+    std::atomic<uint> num_layouts_;
+
+    bool readModTime(timespec &mod_time) const;
+    bool loadFile();
+    void watchFile();
+};
+
+} // viewpoint_interface
+
+#endif // __LAYOUT_CONFIG_HPP__
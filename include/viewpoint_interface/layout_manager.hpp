@@ -1,6 +1,10 @@
 #ifndef __LAYOUT_MANAGER_HPP__
 #define __LAYOUT_MANAGER_HPP__
 
+#include <functional>
+#include <atomic>
+#include <tuple>
+
 #include "viewpoint_interface/layout.hpp"
 #include "viewpoint_interface/layouts/dynamic.hpp"
 #include "viewpoint_interface/layouts/wide.hpp"
@@ -12,6 +16,7 @@
 #include "viewpoint_interface/layouts/carousel.hpp"
 #include "viewpoint_interface/layouts/twinned_pip.hpp"
 #include "viewpoint_interface/layouts/double_pip.hpp"
+#include "viewpoint_interface/layouts/config.hpp"
 
 namespace viewpoint_interface
 {
@@ -26,7 +31,7 @@ public:
     void handleCollisionMessage(const std::string& message) { active_layout_->handleCollisionMessage(message); }
     void setActiveFrame(const uint& index) { active_layout_->setActiveFrame(index); }
     const std::vector<float>& getActiveDisplayMatrix() const { return active_layout_->getActiveDisplayMatrix(); }
-    const std::vector<float> getDisplayBounds() const { return active_layout_->getDisplayBounds(); }
+    const std::vector<float>& getDisplayBounds() const { return active_layout_->getDisplayBounds(); }
 
     void toggleControlPanel()
     {
@@ -43,6 +48,15 @@ public:
         button_pubs_.emplace_back(pub);
     }
 
+    /**
+     * Register an extra section for the control panel. Sections are drawn
+     * below the active layout's parameters, each under its own header.
+     */
+    void addControlPanelSection(std::string title, std::function<void()> draw_fn)
+    {
+        panel_sections_.emplace_back(title, draw_fn);
+    }
+
     void draw()
     {
         previous_layout_ = active_layout_;
@@ -56,7 +70,7 @@ public:
             ImGuiViewport* main_viewport = ImGui::GetMainViewport();
             ImGui::SetNextWindowPos(ImVec2(main_viewport->GetWorkPos().x + 30, 
                     main_viewport->GetWorkPos().y + 100), ImGuiCond_Once);
-            if (startMenu(kControlPanelTitle, win_flags)) {
+            if (startMenu(kControlPanelTitle.c_str(), win_flags)) {
                 buildControlPanel();
                 endMenu();
             }
@@ -74,33 +88,155 @@ public:
                     main_viewport->GetWorkPos().x + main_viewport->GetWorkSize().x - 500,
                     main_viewport->GetWorkPos().y + main_viewport->GetWorkSize().y - 350),
                     ImGuiCond_Once);
-            if (startMenu(kButtonsPanelTitle, win_flags)) {
+            if (startMenu(kButtonsPanelTitle.c_str(), win_flags)) {
                 buildButtonPanel();
                 endMenu();
             }
         }
 
+        active_layout_->setBatchedDisplays(batched_displays_);
+        active_layout_->setMaxDisplaysPerPage(max_displays_per_page_);
+        active_layout_->clearDisplayQuads();
         active_layout_->draw();
+
+        for (auto &visible : visible_displays_) {
+            visible.second = active_layout_->isDisplayVisible(visible.first);
+        }
+    }
+
+    bool handleKeyInput(int key, int action, int mods)
+    {
+        return active_layout_->handleKeyInput(key, action, mods);
+    }
+
+    bool handleStringInput(std::string input)
+    {
+        return active_layout_->handleStringInput(input);
+    }
+
+    /**
+     * Replaces the layouts loaded from layout_config.json; call between
+     * frames. Layouts are matched to earlier loads by name and keep their
+     * LayoutType, so ones that were already created just take the new
+     * description and keep their display states. If the active layout was
+     * removed from the file, layouts are inactivated.
+     */
+    void setConfigLayouts(const std::vector<LayoutSpec> &specs)
+    {
+        for (ConfigSlot &slot : config_slots_) {
+            slot.loaded = false;
+        }
+
+        for (const LayoutSpec &spec : specs) {
+            uint ix(0);
+            while (ix < config_slots_.size() && config_slots_[ix].spec.name != spec.name) {
+                ++ix;
+            }
+
+            if (ix == config_slots_.size()) {
+                config_slots_.push_back(ConfigSlot{spec, true});
+            }
+            else {
+                config_slots_[ix] = ConfigSlot{spec, true};
+            }
+        }
+
+        std::vector<std::shared_ptr<Layout>> created(layouts_cache_);
+        created.push_back(active_layout_);
+        for (const std::shared_ptr<Layout> &layout : created) {
+            if (!isConfigLayoutType(layout->getLayoutType())) {
+                continue;
+            }
+
+            const ConfigSlot &slot(config_slots_[getConfigSlotIx(layout->getLayoutType())]);
+            if (slot.loaded) {
+                static_cast<ConfigLayout&>(*layout).setSpec(slot.spec);
+            }
+        }
+
+        if (isConfigLayoutType(active_layout_->getLayoutType()) &&
+                !config_slots_[getConfigSlotIx(active_layout_->getLayoutType())].loaded) {
+            activateLayout(LayoutType::INACTIVE);
+        }
     }
 
-    void handleKeyInput(int key, int action, int mods)
+    void setBatchedDisplays(bool batched) { batched_displays_ = batched; }
+    bool getBatchedDisplays() const { return batched_displays_; }
+    const std::vector<DisplayQuad>& getDisplayQuads() const { return active_layout_->getDisplayQuads(); }
+
+    int64_t getNextDeadlineMs() const { return active_layout_->getNextDeadlineMs(); }
+
+    void addDisplay(const Display &disp)
     {
-        active_layout_->handleKeyInput(key, action, mods);
+        displays_.addDisplay(disp);
+        visible_displays_.emplace(std::piecewise_construct, std::forward_as_tuple(disp.getId()),
+                std::forward_as_tuple(true));
     }
 
-    void handleStringInput(std::string input)
+    void setMaxDisplaysPerPage(uint num) { max_displays_per_page_ = num; }
+
+    // Cached layouts beyond this many are dropped, least recently used first (0 keeps them all).
+    // A dropped layout starts from its defaults when it is activated again
+    void setMaxCachedLayouts(uint num)
     {
-        active_layout_->handleStringInput(input);
+        max_cached_layouts_ = num;
+        trimLayoutCache();
     }
+    uint getNumCachedLayouts() const { return layouts_cache_.size(); }
+    uint64_t getNumEvictedLayouts() const { return num_evicted_layouts_; }
+
+    // Switches to the layout, from the cache if it was active before. Used by the
+    // control panel's layout menu; call between frames
+    void activateLayout(LayoutType type)
+    {
+        // It's already active
+        if (active_layout_->getLayoutType() == type) {
+            return;
+        }
+
+        // We cache previously active layouts so that their params are not reset
+        if (!isInCache(active_layout_->getLayoutType())) {
+            layouts_cache_.push_back(active_layout_);
+        }
+
+        if (isInCache(type)) {
+            active_layout_ = getLayoutFromCache(type);
+
+            std::vector<std::shared_ptr<Layout>>::iterator cached(std::find(layouts_cache_.begin() + 1,
+                    layouts_cache_.end(), active_layout_));
+            if (cached != layouts_cache_.end()) {
+                std::rotate(cached, cached + 1, layouts_cache_.end());
+            }
+        }
+        else {
+            active_layout_ = newLayout(type);
+        }
 
-    void addDisplay(const Display &disp) { displays_.addDisplay(disp); }
+        trimLayoutCache();
+    }
+
+    /**
+     * Safe to call from image callbacks. Displays that were not shown in the
+     * last frame (e.g. on another grid page) don't need their images.
+     */
+    bool isDisplayVisible(uint id) const
+    {
+        auto it(visible_displays_.find(id));
+        return it == visible_displays_.end() || it->second;
+    }
 
     const DisplayInfo& getDisplayInfo(uint ix) const
     {
         return displays_.getDisplayInfo(ix);
     }
 
+    const DisplayInfo& getDisplayInfoById(uint id) const
+    {
+        return displays_.getDisplayInfoById(id);
+    }
+
     uint getNumTotalDisplays() const { return displays_.getNumTotalDisplays(); }
+    const DisplayManager& getDisplayManager() const { return displays_; }
 
     void forwardImageForDisplayId(uint id, const cv::Mat &image)
     {
@@ -132,6 +268,34 @@ public:
         active_layout_->pushImageResponse(response);
     }
 
+    std::vector<uint>& getThumbnailRequestQueue()
+    {
+        return active_layout_->getThumbnailRequestQueue();
+    }
+
+    // Thumbnails are kept per display, so they apply to any layout
+    void pushThumbnailResponse(const DisplayImageResponse &response)
+    {
+        active_layout_->pushThumbnailResponse(response);
+    }
+
+    // After a display's texture was deleted, so no layout draws the stale name
+    void forgetDisplayImage(uint display_id)
+    {
+        for (const std::shared_ptr<Layout> &layout : layouts_cache_) {
+            layout->forgetImage(display_id);
+        }
+        active_layout_->forgetImage(display_id);
+    }
+
+    void forgetThumbnail(uint display_id)
+    {
+        for (const std::shared_ptr<Layout> &layout : layouts_cache_) {
+            layout->forgetThumbnail(display_id);
+        }
+        active_layout_->forgetThumbnail(display_id);
+    }
+
 private:
     DisplayManager displays_;
     std::shared_ptr<Layout> active_layout_;
@@ -141,15 +305,40 @@ private:
     const std::string kButtonsPanelTitle = "Buttons Panel";
 
     bool control_panel_active_ = true;
+    bool batched_displays_ = false;
+    uint max_displays_per_page_ = 9;
+    std::map<uint, std::atomic<bool>> visible_displays_; // Only filled in before callbacks start
     // Buttons panel data
     std::vector<ros::Publisher> button_pubs_;
     bool button_panel_active_ = true;
+    std::vector<std::pair<std::string, std::function<void()>>> panel_sections_;
 
-    std::vector<std::shared_ptr<Layout>> layouts_cache_;
+    std::vector<std::shared_ptr<Layout>> layouts_cache_; // Least recently active first, after the inactive layout
     std::vector<LayoutType> excluded_layouts_;
+    uint max_cached_layouts_ = 0;
+    uint64_t num_evicted_layouts_ = 0;
+
+    struct ConfigSlot
+    {
+        LayoutSpec spec;
+        bool loaded; // False once the layout is removed from the file
+    };
+    std::vector<ConfigSlot> config_slots_; // Slot i has LayoutType CONFIGURED + i; slots are never reused
+
+    bool isConfigLayoutType(LayoutType type) const
+    {
+        return type >= LayoutType::CONFIGURED && getConfigSlotIx(type) < config_slots_.size();
+    }
+
+    uint getConfigSlotIx(LayoutType type) const { return (uint)type - (uint)LayoutType::CONFIGURED; }
 
     std::shared_ptr<Layout> newLayout(LayoutType type)
     {
+        if (isConfigLayoutType(type)) {
+            return std::shared_ptr<Layout>(new ConfigLayout(displays_, type,
+                    config_slots_[getConfigSlotIx(type)].spec));
+        }
+
         std::shared_ptr<Layout> layout;
         switch(type) {
             case LayoutType::DYNAMIC:
@@ -211,23 +400,19 @@ private:
         return layout;
     }
 
-    void activateLayout(LayoutType type)
+    // The inactive layout at the front and the active layout are always kept
+    void trimLayoutCache()
     {
-        // It's already active
-        if (active_layout_->getLayoutType() == type) {
-            return;
-        }
-
-        // We cache previously active layouts so that their params are not reset
-        if (!isInCache(active_layout_->getLayoutType())) {
-            layouts_cache_.push_back(active_layout_);
-        }
+        uint ix(1);
+        while (max_cached_layouts_ != 0 && layouts_cache_.size() > max_cached_layouts_ && 
+                ix < layouts_cache_.size()) {
+            if (layouts_cache_[ix] == active_layout_) {
+                ++ix;
+                continue;
+            }
 
-        if (isInCache(type)) {
-            active_layout_ = getLayoutFromCache(type);
-        }
-        else {
-            active_layout_ = newLayout(type);
+            layouts_cache_.erase(layouts_cache_.begin() + ix);
+            ++num_evicted_layouts_;
         }
     }
 
@@ -292,7 +477,7 @@ private:
         if (ImGui::BeginMenuBar())
         {
             if (ImGui::BeginMenu(active_layout_->getLayoutName().c_str())) {
-                std::vector<std::string> layout_names = active_layout_->getLayoutList();
+                const std::vector<std::string> &layout_names = active_layout_->getLayoutList();
                 bool selected;
                 bool inactivate = false;
 
@@ -318,6 +503,20 @@ private:
                     }
                 }
 
+                for (uint i(0); i < config_slots_.size(); ++i) {
+                    if (!config_slots_[i].loaded) {
+                        continue;
+                    }
+
+                    LayoutType layout_type((LayoutType)(LayoutType::CONFIGURED + i));
+                    selected = isLayoutActive(layout_type);
+                    ImGui::MenuItem(config_slots_[i].spec.name.c_str(), NULL, &selected);
+
+                    if (selected) {
+                        activateLayout(layout_type);
+                    }
+                }
+
                 ImGui::EndMenu();
             }
 
@@ -332,6 +531,13 @@ private:
         ImGui::Spacing();
 
         active_layout_->displayLayoutParams();
+
+        for (auto &section : panel_sections_) {
+            ImGui::Separator();
+            if (ImGui::CollapsingHeader(section.first.c_str())) {
+                section.second();
+            }
+        }
     }
 
     void buildButtonPanel()
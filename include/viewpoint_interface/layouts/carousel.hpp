@@ -18,12 +18,10 @@ public:
             Layout(LayoutType::CAROUSEL, displays), parameters_(params) 
     {
         setNumDisplaysForRole(1, LayoutDisplayRole::Primary);
+        // Every display gets a tile in the ribbon
+        setNumDisplaysForRole(-1, LayoutDisplayRole::Secondary);
 
         addDisplayByIxAndRole(parameters_.primary_display, LayoutDisplayRole::Primary);
-
-        for (int i = 0; i < displays.getNumTotalDisplays(); ++i) {
-            addDisplayByIxAndRole(i, LayoutDisplayRole::Secondary);
-        }
     }
 
     virtual void displayLayoutParams() override
@@ -38,9 +36,9 @@ public:
         addLayoutComponent(LayoutComponent::Type::Carousel);
         drawLayoutComponents();
 
-        std::map<std::string, bool> states;
-        states["Robot"] = !clutching_;
-        states["Suction"] = grabbing_;
+        StateList states;
+        states.emplace_back("Robot", !clutching_);
+        states.emplace_back("Suction", grabbing_);
         displayStateValues(states);
     }
 
@@ -0,0 +1,105 @@
+#ifndef __LAYOUT_CONFIG_LAYOUT_HPP__
+#define __LAYOUT_CONFIG_LAYOUT_HPP__
+
+#include "viewpoint_interface/layout.hpp"
+#include "viewpoint_interface/layout_config.hpp"
+
+namespace viewpoint_interface
+{
+
+class ConfigLayout final : public Layout
+{
+public:
+    ConfigLayout(DisplayManager &displays, LayoutType type, const LayoutSpec &spec) : Layout(type, displays),
+            toggled_off_(false)
+    {
+        setSpec(spec);
+    }
+
+    /**
+     * Takes effect on the next draw. Display roles and the ring order carry
+     * over, so a reload only changes what the new description changes.
+     */
+    void setSpec(const LayoutSpec &spec)
+    {
+        spec_ = spec;
+        setNumDisplaysForRole(spec_.num_primary, LayoutDisplayRole::Primary);
+        setNumDisplaysForRole(spec_.num_secondary, LayoutDisplayRole::Secondary);
+    }
+
+    virtual const std::string& getLayoutName() const override { return spec_.name; }
+
+    virtual void displayLayoutParams() override
+    {
+        drawDisplaysList();
+        drawDraggableRing();
+    }
+
+    virtual void draw() override
+    {
+        ImVec2 work_size(ImGui::GetMainViewport()->GetWorkSize());
+
+        for (const LayoutComponentSpec &component : spec_.components) {
+            if (component.toggled && toggled_off_) {
+                continue;
+            }
+
+            float width(component.width <= 1.0f ? component.width * work_size.x : component.width);
+            float height(component.height <= 1.0f ? component.height * work_size.y : component.height);
+            addLayoutComponent(component.type, component.spacing, component.positioning, width, height,
+                    component.offset);
+        }
+        drawLayoutComponents();
+
+        if (spec_.show_states) {
+            StateList states;
+            states.emplace_back("Robot", !clutching_);
+            states.emplace_back("Suction", grabbing_);
+            displayStateValues(states);
+        }
+    }
+
+    virtual bool handleKeyInput(int key, int action, int mods) override
+    {
+        if (action == GLFW_PRESS) {
+            for (const LayoutKeyBinding &binding : spec_.key_bindings) {
+                if (binding.key == key) {
+                    return handleCommand(binding.command);
+                }
+            }
+        }
+
+        return Layout::handleKeyInput(key, action, mods);
+    }
+
+    virtual bool handleStringInput(std::string input) override
+    {
+        return handleCommand(translateStringInputToCommand(input));
+    }
+
+private:
+    LayoutSpec spec_;
+    bool toggled_off_;
+
+    bool handleCommand(LayoutCommand command)
+    {
+        switch(command)
+        {
+            case LayoutCommand::TOGGLE:
+            {
+                toggled_off_ = !toggled_off_;
+            }   break;
+
+            default:
+            {
+                return handleLayoutCommand(command);
+            }
+        }
+
+        return true;
+    }
+};
+
+} // viewpoint_interface
+
+#endif //__LAYOUT_CONFIG_LAYOUT_HPP__
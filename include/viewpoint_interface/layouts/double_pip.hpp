@@ -42,13 +42,13 @@ public:
             LayoutComponent::ComponentPositioning_Right);
         drawLayoutComponents();
 
-        std::map<std::string, bool> states;
-        states["Robot"] = !clutching_;
-        states["Suction"] = grabbing_;
+        StateList states;
+        states.emplace_back("Robot", !clutching_);
+        states.emplace_back("Suction", grabbing_);
         displayStateValues(states);
     }
 
-    virtual void handleKeyInput(int key, int action, int mods) override
+    virtual bool handleKeyInput(int key, int action, int mods) override
     {
         if (action == GLFW_PRESS) {
             switch (key) {
@@ -69,20 +69,20 @@ public:
 
                 default:
                 {
-                } break;
+                    return false;
+                }
             }
+
+            return true;
         }
+
+        return false;
     }
 
-    virtual void handleStringInput(std::string input) override
+    // None of the string commands apply to this layout
+    virtual bool handleStringInput(std::string input) override
     {
-        LayoutCommand command(translateStringInputToCommand(input));
-
-        switch(command)
-        {
-            default:
-            {}  break;
-        }
+        return false;
     }
 
 
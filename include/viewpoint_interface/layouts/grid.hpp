@@ -36,13 +36,13 @@ public:
         addLayoutComponent(LayoutComponent::Type::Primary);
         drawLayoutComponents();
 
-        std::map<std::string, bool> states;
-        states["Robot"] = !clutching_;
-        states["Gripper#on_off"] = grabbing_;
+        StateList states;
+        states.emplace_back("Gripper#on_off", grabbing_);
+        states.emplace_back("Robot", !clutching_);
         displayStateValues(states);
     }
 
-    virtual void handleStringInput(std::string input) override
+    virtual bool handleStringInput(std::string input) override
     {
         LayoutCommand command(translateStringInputToCommand(input));
 
@@ -85,7 +85,23 @@ public:
                 display_states_.handleActiveFrameDirectionInput(LayoutCommand::ACTIVE_FRAME_LEFT);
             }   break;
 
+            case LayoutCommand::PAGE_NEXT:
+            {
+                display_states_.toNextPage();
+            }   break;
+
+            case LayoutCommand::PAGE_PREV:
+            {
+                display_states_.toPrevPage();
+            }   break;
+
+            default:
+            {
+                return false;
+            }
         }
+
+        return true;
     }
     
 private:
@@ -40,9 +40,9 @@ public:
         addLayoutComponent(LayoutComponent::Type::Primary);
         drawLayoutComponents();
 
-        std::map<std::string, bool> states;
-        states["Robot"] = !clutching_;
-        states["Suction"] = grabbing_;
+        StateList states;
+        states.emplace_back("Robot", !clutching_);
+        states.emplace_back("Suction", grabbing_);
         displayStateValues(states);
     }
 
@@ -106,13 +106,13 @@ public:
         }
         drawLayoutComponents();
 
-        std::map<std::string, bool> states;
-        states["Robot"] = !clutching_;
-        states["Suction"] = grabbing_;
+        StateList states;
+        states.emplace_back("Robot", !clutching_);
+        states.emplace_back("Suction", grabbing_);
         displayStateValues(states);
     }
 
-    virtual void handleKeyInput(int key, int action, int mods) override
+    virtual bool handleKeyInput(int key, int action, int mods) override
     {
         if (action == GLFW_PRESS) {
             switch (key) {
@@ -148,12 +148,32 @@ public:
 
                 default:
                 {
-                } break;
+                    return false;
+                }
             }
+
+            return true;
         }
+
+        return false;
     }
 
-    virtual void handleStringInput(std::string input) override
+    virtual int64_t getNextDeadlineMs() const override
+    {
+        int64_t next(Layout::getNextDeadlineMs());
+        int64_t remaining(countdown_.getMillisecondsRemaining());
+        if (remaining >= 0) {
+            // The parameters panel counts down in whole seconds
+            int64_t tick(remaining % 1000);
+            if (next < 0 || tick < next) {
+                next = tick;
+            }
+        }
+
+        return next;
+    }
+
+    virtual bool handleStringInput(std::string input) override
     {
         LayoutCommand command(translateStringInputToCommand(input));
 
@@ -165,8 +185,12 @@ public:
             }   break;
 
             default:
-            {}  break;
+            {
+                return false;
+            }
         }
+
+        return true;
     }
 
 
@@ -34,13 +34,13 @@ public:
         addLayoutComponent(LayoutComponent::Type::Primary);
         drawLayoutComponents();
 
-        std::map<std::string, bool> states;
-        states["Robot"] = !clutching_;
-        states["Suction"] = grabbing_;
+        StateList states;
+        states.emplace_back("Robot", !clutching_);
+        states.emplace_back("Suction", grabbing_);
         displayStateValues(states);
     }
 
-    virtual void handleKeyInput(int key, int action, int mods) override
+    virtual bool handleKeyInput(int key, int action, int mods) override
     {
         if (action == GLFW_PRESS) {
             switch (key) {
@@ -52,12 +52,17 @@ public:
 
                 default:
                 {
-                } break;
+                    return false;
+                }
             }
+
+            return true;
         }
+
+        return false;
     }
 
-    virtual void handleStringInput(std::string input) override
+    virtual bool handleStringInput(std::string input) override
     {
         LayoutCommand command(translateStringInputToCommand(input));
 
@@ -69,8 +74,12 @@ public:
             }   break;
 
             default:
-            {}  break;
+            {
+                return false;
+            }
         }
+
+        return true;
     }
 
 private:
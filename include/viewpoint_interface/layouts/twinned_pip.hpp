@@ -93,13 +93,13 @@ public:
         }
         drawLayoutComponents();
 
-        std::map<std::string, bool> states;
-        states["Robot"] = !clutching_;
-        states["Suction"] = grabbing_;
+        StateList states;
+        states.emplace_back("Robot", !clutching_);
+        states.emplace_back("Suction", grabbing_);
         displayStateValues(states);
     }
 
-    virtual void handleKeyInput(int key, int action, int mods) override
+    virtual bool handleKeyInput(int key, int action, int mods) override
     {
         // TODO: Add function to swap active primary with active secondary
         if (action == GLFW_PRESS) {
@@ -135,12 +135,17 @@ public:
 
                 default:
                 {
-                } break;
+                    return false;
+                }
             }
+
+            return true;
         }
+
+        return false;
     }
 
-    virtual void handleStringInput(std::string input) override
+    virtual bool handleStringInput(std::string input) override
     {
         LayoutCommand command(translateStringInputToCommand(input));
 
@@ -153,8 +158,12 @@ public:
             }   break;
 
             default:
-            {}  break;
+            {
+                return false;
+            }
         }
+
+        return true;
     }
 
 
@@ -33,21 +33,16 @@ public:
         addLayoutComponent(LayoutComponent::Type::Primary);
         drawLayoutComponents();
 
-        std::map<std::string, bool> states;
-        states["Robot"] = !clutching_;
-        states["Suction"] = grabbing_;
+        StateList states;
+        states.emplace_back("Robot", !clutching_);
+        states.emplace_back("Suction", grabbing_);
         displayStateValues(states);
     }
 
-    virtual void handleStringInput(std::string input) override
+    // None of the string commands apply to this layout
+    virtual bool handleStringInput(std::string input) override
     {
-        LayoutCommand command(translateStringInputToCommand(input));
-
-        switch(command)
-        {
-            default:
-            {}  break;
-        }
+        return false;
     }
 
 private:
@@ -0,0 +1,55 @@
+#ifndef __MEMORY_TRACKER_HPP__
+#define __MEMORY_TRACKER_HPP__
+
+#include <atomic>
+#include <cstdint>
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Bytes held by the interface's larger allocations, by kind.
+ *
+ * Owners add what they allocate and subtract what they free, from any
+ * thread, on lock-free counters. GL sizes are what was asked of the driver,
+ * which may pad them or keep copies of its own, so they are a lower bound
+ * on what the GPU holds.
+ */
+class MemoryTracker
+{
+public:
+    enum class Category
+    {
+        FrameBuffers, // Latest camera image of each display, on the CPU
+        Textures,
+        PixelBuffers, // PBOs and renderbuffers of the offscreen target and view capture
+        Meshes,
+        ImGui, // Heap memory allocated by ImGui
+        Count
+    };
+
+    static void add(Category category, int64_t bytes)
+    {
+        bytes_[(int)category].fetch_add(bytes, std::memory_order_relaxed);
+    }
+    static void set(Category category, int64_t bytes)
+    {
+        bytes_[(int)category].store(bytes, std::memory_order_relaxed);
+    }
+    static int64_t get(Category category) { return bytes_[(int)category].load(std::memory_order_relaxed); }
+    static int64_t getTotal();
+    static const char* categoryToString(Category category);
+
+    // Must be called before the ImGui context is created
+    static void installImGuiAllocator();
+
+    static void drawPanel();
+
+private:
+    static std::atomic<int64_t> bytes_[(int)Category::Count];
+};
+
+} // viewpoint_interface
+
+#endif // __MEMORY_TRACKER_HPP__
@@ -11,6 +11,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "shader.hpp"
+#include "viewpoint_interface/memory_tracker.hpp"
 
 
 struct Vertex {
@@ -78,6 +79,8 @@ private:
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint), &indices[0], GL_STATIC_DRAW);
+        viewpoint_interface::MemoryTracker::add(viewpoint_interface::MemoryTracker::Category::Meshes,
+                (vertices.size() * sizeof(Vertex)) + (indices.size() * sizeof(uint)));
 
         // Vertex Positions
         glEnableVertexAttribArray(0);	
@@ -216,6 +216,9 @@ uint TextureFromFile(const char *path, const std::string &directory, bool gamma)
         glBindTexture(GL_TEXTURE_2D, textureID);
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
+        // The mipmap chain adds a third to the base level
+        viewpoint_interface::MemoryTracker::add(viewpoint_interface::MemoryTracker::Category::Textures,
+                (int64_t)width * height * nrComponents * 4 / 3);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -0,0 +1,59 @@
+#ifndef __OFFSCREEN_CONTEXT_HPP__
+#define __OFFSCREEN_CONTEXT_HPP__
+
+#include <string>
+
+#include <EGL/egl.h>
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * OpenGL 3.3 core context without a window or monitor, for headless runs.
+ * Rendering goes to a framebuffer object of a fixed size, which stays bound
+ * as the default draw target.
+ *
+ * The context comes from EGL, preferring Mesa's surfaceless platform so it
+ * works without an X server or GPU (llvmpipe).
+ */
+class OffscreenContext
+{
+public:
+    OffscreenContext() : display_(EGL_NO_DISPLAY), context_(EGL_NO_CONTEXT), surface_(EGL_NO_SURFACE),
+            fbo_(0), color_rbo_(0), depth_rbo_(0), width_(0), height_(0) {}
+    ~OffscreenContext() { destroy(); }
+
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    /**
+     * Creates the context, makes it current on the calling thread and loads
+     * OpenGL functions through glad. The framebuffer that frames are drawn into
+     * is left bound; code that binds another one restores it afterwards, as
+     * FrameCapture does.
+     *
+     * Returns: false on failure, with the reason available from getError().
+     */
+    bool create(uint width, uint height);
+    void destroy();
+
+    uint getWidth() const { return width_; }
+    uint getHeight() const { return height_; }
+    const std::string& getError() const { return error_; }
+
+private:
+    EGLDisplay display_;
+    EGLContext context_;
+    EGLSurface surface_;
+    uint fbo_, color_rbo_, depth_rbo_;
+    uint width_, height_;
+    std::string error_;
+
+    EGLDisplay getDisplay() const;
+    bool createFramebuffer();
+};
+
+} // viewpoint_interface
+
+#endif // __OFFSCREEN_CONTEXT_HPP__
@@ -0,0 +1,120 @@
+#ifndef __PIPELINE_STATS_HPP__
+#define __PIPELINE_STATS_HPP__
+
+#include <map>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <diagnostic_msgs/DiagnosticArray.h>
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Counters for the health of the camera-to-screen pipeline, published as
+ * diagnostics for rqt_runtime_monitor.
+ *
+ * The callbacks and the render loop only bump lock-free counters. Rates,
+ * means and percentiles are worked out once per report by whichever thread
+ * calls makeDiagnostics(), from the difference to the previous report, so
+ * the cost of aggregating stays off the hot path. Counters only ever grow,
+ * except for per-report maxima and the frame time histogram, which the
+ * reporting thread takes and clears.
+ *
+ * Cameras are added before their callbacks start.
+ */
+class PipelineStats
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum class Queue
+    {
+        ImageRequests, // Full-size displays drawn last frame
+        PendingUploads, // Of those, ones held back or deferred by the upload scheduler
+        ThumbnailRequests,
+        Count
+    };
+
+    // Frame times are binned at this resolution for percentiles, longer frames land
+    // in the last bin. The maximum is kept separately so long stalls still show.
+    static constexpr float kBinMs = 0.25f;
+    static const uint kNumBins = 400;
+
+    PipelineStats();
+
+    void addCamera(uint id, const std::string &name);
+
+    /**
+     * From the camera callbacks.
+     *
+     * Params:
+     *      age_ms - time since the image was stamped, negative if it has no stamp
+     */
+    void imageReceived(uint id, float age_ms);
+    void imageConverted(uint id, float convert_ms);
+    /**
+     * Header sequence numbers can't be relied on to find drops, so they are only
+     * known for images with a frame marker, from the StreamChecker's count.
+     * Cameras without one report their drops as unknown.
+     */
+    void setDropped(uint id, uint64_t dropped);
+
+    // From the render loop
+    void imageUploaded(uint id);
+    void bytesUploaded(uint64_t bytes) { bytes_uploaded_.fetch_add(bytes, std::memory_order_relaxed); }
+    void setQueueDepth(Queue queue, uint depth) { queue_depths_[(int)queue].store(depth, std::memory_order_relaxed); }
+    void frameSwapped();
+
+    // From the controller thread
+    void controllerPacket() { controller_packets_.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * A status for the pipeline as a whole and one per camera, covering the
+     * time since the previous call. Only one thread may call this.
+     */
+    diagnostic_msgs::DiagnosticArray makeDiagnostics();
+
+private:
+    struct Camera
+    {
+        std::string name;
+        std::atomic<uint64_t> received, uploaded, dropped;
+        std::atomic<bool> drops_known;
+        std::atomic<uint64_t> age_sum_us, age_count, age_max_us;
+        std::atomic<uint64_t> convert_sum_us, convert_count;
+
+        // Reporting thread only, the counts at the previous report
+        uint64_t last_received, last_uploaded;
+        uint64_t last_age_sum_us, last_age_count;
+        uint64_t last_convert_sum_us, last_convert_count;
+    };
+
+    std::map<uint, std::unique_ptr<Camera>> cameras_;
+    Clock::time_point last_report_;
+
+    // Render loop
+    Clock::time_point last_swap_;
+    std::atomic<uint64_t> frames_;
+    std::atomic<uint64_t> frame_bins_[kNumBins];
+    std::atomic<uint64_t> frame_max_us_;
+    std::atomic<uint64_t> bytes_uploaded_;
+    std::atomic<uint> queue_depths_[(int)Queue::Count];
+
+    std::atomic<uint64_t> controller_packets_;
+
+    // Reporting thread only
+    uint64_t last_frames_, last_bytes_uploaded_, last_controller_packets_;
+
+    static void storeMax(std::atomic<uint64_t> &max, uint64_t value);
+    static float getBinPercentile(const std::vector<uint64_t> &bins, uint64_t total, float fraction);
+};
+
+} // viewpoint_interface
+
+#endif // __PIPELINE_STATS_HPP__
@@ -0,0 +1,220 @@
+#ifndef __PROFILER_HPP__
+#define __PROFILER_HPP__
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Scoped, nestable CPU timing zones for every thread in the process.
+ *
+ * Wrap a scope in PROFILE_ZONE("name") to time it. Each thread records its
+ * zones into its own fixed-size ring without locking, and the render thread
+ * drains all rings once per frame in frameMark(), keeping per-zone timings
+ * and the zones of the last kFrameHistory frames for the flame graph.
+ *
+ * A capture records every zone and flow event from all threads for a few
+ * seconds and writes them to a Chrome trace JSON file, which opens in
+ * chrome://tracing or Perfetto. Flow events link the zones a piece of data
+ * passed through on different threads, such as a camera frame from its
+ * callback to the swap that showed it.
+ *
+ * While disabled, a zone costs one relaxed atomic load. Building without
+ * VIEWPOINT_PROFILER removes the zones entirely.
+ */
+class Profiler
+{
+public:
+    static const uint kRingSize = 8192; // Zones a thread can record between drains
+    static const uint kMaxThreads = 32;
+    static const uint kFrameHistory = 120;
+    static const uint kMaxCaptureSamples = 1000000; // A capture ends early once it holds this many
+
+    enum class SampleKind : uint8_t
+    {
+        Zone,
+        FlowStart,
+        FlowStep,
+        FlowEnd
+    };
+
+    struct Sample
+    {
+        const char *name; // String literal, compared by contents
+        int64_t start_ns, end_ns; // The same for flow events
+        uint64_t flow_id;
+        uint16_t depth;
+        uint8_t thread;
+        SampleKind kind;
+    };
+
+    static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Names the calling thread in the panel and the OS (truncated to 15 characters). Threads that
+    // don't are numbered
+    static void setThreadName(const char *name);
+
+    // Used by ProfileZone
+    static uint16_t enterZone();
+    static void exitZone(const char *name, int64_t start_ns, uint16_t depth);
+
+    /**
+     * Marks a point in a flow that is only recorded while capturing. Each
+     * point belongs to the zone around it, so call it inside one.
+     *
+     * Params:
+     *      name - flow name, a string literal
+     *      kind - FlowStart, FlowStep or FlowEnd
+     *      id - identifies the flow, unique among flows with the same name
+     */
+    static void flow(const char *name, SampleKind kind, uint64_t id);
+    static bool isCapturing() { return capturing_.load(std::memory_order_relaxed); }
+
+    Profiler() : last_mark_ns_(0), next_frame_(0), num_frames_(0), paused_(false), selected_frame_(0),
+            capture_seconds_(5.0f), capture_dir_("/tmp"), capture_requested_(false), capture_end_ns_(0),
+            was_enabled_(false), writing_(false), has_result_(false) {}
+    ~Profiler();
+
+    void setCaptureParams(float seconds, const std::string &dir);
+    // Safe from any thread. Returns false if a capture is already running or being written
+    bool requestCapture();
+    // Returns true once per finished capture, with the file written or the reason it failed
+    bool takeCaptureResult(std::string &result);
+
+    // Call once per frame from the render thread
+    void frameMark();
+    void drawPanel();
+    // Returns false if the zone hasn't been recorded
+    bool getZoneMeanMs(const char *name, float &mean_ms) const;
+
+    // Number of zones dropped because a ring was full or too many threads recorded
+    static uint64_t getNumDropped();
+
+private:
+    struct ThreadRing
+    {
+        char name[32];
+        Sample samples[kRingSize];
+        std::atomic<uint64_t> head, tail; // Written by the owning thread and the render thread respectively
+        std::atomic<uint64_t> dropped;
+        uint16_t depth;
+    };
+
+    struct Frame
+    {
+        int64_t start_ns, end_ns;
+        std::vector<Sample> samples;
+    };
+
+    struct ZoneStats
+    {
+        uint8_t thread;
+        float last_ms, mean_ms, max_ms; // Time spent in the zone per frame
+        uint last_calls;
+        float frame_ms; // Accumulates during a drain
+        uint frame_calls;
+    };
+
+    struct NameLess
+    {
+        bool operator()(const char *a, const char *b) const { return strcmp(a, b) < 0; }
+    };
+
+    static std::atomic<bool> enabled_;
+    static std::atomic<ThreadRing*> rings_[kMaxThreads];
+    static std::atomic<uint> num_rings_;
+    static std::atomic<uint64_t> unregistered_dropped_;
+    static thread_local ThreadRing *thread_ring_;
+    static thread_local const char *thread_name_;
+    static thread_local bool thread_ring_full_; // Set once all rings were taken before this thread asked
+
+    int64_t last_mark_ns_;
+    Frame frames_[kFrameHistory];
+    uint next_frame_, num_frames_;
+    bool paused_;
+    int selected_frame_; // Frames back from the latest
+    std::map<const char*, ZoneStats, NameLess> zones_;
+
+    static std::atomic<bool> capturing_;
+    float capture_seconds_;
+    std::string capture_dir_, capture_path_;
+    std::atomic<bool> capture_requested_;
+    int64_t capture_end_ns_;
+    bool was_enabled_;
+    std::vector<Sample> capture_;
+
+    std::thread writer_;
+    std::atomic<bool> writing_;
+    std::mutex result_mutex_;
+    std::string result_;
+    bool has_result_;
+
+    static ThreadRing* getThreadRing();
+    static void pushSample(const Sample &sample);
+    void drawFlameGraph(const Frame &frame);
+    void startCapture(int64_t now_ns);
+    void finishCapture();
+    void writeCapture(std::vector<Sample> samples, std::vector<std::string> thread_names, std::string path);
+};
+
+Profiler& getProfiler();
+
+
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char *name) : name_(name), active_(Profiler::isEnabled())
+    {
+        if (active_) {
+            depth_ = Profiler::enterZone();
+            start_ns_ = Profiler::now();
+        }
+    }
+
+    ~ProfileZone()
+    {
+        if (active_) {
+            Profiler::exitZone(name_, start_ns_, depth_);
+        }
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char *name_;
+    bool active_;
+    uint16_t depth_;
+    int64_t start_ns_;
+};
+
+} // viewpoint_interface
+
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef VIEWPOINT_PROFILER
+#define PROFILE_ZONE(name) viewpoint_interface::ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) do {} while (0)
+#endif
+
+#endif // __PROFILER_HPP__
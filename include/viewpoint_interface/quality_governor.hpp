@@ -0,0 +1,85 @@
+#ifndef __QUALITY_GOVERNOR_HPP__
+#define __QUALITY_GOVERNOR_HPP__
+
+#include <string>
+#include <cstdint>
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Lowers image quality in stages while frames take longer to build and render
+ * than the target frame time, and restores it once load drops.
+ *
+ * Stages, each adding to the ones before it:
+ *      Full - no reduction
+ *      SecondaryRate - Secondary displays refresh at kReducedSecondaryRate
+ *      SecondaryResolution - Secondary displays are uploaded at kReducedSecondaryScale
+ *      PrimaryDecimation - primary displays other than the active frame refresh at
+ *          kDecimatedPrimaryRate
+ *
+ * The active frame is never reduced. Stepping down takes kStepDownFrames
+ * consecutive frames over the target, and stepping back up takes
+ * kStepUpFrames consecutive frames under kRecoverFactor of it, so the stage
+ * doesn't flip back and forth around the target.
+ */
+class QualityGovernor
+{
+public:
+    enum class Stage
+    {
+        Full,
+        SecondaryRate,
+        SecondaryResolution,
+        PrimaryDecimation
+    };
+
+    static const uint kStepDownFrames = 30;
+    static const uint kStepUpFrames = 300;
+    static constexpr float kRecoverFactor = 0.6f;
+
+    static constexpr float kReducedSecondaryRate = 2.0f;
+    static constexpr float kReducedSecondaryScale = 0.5f;
+    static constexpr float kDecimatedPrimaryRate = 10.0f;
+
+    QualityGovernor() : enabled_(true), stage_(Stage::Full), frames_over_(0), frames_under_(0),
+            num_transitions_(0), last_work_ms_(0.0f), last_target_ms_(0.0f) {}
+
+    static const char* stageToString(Stage stage);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_; }
+
+    /**
+     * Call once per frame. Returns true if the stage changed, in which case
+     * getTransition() describes the change.
+     *
+     * Params:
+     *      work_ms - smoothed CPU and GPU time taken to build and render a frame, not counting the swap
+     *      target_ms - time available per frame
+     */
+    bool update(float work_ms, float target_ms);
+
+    Stage getStage() const { return stage_; }
+    const std::string& getTransition() const { return transition_; }
+    uint64_t getNumTransitions() const { return num_transitions_; }
+    float getWorkMs() const { return last_work_ms_; }
+    float getTargetMs() const { return last_target_ms_; }
+
+    void drawPanel();
+
+private:
+    bool enabled_;
+    Stage stage_;
+    uint frames_over_, frames_under_;
+    uint64_t num_transitions_;
+    float last_work_ms_, last_target_ms_;
+    std::string transition_;
+
+    void setStage(Stage stage, const char *reason);
+};
+
+} // viewpoint_interface
+
+#endif // __QUALITY_GOVERNOR_HPP__
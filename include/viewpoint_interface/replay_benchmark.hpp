@@ -0,0 +1,123 @@
+#ifndef __REPLAY_BENCHMARK_HPP__
+#define __REPLAY_BENCHMARK_HPP__
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Follows camera images played from a bag through the interface and reports
+ * on the run once the bag is done.
+ *
+ * Each image is counted when it is ingested, when the render loop uploads
+ * it and when the swap after that upload puts it on screen. The time from
+ * ingest to that swap is the image's latency. Images that are replaced
+ * before the render loop gets to them are never uploaded, and uploads that
+ * don't follow a new ingest aren't counted.
+ *
+ * Cameras are added before playback starts. imageIngested() and
+ * waitForCamera() are called from the bag thread, everything else from the
+ * render thread once the bag thread has finished.
+ */
+class ReplayBenchmark
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // A threshold of 0 isn't checked
+    struct Thresholds
+    {
+        float max_latency_ms = 0.0f; // 99th percentile, ingest to swap
+        float max_frame_ms = 0.0f; // 99th percentile
+        float max_rss_mb = 0.0f;
+    };
+
+    static const int64_t kMaxCameraWaitMs = 100; // Longest wait for the render loop to take an image
+    static const uint kSwapsPerImage = 2; // Frames after which an image that wasn't uploaded is given up on
+
+    ReplayBenchmark() : num_swaps_(0), finished_(false), num_messages_(0), bag_seconds_(0.0),
+            wall_seconds_(0.0) {}
+
+    void addCamera(uint id, const std::string &name);
+    void setThresholds(const Thresholds &thresholds) { thresholds_ = thresholds; }
+
+    // Called by the bag thread around playback, these sample per-thread CPU time
+    void start();
+    void finish(uint64_t num_messages, double bag_seconds);
+
+    void imageIngested(uint id, Clock::time_point time);
+    /**
+     * Blocks until the camera's last image was uploaded, or kSwapsPerImage frames
+     * went by without it, so images played as fast as possible aren't overwritten
+     * before the render loop had a chance at them. Gives up after kMaxCameraWaitMs,
+     * as on-demand pacing doesn't draw frames nothing asked for.
+     */
+    void waitForCamera(uint id);
+
+    void imageUploaded(uint id);
+    void frameSwapped();
+
+    // Per camera counts, latency and frame time percentiles, CPU time per thread
+    // and peak RSS, followed by the threshold checks
+    std::string getReport() const;
+    // False if playback never finished, or a threshold was exceeded
+    bool passed() const;
+
+private:
+    struct Camera
+    {
+        std::string name;
+        std::atomic<uint64_t> ingested, uploaded;
+        uint64_t displayed;
+
+        // Guarded by swap_mutex_, as the bag thread sets them while the render thread reads them
+        int64_t ingest_ns; // Ingest time of the image last handed to the display
+        bool ingest_pending; // Whether that image is still waiting for its upload to be counted
+        uint64_t wait_uploads, wait_swaps; // Counts when the last image was ingested
+    };
+
+    struct ThreadCpu
+    {
+        std::string name;
+        double seconds;
+    };
+
+    Thresholds thresholds_;
+    std::map<uint, std::unique_ptr<Camera>> cameras_;
+
+    std::mutex swap_mutex_; // Also guards the cameras' ingest times and wait counts
+    std::condition_variable swapped_;
+    std::atomic<uint64_t> num_swaps_;
+
+    // Render thread only
+    std::vector<std::pair<uint, int64_t>> pending_; // Camera and ingest time of images uploaded this frame
+    std::vector<float> latencies_ms_, frame_ms_;
+    Clock::time_point last_swap_;
+
+    Clock::time_point start_time_;
+    std::atomic<bool> finished_;
+    std::map<int, ThreadCpu> start_cpu_, end_cpu_;
+    uint64_t num_messages_;
+    double bag_seconds_, wall_seconds_;
+
+    // Adds a line per threshold to the report when one is given
+    bool checkThresholds(std::string *report) const;
+
+    static std::map<int, ThreadCpu> readThreadCpu();
+    static float getPeakRssMb();
+    static float percentile(std::vector<float> values, float fraction);
+};
+
+} // viewpoint_interface
+
+#endif // __REPLAY_BENCHMARK_HPP__
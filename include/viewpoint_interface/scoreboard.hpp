@@ -17,6 +17,9 @@ public:
     void addEventMessage(std::string message, int score_change=0, int timeout_secs=3);
     void draw();
 
+    // Returns: milliseconds until the next message expires, or -1 if none are shown
+    int64_t getNextExpirationMs() const;
+
 private:
     struct ScoreMessage
     {
@@ -0,0 +1,65 @@
+#ifndef __STREAM_CHECKER_HPP__
+#define __STREAM_CHECKER_HPP__
+
+#include <map>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Checks the sequence numbers of camera images that carry a frame marker
+ * (see frame_marker.hpp), as published by the synthetic_cameras node.
+ *
+ * A gap in the sequence counts as dropped frames. A frame older than the
+ * newest one seen arrived out of order; it is counted as reordered and no
+ * longer as dropped. A sequence that starts again from 0 is a restarted
+ * publisher and begins a new run. Images without a marker are ignored.
+ *
+ * Streams are added before their callbacks start. Each stream is updated
+ * from one callback at a time and read from the render thread.
+ */
+class StreamChecker
+{
+public:
+    struct Stats
+    {
+        uint64_t received, dropped, reordered, duplicates, restarts;
+        float mean_age_ms, max_age_ms; // From the header stamp to the callback
+    };
+
+    void addStream(uint id, const std::string &name);
+
+    /**
+     * Params:
+     *      id - display the image is for
+     *      seq - sequence number read from the image's marker
+     *      age_ms - time since the image was stamped, negative if unknown
+     */
+    void frameReceived(uint id, uint64_t seq, float age_ms);
+
+    bool hasFrames() const;
+    Stats getStats(uint id) const;
+    // One line per stream that received marked frames
+    std::string getSummary() const;
+    void drawPanel();
+
+private:
+    struct Stream
+    {
+        std::string name;
+        std::atomic<uint64_t> received, dropped, reordered, duplicates, restarts;
+        std::atomic<uint64_t> last_seq;
+        std::atomic<float> mean_age_ms, max_age_ms;
+    };
+
+    std::map<uint, std::unique_ptr<Stream>> streams_;
+};
+
+} // viewpoint_interface
+
+#endif // __STREAM_CHECKER_HPP__
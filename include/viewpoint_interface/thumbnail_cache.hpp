@@ -0,0 +1,88 @@
+#ifndef __THUMBNAIL_CACHE_HPP__
+#define __THUMBNAIL_CACHE_HPP__
+
+#include <map>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+
+#include <opencv2/opencv.hpp>
+
+#include "viewpoint_interface/layout.hpp"
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Small per-display textures for carousel tiles.
+ *
+ * A thumbnail is made the first time its display is requested and kept, so
+ * a tile always shows the latest thumbnail of its own camera. Requested
+ * thumbnails are refreshed in turn at a lower rate than full-size images,
+ * and no more than a fixed number of them are downscaled and uploaded per
+ * frame, whatever the number of cameras in the ribbon. Thumbnails whose
+ * tiles have been out of view for a while can be evicted to free texture
+ * memory, and are made again when they come back.
+ */
+class ThumbnailCache
+{
+public:
+    static const uint kWidth = 256;
+    static const uint kMaxRefreshesPerFrame = 2;
+
+    typedef std::chrono::steady_clock Clock;
+
+    ThumbnailCache() : refresh_period_(std::chrono::milliseconds(200)), next_refresh_(0),
+            num_refreshed_(0), num_evicted_(0) {}
+
+    void setRefreshRate(float rate);
+    // Must be called with the GL context current
+    void destroy();
+
+    /**
+     * Must be called with the GL context current.
+     *
+     * Params:
+     *      display_ids - displays whose tiles are in view
+     *      displays - source of the displays' images
+     *      responses - filled with the thumbnail texture of each requested display
+     */
+    void update(const std::vector<uint> &display_ids, const DisplayManager &displays,
+            std::vector<DisplayImageResponse> &responses);
+
+    /**
+     * Must be called with the GL context current. Deletes thumbnails that weren't
+     * requested for at least min_age, least recently requested first, until the
+     * given number of bytes is freed. Returns the bytes freed, and the displays
+     * whose thumbnails went in evicted_ids.
+     */
+    uint64_t evictCold(Clock::duration min_age, uint64_t bytes, std::vector<uint> &evicted_ids);
+
+    uint getNumThumbnails() const { return thumbnails_.size(); }
+    uint getNumRefreshed() const { return num_refreshed_; } // Last update only
+    uint64_t getNumEvicted() const { return num_evicted_; }
+    uint64_t getTotalBytes() const;
+
+private:
+    struct Thumbnail
+    {
+        uint texture, width, height;
+        Clock::time_point refreshed, requested;
+        int64_t source_ns; // Arrival time of the image it was made from, as DisplayInfo::last_frame_ns
+    };
+
+    Clock::duration refresh_period_;
+    std::map<uint, Thumbnail> thumbnails_; // Keyed by display ID
+    uint next_refresh_; // Position in the request list to resume refreshing from
+    uint num_refreshed_;
+    uint64_t num_evicted_;
+    cv::Mat scaled_;
+
+    bool refresh(Thumbnail &thumbnail, const DisplayInfo &info);
+    static uint64_t getBytes(const Thumbnail &thumbnail) { return thumbnail.width * thumbnail.height * 3; }
+};
+
+} // viewpoint_interface
+
+#endif // __THUMBNAIL_CACHE_HPP__
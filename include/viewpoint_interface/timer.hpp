@@ -31,6 +31,7 @@ protected:
     Timer(int time, DurationType type) : time_(time), type_(type), initialized_(false) {}
 
     int64_t getDuration() const;
+    std::chrono::nanoseconds getLength() const;
 };
 
 class CountdownTimer : public Timer
@@ -44,6 +45,12 @@ public:
     bool acknowledgeExpiration();
     int64_t getTimeRemaining();
 
+    /**
+     * Returns: milliseconds until the timer expires, 0 if it has run out but
+     *      timerExpired() hasn't been called yet, or -1 if it isn't running.
+     */
+    int64_t getMillisecondsRemaining() const;
+
 private:
     bool expired_, acknowledged_;
 };
@@ -0,0 +1,107 @@
+#ifndef __UPLOAD_SCHEDULER_HPP__
+#define __UPLOAD_SCHEDULER_HPP__
+
+#include <map>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+
+#include "viewpoint_interface/layout.hpp"
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Decides which full-size display images are uploaded each frame.
+ *
+ * Images that haven't changed since their last upload are never uploaded
+ * again. By default every display is uploaded whenever it has a new image.
+ * Throttling is opt-in: a primary rate limits the non-active Primary
+ * displays, and a secondary rate, scale and per-frame byte budget let
+ * Secondary displays (PiP windows) refresh less often, downscaled, and only
+ * while the budget lasts, oldest first, so a burst of camera images can't
+ * stretch the frame. A secondary display that has been deferred for
+ * kMaxDeferrals frames in a row is uploaded regardless, so none of them
+ * starve behind the primary displays.
+ *
+ * Carousel tiles aren't scheduled here, see ThumbnailCache.
+ */
+class UploadScheduler
+{
+public:
+    static const uint kMaxDeferrals = 10;
+    static const uint kWindowSize = 120; // Frames the budget utilisation is averaged over
+
+    struct Stats
+    {
+        uint num_requests, num_uploaded, num_unchanged, num_held, num_deferred;
+        uint64_t bytes_uploaded;
+    };
+
+    UploadScheduler() : primary_period_(Clock::duration::zero()),
+            secondary_period_(Clock::duration::zero()), secondary_scale_(1.0f), budget_bytes_(0),
+            stats_(), total_uploaded_(0), total_deferred_(0), utilisation_sum_(0.0f), peak_utilisation_(0.0f),
+            next_sample_(0) {}
+
+    // Rates in Hz, 0 refreshes the displays whenever they change. The active frame is never limited
+    void setPrimaryRate(float rate) { primary_period_ = rateToPeriod(rate); }
+    void setSecondaryRate(float rate) { secondary_period_ = rateToPeriod(rate); }
+    // Fraction of their width and height Secondary displays are uploaded at
+    void setSecondaryScale(float scale) { secondary_scale_ = scale; }
+    float getUploadScale(UploadPriority priority) const
+    {
+        return (priority == UploadPriority::Secondary) ? secondary_scale_ : 1.0f;
+    }
+    // Bytes uploaded per frame before Secondary displays are deferred, 0 for no budget
+    void setBudget(uint64_t bytes) { budget_bytes_ = bytes; }
+    // The display is uploaded at its next request as if it was seen for the first time
+    void forgetDisplay(uint display_id) { states_.erase(display_id); }
+
+    /**
+     * Returns the positions in queue of the requests to upload this frame,
+     * most urgent first. They are assumed to be uploaded before the next call.
+     *
+     * Params:
+     *      queue - this frame's requests
+     *      displays - source of the displays' image sizes and arrival times
+     */
+    const std::vector<uint>& schedule(const std::vector<DisplayImageRequest> &queue,
+            const DisplayManager &displays);
+
+    // True if a display has an image waiting that was held back or deferred
+    bool hasPendingUploads() const { return stats_.num_held != 0 || stats_.num_deferred != 0; }
+    const Stats& getStats() const { return stats_; } // Last schedule only
+    void drawPanel();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct DisplayState
+    {
+        Clock::time_point uploaded;
+        int64_t source_ns; // Arrival time of the image last uploaded, as DisplayInfo::last_frame_ns
+        uint deferrals; // Consecutive frames it was deferred for the budget
+    };
+
+    Clock::duration primary_period_, secondary_period_;
+    float secondary_scale_;
+    uint64_t budget_bytes_;
+    std::map<uint, DisplayState> states_; // Keyed by display ID
+
+    std::vector<uint> candidates_, uploads_;
+    Stats stats_;
+    uint64_t total_uploaded_, total_deferred_;
+
+    std::vector<float> utilisation_; // Fraction of the budget used, per frame
+    float utilisation_sum_, peak_utilisation_;
+    uint next_sample_;
+
+    static Clock::duration rateToPeriod(float rate);
+    Clock::duration getPeriod(UploadPriority priority) const;
+    void addUtilisationSample(float utilisation);
+};
+
+} // viewpoint_interface
+
+#endif // __UPLOAD_SCHEDULER_HPP__
@@ -0,0 +1,85 @@
+#ifndef __VIEW_PUBLISHER_HPP__
+#define __VIEW_PUBLISHER_HPP__
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+#include "ros/ros.h"
+
+#include "viewpoint_interface/frame_capture.hpp"
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Publishes a low-rate, downsampled copy of the composited operator view for
+ * remote observers, as sensor_msgs/Image (rgb8) or sensor_msgs/CompressedImage
+ * (jpeg).
+ *
+ * The GPU does the downsampling and FrameCapture the readback, so the render
+ * loop never waits on either. Conversion, encoding and publishing happen on
+ * a worker thread, which only ever holds the latest frame: a frame that
+ * hasn't been picked up yet is replaced rather than queued. Nothing is
+ * captured while the topic has no subscribers.
+ */
+class ViewPublisher
+{
+public:
+    ViewPublisher() : rate_(0.0f), compressed_(false), publishing_(false), stopping_(false),
+            has_pending_(false), frames_published_(0), frames_replaced_(0) {}
+    ~ViewPublisher() { stop(); }
+
+    /**
+     * Must be called with the GL context current.
+     *
+     * Params:
+     *      node - node used to advertise the topic
+     *      topic - image topic; the compressed stream is published on topic + "/compressed"
+     *      rate - publishing rate in Hz
+     *      width - width of published images, height follows the framebuffer's aspect ratio
+     *      compressed - publish jpeg instead of raw images
+     *      src_width, src_height - current framebuffer size
+     */
+    bool start(ros::NodeHandle &node, const std::string &topic, float rate, uint width, bool compressed,
+            int src_width, int src_height);
+    void stop();
+    bool isPublishing() const { return publishing_; }
+
+    // Call after the frame has been rendered and before it is swapped
+    void frameRendered(int src_width, int src_height);
+
+    void drawPanel();
+
+private:
+    static const int kJpegQuality = 80;
+
+    FrameCapture capture_;
+    ros::Publisher pub_;
+    float rate_;
+    bool compressed_;
+    FrameCapture::Clock::time_point next_capture_;
+    bool publishing_;
+
+    // Worker thread
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable frame_ready_;
+    bool stopping_;
+    bool has_pending_;
+    std::vector<uint8_t> pending_;
+    ros::Time pending_stamp_;
+
+    std::atomic<uint64_t> frames_published_;
+    std::atomic<uint64_t> frames_replaced_;
+
+    void publishFrames();
+};
+
+} // viewpoint_interface
+
+#endif // __VIEW_PUBLISHER_HPP__
@@ -0,0 +1,113 @@
+#ifndef __VIEW_RECORDER_HPP__
+#define __VIEW_RECORDER_HPP__
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <condition_variable>
+
+#include <sys/types.h>
+
+#include "viewpoint_interface/frame_capture.hpp"
+
+
+namespace viewpoint_interface
+{
+
+/**
+ * Records the composited operator view to a video file. Captures are taken
+ * at a fixed rate with FrameCapture and encoded on a writer thread, so the
+ * render loop only pays for issuing the readback and copying out finished
+ * frames.
+ *
+ * Files ending in .y4m are written directly as YUV4MPEG2 (4:2:0). Anything
+ * else is piped to ffmpeg, which must be on the PATH. When rendering falls
+ * behind the recording rate the previous frame is repeated, so the video
+ * stays in step with wall-clock time.
+ */
+class ViewRecorder
+{
+public:
+    ViewRecorder() :
+            fps_(0),
+            recording_(false),
+            stopping_(false),
+            use_ffmpeg_(false),
+            ffmpeg_(NULL),
+            ffmpeg_pid_(-1),
+            frames_written_(0),
+            frames_repeated_(0),
+            writer_drops_(0),
+            write_failed_(false),
+            overhead_ema_ms_(0.0f),
+            overhead_max_ms_(0.0f) {}
+    ~ViewRecorder() { stop(); }
+
+    /**
+     * Must be called with the GL context current.
+     *
+     * Params:
+     *      path - output file
+     *      scale - output size relative to the framebuffer
+     *      fps - recording rate
+     *      src_width, src_height - current framebuffer size
+     */
+    bool start(const std::string &path, float scale, uint fps, int src_width, int src_height);
+    void stop();
+    bool isRecording() const { return recording_; }
+
+    // Call after the frame has been rendered and before it is swapped
+    void frameRendered(int src_width, int src_height);
+
+    std::string getSummary() const;
+    void drawPanel();
+
+private:
+    static const uint kMaxQueuedFrames = 8;
+
+    struct Frame
+    {
+        std::vector<uint8_t> data;
+        FrameCapture::Clock::time_point stamp;
+    };
+
+    FrameCapture capture_;
+    std::string path_;
+    uint fps_;
+    FrameCapture::Clock::time_point next_capture_;
+    bool recording_;
+
+    // Writer thread
+    std::thread writer_;
+    std::mutex mutex_;
+    std::condition_variable frame_ready_;
+    std::deque<Frame> queue_;
+    std::vector<std::vector<uint8_t>> free_buffers_;
+    bool stopping_;
+
+    bool use_ffmpeg_;
+    FILE *ffmpeg_; // Write end of ffmpeg's stdin
+    pid_t ffmpeg_pid_;
+    std::ofstream y4m_;
+
+    // Stats
+    std::atomic<uint64_t> frames_written_;
+    std::atomic<uint64_t> frames_repeated_;
+    std::atomic<uint64_t> writer_drops_;
+    std::atomic<bool> write_failed_; // The file or ffmpeg stopped taking frames, the rest are discarded
+    float overhead_ema_ms_;
+    float overhead_max_ms_;
+
+    void queueFrame(const uint8_t *data, uint width, uint height, FrameCapture::Clock::time_point stamp);
+    void writeFrames();
+    bool writeEncoded(const std::vector<uint8_t> &encoded);
+};
+
+} // viewpoint_interface
+
+#endif // __VIEW_RECORDER_HPP__
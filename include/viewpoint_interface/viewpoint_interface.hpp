@@ -4,6 +4,9 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
 
 #include "ros/ros.h"
 
@@ -19,7 +22,25 @@
 #include "viewpoint_interface/display.hpp"
 #include "viewpoint_interface/layout.hpp"
 #include "viewpoint_interface/layout_manager.hpp"
+#include "viewpoint_interface/layout_config.hpp"
 #include "viewpoint_interface/scene_camera.hpp"
+#include "viewpoint_interface/latency_tracker.hpp"
+#include "viewpoint_interface/frame_pacer.hpp"
+#include "viewpoint_interface/frame_arena.hpp"
+#include "viewpoint_interface/offscreen_context.hpp"
+#include "viewpoint_interface/view_recorder.hpp"
+#include "viewpoint_interface/view_publisher.hpp"
+#include "viewpoint_interface/display_compositor.hpp"
+#include "viewpoint_interface/thumbnail_cache.hpp"
+#include "viewpoint_interface/upload_scheduler.hpp"
+#include "viewpoint_interface/quality_governor.hpp"
+#include "viewpoint_interface/profiler.hpp"
+#include "viewpoint_interface/gpu_timer.hpp"
+#include "viewpoint_interface/stream_checker.hpp"
+#include "viewpoint_interface/input_log.hpp"
+#include "viewpoint_interface/replay_benchmark.hpp"
+#include "viewpoint_interface/memory_tracker.hpp"
+#include "viewpoint_interface/pipeline_stats.hpp"
 
 
 namespace viewpoint_interface
@@ -50,6 +71,90 @@ namespace viewpoint_interface
         uint def_disp_height = 720;
         uint def_disp_channels = 3;
         const std::string CONTR_NAME = "vive_controller";
+
+        // Latency measurement - a positive number of test commands enables the
+        // built-in test, which injects that many synthetic controller packets
+        int latency_test_commands = 0;
+        uint latency_test_period_ms = 100;
+        std::string latency_csv_file;
+
+        // Input recording/replay - while replaying, live external inputs are ignored
+        std::string record_inputs_file;
+        std::string replay_inputs_file;
+        bool replay_max_speed = false;
+        bool replay_exit_on_end = false;
+
+        // Bag replay benchmark - plays the camera, matrix and robot state topics of a bag into the
+        // interface in place of its subscriptions, prints a report and exits. A rate of 0 plays
+        // images as fast as the render loop takes them, 1 plays in real time
+        std::string bag_file;
+        float bag_rate = 0.0f;
+        // The run fails with a non-zero exit status above any of these, 0 doesn't check
+        float bench_max_latency_ms = 0.0f;
+        float bench_max_frame_ms = 0.0f;
+        float bench_max_rss_mb = 0.0f;
+
+        // Frame pacing - one of "vsync", "adaptive", "uncapped", "on_demand" or "fixed" (loop_rate)
+        std::string frame_pacing = "vsync";
+
+        // Headless mode renders offscreen at the given resolution instead of
+        // opening a window. A positive frame count exits after that many frames
+        bool headless = false;
+        int headless_width = 1920;
+        int headless_height = 1080;
+        int headless_frames = 0;
+
+        // Operator view recording - disabled when no file is given. Files ending
+        // in .y4m are written directly, anything else is encoded by ffmpeg
+        std::string record_view_file;
+        float record_view_scale = 0.5f;
+        int record_view_fps = 30;
+
+        // Live operator view on /viewpoint_interface/operator_view - a rate of 0 disables it
+        float publish_view_rate = 0.0f;
+        int publish_view_width = 640;
+        bool publish_view_compressed = true;
+
+        // Draw all camera images in one instanced pass instead of one ImGui
+        // image per display
+        bool batched_compositor = true;
+
+        // Primary displays beyond this many are split into pages (0 shows all at once)
+        int max_displays_per_page = 9;
+
+        // Carousel thumbnails are refreshed at this rate in Hz, full-size images at the camera rate
+        float thumbnail_rate = 5.0f;
+
+        // PiP displays are refreshed at this rate in Hz (0 for every new image), the
+        // active frame and primary displays whenever they change
+        float secondary_upload_rate = 0.0f;
+        // Full-size image bytes uploaded per frame before PiP displays wait (0 for no limit)
+        float upload_budget_mb = 0.0f;
+
+        // Lower PiP and non-active display quality in stages while frames run over
+        // governor_target_ms (0 follows the frame pacing target)
+        bool quality_governor = false;
+        float governor_target_ms = 0.0f;
+
+        // Record profiler zones from startup, they can also be switched on from the control panel
+        bool profiler = false;
+
+        // Length of traces captured with the T key, the capture_trace command or the ~capture_trace
+        // service, and the directory they are written to
+        float trace_seconds = 5.0f;
+        std::string trace_dir = "/tmp";
+
+        // Above this many MB of textures, those of displays and carousel tiles that haven't been
+        // on screen for a while are deleted, coldest first (0 for no cap)
+        float texture_memory_mb = 0.0f;
+        // Layouts keep their settings while inactive, up to this many (0 keeps them all)
+        int max_cached_layouts = 0;
+
+        // Camera and render loop health on /diagnostics - a rate of 0 disables it
+        float diagnostics_rate = 1.0f;
+
+        // Extra layouts, reloaded whenever the file changes - empty disables them
+        std::string layout_config_file = "resources/config/layout_config.json";
     };
 
 
@@ -61,7 +166,11 @@ namespace viewpoint_interface
         static constexpr float WIDTH_FAC = 1.0f;
         static constexpr float HEIGHT_FAC = 1.0f;
 
-        App(AppParams params=AppParams()) : node_("~"), app_params_(params), spinner_(ros::AsyncSpinner(0)) {}
+        App(AppParams params=AppParams()) : app_params_(params), last_frame_allocations_(0), input_frame_(0),
+                next_replay_event_(0), replay_frame_shift_(0), node_("~"), spinner_(ros::AsyncSpinner(0)),
+                window_(NULL), close_requested_(false), headless_frame_count_(0), governor_snapshot_(),
+                governor_snapshot_version_(0), memory_snapshot_(), memory_snapshot_version_(0),
+                num_evicted_textures_(0) {}
 
         int run(int argc, char *argv[]);
 
@@ -72,7 +181,29 @@ namespace viewpoint_interface
         AppParams app_params_;
         Socket socket_;
         LayoutManager layouts_;
+        LayoutConfigWatcher layout_config_;
         bool clutch_mode_;
+        LatencyTracker latency_;
+        InputRecorder input_recorder_;
+        FramePacer frame_pacer_;
+        uint64_t last_frame_allocations_; // Heap allocations made by the render thread
+        std::atomic<uint64_t> input_frame_; // Frames started, recorded with each input
+        std::vector<InputEvent> replay_events_;
+        size_t next_replay_event_;
+        int64_t replay_frame_shift_; // Frames skipped at max speed replay
+        std::chrono::steady_clock::time_point replay_start_;
+
+        // Inputs from the controller and ROS threads wait here for the render
+        // thread, which is the only one that changes the layouts
+        struct PendingInput
+        {
+            InputEventType type;
+            std::string payload;
+            LatencyTracker::TimePoint stamp;
+        };
+        std::mutex pending_inputs_mutex_;
+        std::vector<PendingInput> pending_inputs_; // Guarded by pending_inputs_mutex_
+        std::vector<PendingInput> applied_inputs_; // Swapped with pending_inputs_, so both keep their capacity
 
         // ROS
         ros::NodeHandle node_;
@@ -90,41 +221,91 @@ namespace viewpoint_interface
         ros::Publisher mouse_pos_normalized_;
         ros::Publisher mouse_buttons_;
         ros::Publisher mouse_scroll_;
+        ros::Publisher diagnostics_pub_;
+        ros::ServiceServer capture_trace_srv_;
 
         // GUI
         GLFWwindow* window_;
         GLFWmonitor *monitor_;
         ImGuiIO io_;
+        OffscreenContext offscreen_;
+        ViewRecorder view_recorder_;
+        ViewPublisher view_publisher_;
+        DisplayCompositor compositor_;
+        ThumbnailCache thumbnails_;
+        std::vector<DisplayImageResponse> thumbnail_responses_; // Reused each frame
+        UploadScheduler upload_scheduler_;
+        QualityGovernor governor_;
+        cv::Mat scaled_upload_; // Reused each frame for images the governor has uploaded below full size
+        GpuTimer gpu_timer_;
+        StreamChecker stream_checker_;
+        ReplayBenchmark bag_bench_;
+        PipelineStats pipeline_stats_;
+        std::chrono::steady_clock::time_point last_diagnostics_time_;
+        std::chrono::steady_clock::time_point last_memory_time_;
+        std::atomic<bool> close_requested_; // Only used headless, GLFW tracks this for windows
+        uint64_t headless_frame_count_;
+        std::chrono::steady_clock::time_point last_headless_frame_; // Epoch until the first headless frame
 
         enum AppCommand
         {
             NONE,
             CLOSE_WINDOW,
             TOGGLE_CONTROL_PANEL,
-            TOGGLE_BUTTONS_PANEL
+            TOGGLE_BUTTONS_PANEL,
+            CAPTURE_TRACE
         };
 
         // General program flow
         bool initialize();
         bool parseConfigFile(std::string config_data);
         bool initializeSocket();
+        void initializeParams();
         void initializeROS();
         bool initializeGlfw();
+        bool initializeOffscreen();
         void initializeImGui();
+        void initializeViewCapture();
+        void initializeCompositor();
         void shutdownApp();
 
+        // On-demand drawing
+        static const int64_t kMaxIdleMs = 500; // Longest idle wait before checking for shutdown
+        void requestRedraw();
+        bool waitForRedraw();
+
+        // Window/offscreen target abstraction
+        bool shouldClose() const;
+        void requestClose();
+        void getFramebufferSize(int *width, int *height) const;
+        void newImGuiFrame();
+        void presentFrame();
+
         // Input handling
         void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
         const AppCommand translateStringInputToCommand(std::string input) const;
-        void handleCommandString(std::string command);
-        void parseControllerInput(std::string data);
+        void handleCommandString(std::string command, LatencyTracker::TimePoint stamp,
+                LatencyTracker::CommandSource source);
+        void parseControllerInput(std::string data, LatencyTracker::TimePoint stamp);
         void handleControllerInput();
+        void runLatencyTest();
+        void handleInputEvent(InputEventType type, const std::string &payload, LatencyTracker::TimePoint stamp);
+        // Manual commands that don't change what is drawn, so they're taken during replays
+        bool isControlCommand(InputEventType type, const std::string &payload) const;
+        void applyPendingInputs();
+        void dispatchInputEvent(InputEventType type, const std::string &payload, LatencyTracker::TimePoint stamp);
+        void applyReplayedInputs();
+        bool isReplaying() const { return !app_params_.replay_inputs_file.empty(); }
+        void playBag();
+        bool isPlayingBag() const { return !app_params_.bag_file.empty(); }
         static glm::ivec2 getWindowDimensions(GLFWwindow* window);
         static void handleMousePosition(GLFWwindow* window, double x_pos, double y_pos);
         static void handleMouseButtons(GLFWwindow* window, int button, int action, int mods);
         static void handleMouseScroll(GLFWwindow* window, double x_offset, double y_offset);
 
         void cameraImageCallback(const sensor_msgs::ImageConstPtr& msg, uint id);
+        // Shared by the subscribers and the bag player
+        void ingestCameraImage(const sensor_msgs::ImageConstPtr& msg, uint id);
         void cameraMatrixCallback(const std_msgs::Float32MultiArrayConstPtr& msg, uint id);
         void graspingCallback(const std_msgs::BoolConstPtr& msg);
         void clutchingCallback(const std_msgs::BoolConstPtr& msg);
@@ -136,6 +317,55 @@ namespace viewpoint_interface
         void publishDisplayBounds();
         static void keyCallbackForwarding(GLFWwindow* window, int key, int scancode, int action, int mods);
         void handleDisplayImageQueue();
+        void handleThumbnailQueue();
+        void applyLayoutConfigUpdates();
+        void updateQualityGovernor();
+        void applyQualityStage();
+        void publishDiagnostics();
+        void publishGovernorDiagnostics(uint64_t &published_version);
+
+        // Diagnostics are built and published on their own thread, from
+        // snapshots the render thread takes, so ROS serialization stays out of the frame
+        struct GovernorSnapshot
+        {
+            QualityGovernor::Stage stage;
+            bool enabled;
+            float work_ms, target_ms;
+            uint64_t num_transitions;
+            std::string transition;
+        };
+        std::mutex diagnostics_mutex_;
+        GovernorSnapshot governor_snapshot_; // Guarded by diagnostics_mutex_
+        uint64_t governor_snapshot_version_; // Guarded by diagnostics_mutex_, 0 before the first snapshot
+        struct MemorySnapshot
+        {
+            uint64_t num_evicted_textures, num_evicted_thumbnails, num_evicted_layouts;
+            uint num_cached_layouts;
+            uint64_t evictable_texture_bytes;
+        };
+        MemorySnapshot memory_snapshot_; // Guarded by diagnostics_mutex_
+        uint64_t memory_snapshot_version_; // Guarded by diagnostics_mutex_
+
+        // Memory accounting
+        static const int kColdTextureSeconds = 5; // Off screen this long before a texture may be evicted
+        struct DisplayTexture
+        {
+            uint id;
+            uint64_t bytes; // Size of the last upload
+            std::chrono::steady_clock::time_point drawn; // Last frame the display was on screen
+        };
+        std::map<uint, DisplayTexture> display_textures_; // Keyed by display ID
+        uint64_t num_evicted_textures_;
+        void updateMemoryAccounting();
+        void evictColdTextures(std::chrono::steady_clock::time_point now);
+        uint64_t getEvictableTextureBytes() const; // Display textures and thumbnails
+        void publishMemoryDiagnostics(uint64_t &published_version);
+
+        // Tracing
+        std::vector<uint64_t> displayed_flows_; // Camera frames uploaded this frame
+        void requestTraceCapture();
+        bool captureTraceService(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res);
+        uint64_t getFrameFlowId(uint display_id) const;
     };
 
 } // viewpoint_interface
@@ -0,0 +1,11 @@
+#version 330 core
+in vec3 TexCoord;
+
+uniform sampler2DArray uDisplays;
+
+out vec4 FragColor;
+
+void main()
+{
+	FragColor = vec4(texture(uDisplays, TexCoord).rgb, 1.0);
+}
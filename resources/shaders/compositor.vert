@@ -0,0 +1,18 @@
+#version 330 core
+layout (location = 0) in vec4 aRect;    // x, y, width, height in window pixels
+layout (location = 1) in vec4 aTexRect; // u0, v0, u1, v1 within the layer
+layout (location = 2) in float aLayer;
+
+uniform vec2 uViewportSize;
+
+out vec3 TexCoord;
+
+void main()
+{
+	// Triangle strip corners: (0,0), (1,0), (0,1), (1,1)
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	vec2 pos = aRect.xy + (corner * aRect.zw);
+
+	gl_Position = vec4((pos.x / uViewportSize.x) * 2.0 - 1.0, 1.0 - (pos.y / uViewportSize.y) * 2.0, 0.0, 1.0);
+	TexCoord = vec3(mix(aTexRect.xy, aTexRect.zw, corner), aLayer);
+}
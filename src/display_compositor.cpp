@@ -0,0 +1,188 @@
+#include <glad/glad.h>
+
+#include "viewpoint_interface/shader.hpp"
+#include "viewpoint_interface/display_compositor.hpp"
+#include "viewpoint_interface/memory_tracker.hpp"
+
+
+namespace viewpoint_interface
+{
+
+// Per-instance attributes: rect (4), texture rect (4), layer (1)
+static const uint kFloatsPerInstance = 9;
+
+DisplayCompositor::DisplayCompositor() : viewport_size_loc_(-1), texture_array_(0), vao_(0), instance_vbo_(0),
+        layer_width_(0), layer_height_(0), texture_bytes_(0), num_quads_drawn_(0) {}
+
+DisplayCompositor::~DisplayCompositor() {}
+
+bool DisplayCompositor::init(const DisplayManager &displays)
+{
+    uint num_displays(displays.getNumTotalDisplays());
+    if (num_displays == 0) {
+        return false;
+    }
+
+    GLint max_layers;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    if (num_displays > (uint)max_layers) {
+        return false;
+    }
+
+    for (uint i(0); i < num_displays; ++i) {
+        const DisplayDims &dims(displays.getDisplayInfo(i).dimensions);
+        layer_width_ = std::max(layer_width_, dims.width);
+        layer_height_ = std::max(layer_height_, dims.height);
+    }
+    if (layer_width_ == 0 || layer_height_ == 0) {
+        return false;
+    }
+
+    for (uint i(0); i < num_displays; ++i) {
+        const DisplayInfo &info(displays.getDisplayInfo(i));
+        if (info.dimensions.width == 0 || info.dimensions.height == 0) {
+            continue;
+        }
+        layers_[info.id] = Layer{ i, (float)info.dimensions.width / layer_width_,
+                (float)info.dimensions.height / layer_height_ };
+    }
+
+    // Shader only prints its errors, so a program that didn't link is caught here
+    shader_.reset(new Shader("resources/shaders/compositor.vert", "resources/shaders/compositor.frag"));
+    GLint linked(GL_FALSE);
+    glGetProgramiv(shader_->ID, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE) {
+        glDeleteProgram(shader_->ID);
+        shader_.reset();
+        layers_.clear();
+        return false;
+    }
+    shader_->use();
+    shader_->setInt("uDisplays", 0); // The texture array is always bound to unit 0
+    viewport_size_loc_ = glGetUniformLocation(shader_->ID, "uViewportSize");
+    glUseProgram(0);
+
+    glGenTextures(1, &texture_array_);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture_array_);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB8, layer_width_, layer_height_, num_displays, 0, GL_RGB,
+            GL_UNSIGNED_BYTE, NULL);
+    texture_bytes_ = (uint64_t)layer_width_ * layer_height_ * 3 * num_displays;
+    MemoryTracker::add(MemoryTracker::Category::Textures, texture_bytes_);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &instance_vbo_);
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+
+    GLsizei stride(kFloatsPerInstance * sizeof(float));
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(4 * sizeof(float)));
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, (void*)(8 * sizeof(float)));
+    for (GLuint attrib(0); attrib < 3; ++attrib) {
+        glEnableVertexAttribArray(attrib);
+        glVertexAttribDivisor(attrib, 1);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return true;
+}
+
+void DisplayCompositor::destroy()
+{
+    if (!isInitialized()) {
+        return;
+    }
+
+    glDeleteTextures(1, &texture_array_);
+    MemoryTracker::add(MemoryTracker::Category::Textures, -(int64_t)texture_bytes_);
+    texture_bytes_ = 0;
+    glDeleteBuffers(1, &instance_vbo_);
+    glDeleteVertexArrays(1, &vao_);
+    glDeleteProgram(shader_->ID);
+    shader_.reset();
+    texture_array_ = 0;
+    layers_.clear();
+}
+
+bool DisplayCompositor::uploadDisplay(uint display_id, uint width, uint height, const uchar *data)
+{
+    std::map<uint, Layer>::iterator layer(layers_.find(display_id));
+    if (layer == layers_.end() || width == 0 || height == 0 || width > layer_width_ ||
+            height > layer_height_) {
+        return false;
+    }
+
+    // Images may be uploaded below their full size, so the layer is sampled
+    // to the size of the last upload
+    layer->second.u_max = (float)width / layer_width_;
+    layer->second.v_max = (float)height / layer_height_;
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture_array_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer->second.index, width, height, 1, GL_RGB,
+            GL_UNSIGNED_BYTE, (GLvoid*)data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    return true;
+}
+
+void DisplayCompositor::draw(const std::vector<DisplayQuad> &quads, float viewport_width, float viewport_height)
+{
+    num_quads_drawn_ = 0;
+    if (!isInitialized() || quads.empty()) {
+        return;
+    }
+
+    instance_data_.clear();
+    for (const DisplayQuad &quad : quads) {
+        std::map<uint, Layer>::const_iterator layer(layers_.find(quad.display_id));
+        if (layer == layers_.end()) {
+            continue;
+        }
+
+        const float instance[kFloatsPerInstance] = {
+            quad.pos.x, quad.pos.y, quad.size.x, quad.size.y,
+            0.0f, 0.0f, layer->second.u_max, layer->second.v_max,
+            (float)layer->second.index
+        };
+        instance_data_.insert(instance_data_.end(), instance, instance + kFloatsPerInstance);
+        ++num_quads_drawn_;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+    glBufferData(GL_ARRAY_BUFFER, instance_data_.size() * sizeof(float), instance_data_.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Cameras are opaque and always sit beneath the UI
+    GLboolean depth_test(glIsEnabled(GL_DEPTH_TEST)), blend(glIsEnabled(GL_BLEND));
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+
+    shader_->use();
+    glUniform2f(viewport_size_loc_, viewport_width, viewport_height);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture_array_);
+    glBindVertexArray(vao_);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, num_quads_drawn_);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glUseProgram(0);
+
+    if (depth_test) {
+        glEnable(GL_DEPTH_TEST);
+    }
+    if (blend) {
+        glEnable(GL_BLEND);
+    }
+}
+
+} // viewpoint_interface
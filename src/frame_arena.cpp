@@ -0,0 +1,83 @@
+#include <new>
+#include <cstdlib>
+#include <algorithm>
+
+#include "viewpoint_interface/frame_arena.hpp"
+
+
+namespace viewpoint_interface
+{
+
+FrameArena::FrameArena(size_t capacity) : buffer_(new char[capacity]), capacity_(capacity), offset_(0), peak_(0),
+        num_overflows_(0) {}
+
+FrameArena::~FrameArena()
+{
+    reset();
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment)
+{
+    uintptr_t base(reinterpret_cast<uintptr_t>(buffer_.get()));
+    size_t start((base + offset_ + alignment - 1) / alignment * alignment - base);
+
+    if (start + bytes > capacity_) {
+        ++num_overflows_;
+        void *block(::operator new(bytes));
+        overflow_blocks_.push_back(block);
+        return block;
+    }
+
+    offset_ = start + bytes;
+    peak_ = std::max(peak_, offset_);
+    return buffer_.get() + start;
+}
+
+void FrameArena::reset()
+{
+    for (void *block : overflow_blocks_) {
+        ::operator delete(block);
+    }
+    overflow_blocks_.clear();
+    offset_ = 0;
+}
+
+FrameArena& getFrameArena()
+{
+    static FrameArena arena;
+    return arena;
+}
+
+
+// --- Heap allocation counting ---
+
+static thread_local uint64_t thread_heap_allocations(0);
+
+uint64_t getThreadHeapAllocations()
+{
+    return thread_heap_allocations;
+}
+
+} // viewpoint_interface
+
+
+// Replacing the global allocation functions is the only way to see
+// allocations made inside the standard library and other dependencies
+static void* countedAlloc(size_t size)
+{
+    ++viewpoint_interface::thread_heap_allocations;
+
+    void *ptr(std::malloc(size == 0 ? 1 : size));
+    if (ptr == NULL) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
@@ -0,0 +1,136 @@
+#include <glad/glad.h>
+
+#include "viewpoint_interface/frame_capture.hpp"
+#include "viewpoint_interface/memory_tracker.hpp"
+
+
+namespace viewpoint_interface
+{
+
+bool FrameCapture::init(uint width, uint height, uint ring_size)
+{
+    destroy();
+
+    width_ = width;
+    height_ = height;
+
+    glGenRenderbuffers(1, &color_rbo_);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_rbo_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width_, height_);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    MemoryTracker::add(MemoryTracker::Category::PixelBuffers, (int64_t)width_ * height_ * 4);
+
+    GLint prev_draw;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prev_draw);
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo_);
+    glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_rbo_);
+    bool complete(glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, prev_draw);
+
+    if (!complete) {
+        destroy();
+        return false;
+    }
+
+    slots_.resize(ring_size);
+    for (Slot &slot : slots_) {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, width_ * height_ * kChannels, NULL, GL_STREAM_READ);
+        MemoryTracker::add(MemoryTracker::Category::PixelBuffers, (int64_t)width_ * height_ * kChannels);
+        slot.fence = NULL;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    next_slot_ = 0;
+    oldest_slot_ = 0;
+    num_dropped_ = 0;
+
+    return true;
+}
+
+void FrameCapture::destroy()
+{
+    for (Slot &slot : slots_) {
+        if (slot.fence) {
+            glDeleteSync((GLsync)slot.fence);
+        }
+        glDeleteBuffers(1, &slot.pbo);
+        MemoryTracker::add(MemoryTracker::Category::PixelBuffers, -(int64_t)width_ * height_ * kChannels);
+    }
+    slots_.clear();
+
+    if (fbo_ != 0) {
+        glDeleteFramebuffers(1, &fbo_);
+        glDeleteRenderbuffers(1, &color_rbo_);
+        MemoryTracker::add(MemoryTracker::Category::PixelBuffers, -(int64_t)width_ * height_ * 4);
+        fbo_ = 0;
+        color_rbo_ = 0;
+    }
+}
+
+bool FrameCapture::capture(int src_width, int src_height, Clock::time_point stamp)
+{
+    if (!isInitialized()) {
+        return false;
+    }
+
+    Slot &slot(slots_.at(next_slot_));
+    if (slot.fence) {
+        ++num_dropped_;
+        return false;
+    }
+
+    GLint prev_read, prev_draw;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prev_read);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prev_draw);
+
+    // Destination rows are swapped so the image comes out top-down
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, prev_draw);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo_);
+    glBlitFramebuffer(0, 0, src_width, src_height, 0, height_, width_, 0, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.stamp = stamp;
+    next_slot_ = (next_slot_ + 1) % slots_.size();
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, prev_read);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, prev_draw);
+
+    return true;
+}
+
+void FrameCapture::collect(const FrameHandler &handler)
+{
+    // Readbacks finish in the order they were issued
+    while (!slots_.empty() && slots_[oldest_slot_].fence) {
+        Slot &slot(slots_[oldest_slot_]);
+
+        GLenum status(glClientWaitSync((GLsync)slot.fence, 0, 0));
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+        glDeleteSync((GLsync)slot.fence);
+        slot.fence = NULL;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        const uint8_t *data((const uint8_t *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                width_ * height_ * kChannels, GL_MAP_READ_BIT));
+        if (data) {
+            handler(data, width_, height_, slot.stamp);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        oldest_slot_ = (oldest_slot_ + 1) % slots_.size();
+    }
+}
+
+} // viewpoint_interface
@@ -0,0 +1,278 @@
+#include <cmath>
+#include <thread>
+#include <algorithm>
+
+#include <imgui/imgui.h>
+
+#include "viewpoint_interface/frame_pacer.hpp"
+
+
+namespace viewpoint_interface
+{
+
+static const char* kModeNames[] = { "fixed", "vsync", "adaptive", "uncapped", "on_demand" };
+
+bool FramePacer::stringToMode(const std::string &name, Mode &mode)
+{
+    for (int i(0); i < IM_ARRAYSIZE(kModeNames); ++i) {
+        if (name == kModeNames[i]) {
+            mode = (Mode)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* FramePacer::modeToString(Mode mode)
+{
+    return kModeNames[(int)mode];
+}
+
+int FramePacer::getSwapInterval() const
+{
+    Mode mode(mode_);
+    return (mode == Mode::VSync || mode == Mode::OnDemand) ? 1 : 0;
+}
+
+void FramePacer::setMode(Mode mode)
+{
+    if (mode == Mode::OnDemand && !on_demand_available_) {
+        return;
+    }
+
+    if (mode != mode_) {
+        mode_ = mode;
+        swap_interval_dirty_ = true;
+        redraw_requested_ = true;
+    }
+}
+
+void FramePacer::setRefreshRate(float hz)
+{
+    if (hz > 0.0f) {
+        refresh_rate_ = hz;
+    }
+}
+
+bool FramePacer::consumeSwapIntervalChange(int &interval)
+{
+    if (!swap_interval_dirty_) {
+        return false;
+    }
+
+    swap_interval_dirty_ = false;
+    interval = getSwapInterval();
+    return true;
+}
+
+float FramePacer::getTargetRate() const
+{
+    switch (mode_)
+    {
+        case Mode::Fixed:
+        {
+            return fixed_rate_;
+        }   break;
+
+        case Mode::VSync:
+        {
+            return refresh_rate_;
+        }   break;
+
+        case Mode::Adaptive:
+        {
+            // No point drawing faster than the screen or slower than is usable
+            if (camera_rate_ <= 0.0f) {
+                return fixed_rate_;
+            }
+            return std::max(kMinAdaptiveRate, std::min(camera_rate_, refresh_rate_));
+        }   break;
+
+        case Mode::Uncapped:
+        case Mode::OnDemand:
+        {
+            return 0.0f;
+        }   break;
+    }
+
+    return fixed_rate_;
+}
+
+void FramePacer::waitForFrameStart()
+{
+    if (!first_frame_) {
+        float target_rate(getTargetRate());
+        Clock::time_point wake_time(Clock::now());
+
+        switch (mode_)
+        {
+            case Mode::Fixed:
+            case Mode::Adaptive:
+            {
+                std::chrono::duration<float> period(1.0f / target_rate);
+                wake_time = frame_start_ + std::chrono::duration_cast<Clock::duration>(period);
+            }   break;
+
+            case Mode::VSync:
+            {
+                // Late-latch: leave just enough time to build and render the frame
+                // before the next vblank, so input and images are as fresh as possible
+                std::chrono::duration<float, std::milli> lead(1000.0f / target_rate - work_ema_ms_ - kLatchMarginMs);
+                if (lead.count() > 0.0f) {
+                    wake_time = last_swap_ + std::chrono::duration_cast<Clock::duration>(lead);
+                }
+            }   break;
+
+            case Mode::Uncapped:
+            case Mode::OnDemand:
+            {
+            }   break;
+        }
+
+        if (wake_time > Clock::now()) {
+            std::this_thread::sleep_until(wake_time);
+        }
+    }
+
+    frame_start_ = Clock::now();
+}
+
+void FramePacer::frameRendered()
+{
+    // Measured up to here, the swap's wait for vblank would make every frame
+    // look like it took the whole period
+    std::chrono::duration<float, std::milli> work(Clock::now() - frame_start_);
+    work_ema_ms_ = first_frame_ ? work.count() : (0.9f * work_ema_ms_) + (0.1f * work.count());
+}
+
+void FramePacer::frameSwapped()
+{
+    Clock::time_point now(Clock::now());
+
+    if (!first_frame_) {
+        std::chrono::duration<float, std::milli> frame_time(now - last_swap_);
+        float target_rate(getTargetRate());
+        bool missed(target_rate > 0.0f && frame_time.count() > kMissFactor * (1000.0f / target_rate));
+
+        if (frame_times_ms_.size() < kWindowSize) {
+            frame_times_ms_.push_back(frame_time.count());
+            missed_.push_back(missed);
+        }
+        else {
+            frame_times_ms_[next_sample_] = frame_time.count();
+            missed_[next_sample_] = missed;
+        }
+        next_sample_ = (next_sample_ + 1) % kWindowSize;
+
+        if (missed) {
+            ++missed_total_;
+        }
+    }
+
+    if (first_frame_) {
+        rate_start_ = now;
+    }
+    last_swap_ = now;
+    first_frame_ = false;
+
+    ++rate_frames_;
+    std::chrono::duration<float> rate_elapsed(now - rate_start_);
+    if (rate_elapsed.count() >= 1.0f) {
+        redraw_rate_ = rate_frames_ / rate_elapsed.count();
+        rate_frames_ = 0;
+        rate_start_ = now;
+    }
+}
+
+bool FramePacer::requestRedraw()
+{
+    redraw_requested_ = true;
+
+    // The flag is set before checking idle_, and the main loop sets idle_
+    // before checking the flag, so one of the two always sees the other
+    return mode_ == Mode::OnDemand && idle_;
+}
+
+bool FramePacer::needsRedraw()
+{
+    if (redraw_requested_.exchange(false)) {
+        settle_frames_ = kSettleFrames;
+    }
+
+    if (settle_frames_ > 0) {
+        --settle_frames_;
+        return true;
+    }
+
+    // Idle for a whole measurement window, so the last rate no longer applies.
+    // Measuring starts over with the next frame
+    Clock::time_point now(Clock::now());
+    if (!first_frame_ && now - last_swap_ >= std::chrono::seconds(1)) {
+        redraw_rate_ = 0.0f;
+        rate_frames_ = 0;
+        rate_start_ = now;
+    }
+
+    return false;
+}
+
+FramePacer::Stats FramePacer::getStats() const
+{
+    Stats stats{0.0f, 0.0f, 0.0f, 0, missed_total_};
+    if (frame_times_ms_.empty()) {
+        return stats;
+    }
+
+    float total(0.0f);
+    for (uint i(0); i < frame_times_ms_.size(); ++i) {
+        total += frame_times_ms_[i];
+        stats.max_ms = std::max(stats.max_ms, frame_times_ms_[i]);
+        if (missed_[i]) {
+            ++stats.missed_in_window;
+        }
+    }
+    stats.mean_ms = total / frame_times_ms_.size();
+
+    float variance(0.0f);
+    for (float frame_time : frame_times_ms_) {
+        variance += (frame_time - stats.mean_ms) * (frame_time - stats.mean_ms);
+    }
+    stats.std_dev_ms = std::sqrt(variance / frame_times_ms_.size());
+
+    return stats;
+}
+
+void FramePacer::drawPanel()
+{
+    // OnDemand is the last mode, so it can be left off the end of the list
+    int num_modes(IM_ARRAYSIZE(kModeNames) - (on_demand_available_ ? 0 : 1));
+    int mode((int)getMode());
+    if (ImGui::Combo("Pacing", &mode, kModeNames, num_modes)) {
+        setMode((Mode)mode);
+    }
+
+    float target_rate(getTargetRate());
+    if (target_rate > 0.0f) {
+        ImGui::Text("Target: %.1f Hz (%.2f ms)", target_rate, 1000.0f / target_rate);
+    }
+    else {
+        ImGui::Text("Target: uncapped");
+    }
+
+    Stats stats(getStats());
+    ImGui::Text("Frame time: %.2f ms mean, %.2f ms std dev, %.2f ms max", stats.mean_ms,
+            stats.std_dev_ms, stats.max_ms);
+    ImGui::Text("Missed deadlines: %u in last %u frames (%llu total)", stats.missed_in_window,
+            (uint)frame_times_ms_.size(), (unsigned long long)stats.missed_total);
+    ImGui::Text("Build + render: %.2f ms", work_ema_ms_);
+    ImGui::Text("Effective redraw rate: %.1f Hz", redraw_rate_);
+
+    if (!frame_times_ms_.empty()) {
+        ImGui::PlotLines("##Frame times", frame_times_ms_.data(), frame_times_ms_.size(),
+                frame_times_ms_.size() < kWindowSize ? 0 : next_sample_, NULL, 0.0f,
+                std::max(50.0f, stats.max_ms), ImVec2(0, 60.0f));
+    }
+}
+
+} // viewpoint_interface
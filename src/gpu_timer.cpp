@@ -0,0 +1,195 @@
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <imgui/imgui.h>
+
+#include "viewpoint_interface/gpu_timer.hpp"
+#include "viewpoint_interface/profiler.hpp"
+
+
+namespace viewpoint_interface
+{
+
+const uint GpuTimer::kFrameLatency;
+const uint GpuTimer::kMaxQueriesPerFrame;
+
+void GpuTimer::destroy()
+{
+    if (!initialized_) {
+        return;
+    }
+
+    for (FrameQueries &frame : frames_) {
+        glDeleteQueries(kMaxQueriesPerFrame, frame.ids);
+        frame.num_issued = 0;
+    }
+    initialized_ = false;
+}
+
+void GpuTimer::frameMark()
+{
+    if (!initialized_) {
+        for (FrameQueries &frame : frames_) {
+            glGenQueries(kMaxQueriesPerFrame, frame.ids);
+            frame.num_issued = 0;
+        }
+        initialized_ = true;
+    }
+
+    if (active_ != NULL) {
+        end();
+    }
+
+    // The oldest frame's queries are reused for this one, so read them first
+    next_frame_ = (next_frame_ + 1) % kFrameLatency;
+    FrameQueries &frame(frames_[next_frame_]);
+    readFrame(frame);
+    frame.num_issued = 0;
+
+    enabled_ = always_on_ || Profiler::isEnabled();
+}
+
+void GpuTimer::begin(const char *stage)
+{
+    if (!enabled_ || !initialized_ || active_ != NULL) {
+        return;
+    }
+
+    FrameQueries &frame(frames_[next_frame_]);
+    if (frame.num_issued == kMaxQueriesPerFrame) {
+        ++num_overflows_;
+        return;
+    }
+
+    frame.stages[frame.num_issued] = stage;
+    glBeginQuery(GL_TIME_ELAPSED, frame.ids[frame.num_issued]);
+    ++frame.num_issued;
+    active_ = stage;
+}
+
+void GpuTimer::end()
+{
+    if (active_ == NULL) {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+    active_ = NULL;
+}
+
+bool GpuTimer::getStageMs(const char *stage, float &mean_ms) const
+{
+    auto found(stages_.find(stage));
+    if (found == stages_.end()) {
+        return false;
+    }
+
+    mean_ms = found->second.mean_ms;
+    return true;
+}
+
+bool GpuTimer::getFrameMs(float &mean_ms) const
+{
+    if (!enabled_ || stages_.empty()) {
+        return false;
+    }
+
+    mean_ms = frame_mean_ms_;
+    return true;
+}
+
+void GpuTimer::drawPanel()
+{
+    if (!enabled_) {
+        ImGui::Text("GPU stages are timed while the profiler is enabled");
+    }
+    if (stages_.empty()) {
+        return;
+    }
+
+    ImGui::Text("GPU: %.3f ms per frame, late results: %llu, overflows: %llu", frame_total_ms_,
+            (unsigned long long)num_late_, (unsigned long long)num_overflows_);
+
+    if (ImGui::BeginTable("##GpuStages", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Stage");
+        ImGui::TableSetupColumn("CPU mean ms");
+        ImGui::TableSetupColumn("GPU last ms");
+        ImGui::TableSetupColumn("GPU mean ms");
+        ImGui::TableSetupColumn("GPU max ms");
+        ImGui::TableHeadersRow();
+
+        for (const auto &stage : stages_) {
+            const StageStats &stats(stage.second);
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", stage.first);
+            ImGui::TableNextColumn();
+            float cpu_ms;
+            if (getProfiler().getZoneMeanMs(stage.first, cpu_ms)) {
+                ImGui::Text("%.3f", cpu_ms);
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.last_ms);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.mean_ms);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.max_ms);
+        }
+        ImGui::EndTable();
+    }
+}
+
+
+// --- Private ---
+
+void GpuTimer::readFrame(FrameQueries &frame)
+{
+    if (frame.num_issued == 0) {
+        return;
+    }
+
+    for (auto &stage : stages_) {
+        stage.second.frame_ms = 0.0f;
+        stage.second.in_frame = false;
+    }
+
+    float total_ms(0.0f);
+    for (uint i(0); i < frame.num_issued; ++i) {
+        GLint available(0);
+        glGetQueryObjectiv(frame.ids[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            ++num_late_;
+            continue;
+        }
+
+        GLuint64 elapsed_ns(0);
+        glGetQueryObjectui64v(frame.ids[i], GL_QUERY_RESULT, &elapsed_ns);
+        float elapsed_ms(elapsed_ns / 1.0e6f);
+
+        auto stage(stages_.find(frame.stages[i]));
+        if (stage == stages_.end()) {
+            StageStats stats = {};
+            stage = stages_.emplace(frame.stages[i], stats).first;
+            stage->second.mean_ms = elapsed_ms;
+        }
+        stage->second.frame_ms += elapsed_ms;
+        stage->second.in_frame = true;
+        total_ms += elapsed_ms;
+    }
+
+    for (auto &stage : stages_) {
+        StageStats &stats(stage.second);
+        if (!stats.in_frame) {
+            continue;
+        }
+
+        stats.last_ms = stats.frame_ms;
+        stats.mean_ms = (0.95f * stats.mean_ms) + (0.05f * stats.frame_ms);
+        stats.max_ms = std::max(stats.max_ms, stats.frame_ms);
+    }
+    frame_mean_ms_ = (frame_mean_ms_ == 0.0f) ? total_ms : (0.95f * frame_mean_ms_) + (0.05f * total_ms);
+    frame_total_ms_ = total_ms;
+}
+
+} // viewpoint_interface
@@ -0,0 +1,140 @@
+#include <cstring>
+
+#include "viewpoint_interface/input_log.hpp"
+
+
+namespace viewpoint_interface
+{
+
+static const char kLogMagic[4] = { 'V', 'P', 'I', 'L' };
+static const uint32_t kLogVersion = 2;
+static const uint32_t kMaxPayloadSize = 1 << 20; // Larger sizes can only come from a corrupt log
+
+// --- InputRecorder ---
+
+bool InputRecorder::open(const std::string &path)
+{
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+        return false;
+    }
+
+    file_.write(kLogMagic, sizeof(kLogMagic));
+    file_.write(reinterpret_cast<const char *>(&kLogVersion), sizeof(kLogVersion));
+
+    start_ = std::chrono::steady_clock::now();
+    recording_ = true;
+
+    return true;
+}
+
+void InputRecorder::close()
+{
+    if (recording_) {
+        file_.close();
+        recording_ = false;
+    }
+}
+
+void InputRecorder::record(InputEventType type, uint64_t frame, const std::string &payload)
+{
+    if (!recording_) {
+        return;
+    }
+
+    uint8_t type_val((uint8_t)type);
+    int64_t time_ns(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count());
+    uint32_t size(payload.size());
+
+    file_.write(reinterpret_cast<const char *>(&type_val), sizeof(type_val));
+    file_.write(reinterpret_cast<const char *>(&time_ns), sizeof(time_ns));
+    file_.write(reinterpret_cast<const char *>(&frame), sizeof(frame));
+    file_.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    file_.write(payload.data(), size);
+}
+
+
+// --- Loading ---
+
+// Active display and robot state inputs are a single byte, other inputs are strings
+static bool isPayloadSizeValid(InputEventType type, uint32_t size)
+{
+    switch (type)
+    {
+        case InputEventType::ActiveDisplay:
+        case InputEventType::Grasping:
+        case InputEventType::Clutching:
+        {
+            return size == 1;
+        }
+
+        default:
+        {
+            return size <= kMaxPayloadSize;
+        }
+    }
+}
+
+bool loadInputLog(const std::string &path, std::vector<InputEvent> &events, std::string &error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        error = "can't be opened";
+        return false;
+    }
+
+    char magic[sizeof(kLogMagic)];
+    uint32_t version;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(&version), sizeof(version));
+    if (!file || std::memcmp(magic, kLogMagic, sizeof(kLogMagic)) != 0) {
+        error = "isn't an input log";
+        return false;
+    }
+    if (version != kLogVersion) {
+        error = "is version " + std::to_string(version) + ", expected " + std::to_string(kLogVersion);
+        return false;
+    }
+
+    std::vector<InputEvent> loaded;
+    while (file.peek() != std::ifstream::traits_type::eof()) {
+        std::string record("record " + std::to_string(loaded.size()));
+        uint8_t type_val;
+        InputEvent event;
+        uint32_t size;
+
+        file.read(reinterpret_cast<char *>(&type_val), sizeof(type_val));
+        file.read(reinterpret_cast<char *>(&event.time_ns), sizeof(event.time_ns));
+        file.read(reinterpret_cast<char *>(&event.frame), sizeof(event.frame));
+        file.read(reinterpret_cast<char *>(&size), sizeof(size));
+        if (!file) {
+            error = record + " is truncated";
+            return false;
+        }
+
+        if (type_val > (uint8_t)InputEventType::Collision) {
+            error = record + " has unknown input type " + std::to_string(type_val);
+            return false;
+        }
+        event.type = (InputEventType)type_val;
+        if (!isPayloadSizeValid(event.type, size)) {
+            error = record + " has a " + std::to_string(size) + " byte payload, which is the wrong size for its type";
+            return false;
+        }
+
+        event.payload.resize(size);
+        file.read(&event.payload[0], size);
+        if (!file) {
+            error = record + " is truncated";
+            return false;
+        }
+
+        loaded.push_back(event);
+    }
+
+    events.insert(events.end(), loaded.begin(), loaded.end());
+    return true;
+}
+
+} // viewpoint_interface
@@ -0,0 +1,180 @@
+#include <fstream>
+#include <algorithm>
+
+#include <imgui/imgui.h>
+
+#include "viewpoint_interface/latency_tracker.hpp"
+
+
+namespace viewpoint_interface
+{
+
+static const char* sourceToString(LatencyTracker::CommandSource source)
+{
+    switch (source)
+    {
+        case LatencyTracker::CommandSource::Controller:
+        {
+            return "controller";
+        }   break;
+
+        case LatencyTracker::CommandSource::Manual:
+        {
+            return "manual";
+        }   break;
+
+        case LatencyTracker::CommandSource::Keyboard:
+        {
+            return "keyboard";
+        }   break;
+    }
+
+    return "unknown";
+}
+
+// Quoted as in RFC 4180, so commas, quotes and newlines in commands keep their column
+static std::string quoteCsvField(const std::string &field)
+{
+    std::string quoted("\"");
+    for (char c : field) {
+        if (c == '"') {
+            quoted += '"';
+        }
+        quoted += c;
+    }
+    quoted += '"';
+
+    return quoted;
+}
+
+void LatencyTracker::commandApplied(const std::string &command, TimePoint stamp, CommandSource source)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(PendingCommand{command, stamp, source});
+}
+
+void LatencyTracker::frameStarted()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Commands applied while the previous frame was being built may not have
+    // made it into that frame, so they are only latched once a new one starts
+    in_flight_.insert(in_flight_.end(), pending_.begin(), pending_.end());
+    pending_.clear();
+}
+
+void LatencyTracker::frameSwapped()
+{
+    TimePoint swap_time(now());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const PendingCommand &cmd : in_flight_) {
+        std::chrono::duration<double, std::milli> latency(swap_time - cmd.stamp);
+        Sample sample{cmd.source, cmd.command, latency.count()};
+
+        if (samples_.size() < window_size_) {
+            samples_.push_back(sample);
+        }
+        else {
+            samples_[next_sample_] = sample;
+        }
+        next_sample_ = (next_sample_ + 1) % window_size_;
+    }
+    in_flight_.clear();
+}
+
+LatencyTracker::Summary LatencyTracker::getSummary() const
+{
+    Summary summary{0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+    std::vector<double> latencies;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        latencies.reserve(samples_.size());
+        for (const Sample &sample : samples_) {
+            latencies.push_back(sample.latency_ms);
+        }
+    }
+
+    if (latencies.empty()) {
+        return summary;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double pct) {
+        uint ix((uint)(pct * (latencies.size() - 1)));
+        return latencies.at(ix);
+    };
+
+    double total(0.0);
+    for (double latency : latencies) {
+        total += latency;
+    }
+
+    summary.count = latencies.size();
+    summary.mean_ms = total / latencies.size();
+    summary.p50_ms = percentile(0.50);
+    summary.p95_ms = percentile(0.95);
+    summary.p99_ms = percentile(0.99);
+    summary.max_ms = latencies.back();
+
+    return summary;
+}
+
+bool LatencyTracker::exportCsv(const std::string &path) const
+{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file << "source,command,latency_ms\n";
+    for (const Sample &sample : getOrderedSamples()) {
+        file << sourceToString(sample.source) << "," << quoteCsvField(sample.command) << "," << sample.latency_ms << "\n";
+    }
+
+    return true;
+}
+
+void LatencyTracker::drawPanel(const std::string &csv_path)
+{
+    float bins[kNumBins] = {};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Sample &sample : samples_) {
+            uint bin(sample.latency_ms / kBinWidthMs);
+            bins[std::min(bin, kNumBins-1)] += 1.0f;
+        }
+    }
+
+    Summary summary(getSummary());
+    ImGui::Text("Commands measured: %u", summary.count);
+    ImGui::Text("Mean %.1f ms | p50 %.1f | p95 %.1f | p99 %.1f | max %.1f", summary.mean_ms,
+            summary.p50_ms, summary.p95_ms, summary.p99_ms, summary.max_ms);
+
+    std::string overlay("0-" + std::to_string((int)(kNumBins * kBinWidthMs)) + " ms");
+    ImGui::PlotHistogram("##Input latency", bins, kNumBins, 0, overlay.c_str(), 0.0f, 3.4e38f,
+            ImVec2(0, 80.0f));
+
+    if (!csv_path.empty() && ImGui::Button("Export CSV")) {
+        exportCsv(csv_path);
+    }
+}
+
+
+// --- Private ---
+
+std::vector<LatencyTracker::Sample> LatencyTracker::getOrderedSamples() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (samples_.size() < window_size_) {
+        return samples_;
+    }
+
+    std::vector<Sample> ordered(samples_.begin() + next_sample_, samples_.end());
+    ordered.insert(ordered.end(), samples_.begin(), samples_.begin() + next_sample_);
+
+    return ordered;
+}
+
+} // viewpoint_interface
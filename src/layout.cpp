@@ -1,3 +1,8 @@
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
 #include "viewpoint_interface/layout.hpp"
 
 
@@ -5,10 +10,11 @@ namespace viewpoint_interface {
 
 // --- Public ---
 
-const std::string Layout::getLayoutName() const
+const std::string& Layout::getLayoutName() const
 {
+    static const std::string kInactiveName("Layouts Inactive");
     if (layout_type_ == LayoutType::INACTIVE) {
-        return "Layouts Inactive";
+        return kInactiveName;
     }
 
     return kLayoutNames[(uint)layout_type_];
@@ -32,7 +38,7 @@ const std::vector<float>& Layout::getActiveDisplayMatrix() const
     return displays_.getDisplayMatrixById(display_states_.getActiveFrameDisplayId());
 }
 
-const std::vector<float> Layout::getDisplayBounds() const
+const std::vector<float>& Layout::getDisplayBounds() const
 {
     return display_bounds_;
 }
@@ -47,7 +53,24 @@ void Layout::pushImageResponse(const DisplayImageResponse &response)
     image_response_queue_.push_back(response);
 }
 
-void Layout::handleKeyInput(int key, int action, int mods)
+void Layout::forgetImage(uint display_id)
+{
+    image_response_queue_.erase(std::remove_if(image_response_queue_.begin(), image_response_queue_.end(),
+            [display_id](const DisplayImageResponse &response) { return response.getDisplayId() == display_id; }),
+            image_response_queue_.end());
+    display_states_.getDisplayRing().removeImageForId(display_id);
+}
+
+void Layout::forgetThumbnail(uint display_id)
+{
+    thumbnail_response_queue_.erase(std::remove_if(thumbnail_response_queue_.begin(),
+            thumbnail_response_queue_.end(),
+            [display_id](const DisplayImageResponse &response) { return response.getDisplayId() == display_id; }),
+            thumbnail_response_queue_.end());
+    display_states_.getDisplayRing().removeThumbnailForId(display_id);
+}
+
+bool Layout::handleKeyInput(int key, int action, int mods)
 {
     if (action == GLFW_PRESS) {
         switch (key) {
@@ -71,6 +94,16 @@ void Layout::handleKeyInput(int key, int action, int mods)
                 toNextDisplay(LayoutDisplayRole::Secondary);
             }   break;
 
+            case GLFW_KEY_PAGE_DOWN:
+            {
+                display_states_.toNextPage();
+            }   break;
+
+            case GLFW_KEY_PAGE_UP:
+            {
+                display_states_.toPrevPage();
+            }   break;
+
             case GLFW_KEY_TAB:
             {
                 if (mods && GLFW_MOD_SHIFT) {
@@ -83,12 +116,17 @@ void Layout::handleKeyInput(int key, int action, int mods)
 
             default:
             {
-            } break;
+                return false;
+            }
         }
+
+        return true;
     }
+
+    return false;
 }
 
-const LayoutCommand Layout::translateStringInputToCommand(std::string input) const
+const LayoutCommand Layout::translateStringInputToCommand(std::string input)
 {
     if (input == "primary_next") {
         return LayoutCommand::PRIMARY_NEXT;
@@ -135,14 +173,31 @@ const LayoutCommand Layout::translateStringInputToCommand(std::string input) con
     else if (input == "active_down_left") {
         return LayoutCommand::ACTIVE_FRAME_DOWN_LEFT;       
     }
+    else if (input == "page_next") {
+        return LayoutCommand::PAGE_NEXT;
+    }
+    else if (input == "page_prev") {
+        return LayoutCommand::PAGE_PREV;
+    }
 
     return LayoutCommand::INVALID_COMMAND;
 }
 
-void Layout::handleStringInput(std::string input)
+bool Layout::handleStringInput(std::string input)
 {
-    LayoutCommand command(translateStringInputToCommand(input));
+    return handleLayoutCommand(translateStringInputToCommand(input));
+}
+
+void Layout::handleCollisionMessage(const std::string &message)
+{
+    // TODO: Implement this
+}
 
+
+// --- Protected ---
+
+bool Layout::handleLayoutCommand(LayoutCommand command)
+{
     switch(command)
     {
         case LayoutCommand::PRIMARY_NEXT:
@@ -207,21 +262,25 @@ void Layout::handleStringInput(std::string input)
             display_states_.handleActiveFrameDirectionInput(LayoutCommand::ACTIVE_FRAME_LEFT);
         }   break;
 
-        default:
+        case LayoutCommand::PAGE_NEXT:
         {
+            display_states_.toNextPage();
+        }   break;
 
+        case LayoutCommand::PAGE_PREV:
+        {
+            display_states_.toPrevPage();
         }   break;
+
+        default:
+        {
+            return false;
+        }
     }
-}
 
-void Layout::handleCollisionMessage(const std::string &message)
-{
-    // TODO: Implement this
+    return true;
 }
 
-
-// --- Protected ---
-
 void Layout::handleImageResponse()
 {
     for (int i(0); i < image_response_queue_.size(); ++i) {
@@ -230,6 +289,12 @@ void Layout::handleImageResponse()
     }
 
     image_response_queue_.clear();
+
+    Layout::DisplayRing &ring(display_states_.getDisplayRing());
+    for (const DisplayImageResponse &response : thumbnail_response_queue_) {
+        ring.addThumbnailResponseForId(response.getDisplayId(), response.getGLId());
+    }
+    thumbnail_response_queue_.clear();
 }
 
 void Layout::enableDisplayStyle(LayoutDisplayRole role)
@@ -319,16 +384,53 @@ void Layout::toPrevDisplayWithPush(LayoutDisplayRole role)
     display_states_.toPrevDisplay(role);
 }
 
+int64_t Layout::getNextDeadlineMs() const
+{
+    // Keep drawing until the carousel has finished scrolling
+    if (carousel_scroll_.pos != carousel_scroll_.target) {
+        return 0;
+    }
+
+    return scoreboard_.getNextExpirationMs();
+}
+
 void Layout::addImageRequestToQueue(DisplayImageRequest request)
 {
     display_image_queue_.push_back(request);
 }
 
+void Layout::addFullSizeDisplay(uint id, UploadPriority priority)
+{
+    // A display drawn in more than one place is uploaded at its most urgent priority
+    for (std::pair<uint, UploadPriority> &display : full_size_displays_) {
+        if (display.first == id) {
+            display.second = std::min(display.second, priority);
+            return;
+        }
+    }
+
+    full_size_displays_.emplace_back(id, priority);
+}
+
 void Layout::addLayoutComponent(LayoutComponent::Type type, LayoutComponent::Spacing spacing,
         LayoutComponent::Positioning positioning, float width, float height, ImVec2 offset)
 {
+    // Layouts add their components every frame; keep the existing one (and
+    // the geometry derived from it) unless its arguments changed
+    uint ix(num_components_added_++);
+    if (ix < layout_components_.size()) {
+        if (layout_components_[ix].wasCreatedWith(type, spacing, positioning, width, height, offset)) {
+            return;
+        }
+
+        while (layout_components_.size() > ix) {
+            layout_components_.pop_back();
+        }
+    }
+
     layout_components_.push_back(LayoutComponent(*this, type, spacing, positioning, width, height,
         offset));
+    geometry_dirty_ = true;
 }
 
 void displayWarningMessage(std::string message)
@@ -351,6 +453,13 @@ void Layout::drawLayoutComponents()
 {
     handleImageResponse();
 
+    // Components that weren't added again this frame were dropped by the layout
+    while (layout_components_.size() > num_components_added_) {
+        layout_components_.pop_back();
+        geometry_dirty_ = true;
+    }
+    num_components_added_ = 0;
+
     // Check that there is exactly one primary window (which could contain
     // multiple displays)
     LayoutComponent *primary_window;
@@ -370,6 +479,50 @@ void Layout::drawLayoutComponents()
         return;
     }
 
+    if (isGeometryStale()) {
+        updateGeometry(*primary_window);
+    }
+
+    full_size_displays_.clear();
+    for (LayoutComponent& component : layout_components_) {
+        component.draw();
+    }
+
+    // Prepare for next frame. Displays that are off-page, only shown as
+    // carousel thumbnails or not shown at all don't need their full images
+    for (const std::pair<uint, UploadPriority> &display : full_size_displays_) {
+        uint disp_id(display.first);
+        std::vector<uchar>& disp_data(displays_.getDisplayDataById(disp_id));
+        const DisplayInfo& disp_info(displays_.getDisplayInfoById(disp_id));
+        addImageRequestToQueue(DisplayImageRequest{disp_info.dimensions.width, disp_info.dimensions.height,
+                disp_data, disp_id, display.second});
+    }
+}
+
+bool Layout::isGeometryStale()
+{
+    ImGuiViewport* main_viewport(ImGui::GetMainViewport());
+    ImVec2 work_pos(main_viewport->GetWorkPos()), work_size(main_viewport->GetWorkSize());
+    uint ring_generation(display_states_.getDisplayRing().getGeneration());
+
+    bool stale(geometry_dirty_);
+    stale |= work_pos.x != geometry_work_pos_.x || work_pos.y != geometry_work_pos_.y;
+    stale |= work_size.x != geometry_work_size_.x || work_size.y != geometry_work_size_.y;
+    stale |= ring_generation != geometry_ring_generation_;
+
+    // The active frame moved to another page
+    const DisplayGrid &grid(display_states_.getDisplayGrid());
+    stale |= grid.num_pages > 1 && !grid.isOnPage(display_states_.getDisplayRing().getActiveFrameIndex());
+
+    geometry_work_pos_ = work_pos;
+    geometry_work_size_ = work_size;
+    geometry_ring_generation_ = ring_generation;
+
+    return stale;
+}
+
+void Layout::updateGeometry(LayoutComponent &primary_window)
+{
     // Initial parameters for work area
     ImGuiViewport* main_viewport(ImGui::GetMainViewport());
     ImVec2 work_size(main_viewport->GetWorkSize());
@@ -420,38 +573,24 @@ void Layout::drawLayoutComponents()
         }
     }
 
-    primary_window->setWidth(work_size.x);
-    primary_window->setHeight(work_size.y);
-    primary_window->setOffset(work_offset);
+    primary_window.setWidth(work_size.x);
+    primary_window.setHeight(work_size.y);
+    primary_window.setOffset(work_offset);
+    display_states_.setDisplayGrid(primary_window.getDisplayGrid());
+    primary_rects_ = primary_window.getPrimaryDisplayRects();
 
-    // Update bounds and draw all components
-    std::vector<float> bounds;
+    display_bounds_.clear();
     for (LayoutComponent& component : layout_components_) {
-        std::vector<float> cur_bounds(component.getDisplayBounds());
-        for (int j(0); j < cur_bounds.size(); ++j) {
-            bounds.push_back(cur_bounds[j]);
-        }
-
-        component.draw();
+        component.updateDisplayBounds();
+        const std::vector<float> &cur_bounds(component.getDisplayBounds());
+        display_bounds_.insert(display_bounds_.end(), cur_bounds.begin(), cur_bounds.end());
     }
-    display_bounds_ = bounds;
 
-    // Clean up and prepare for next frame
-    auto it(display_states_.loopStart());
-    for (; it != display_states_.loopEnd(); ++it) {
-        uint disp_id(it->first);
-        std::vector<uchar>& disp_data(displays_.getDisplayDataById(disp_id));
-        const DisplayInfo& disp_info(displays_.getDisplayInfoById(disp_id));
-        addImageRequestToQueue(DisplayImageRequest{disp_info.dimensions.width, disp_info.dimensions.height,
-                disp_data, disp_id});
-    }
-
-    layout_components_.clear();
+    geometry_dirty_ = false;
 }
 
-void Layout::displayStateValues(std::map<std::string, bool> states) const
+void Layout::displayStateValues(const StateList &states) const
 {
-    std::string title = "States";
     ImGuiWindowFlags win_flags = 0;
     win_flags |= ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs;
     win_flags |= ImGuiWindowFlags_NoBackground;
@@ -460,42 +599,31 @@ void Layout::displayStateValues(std::map<std::string, bool> states) const
     ImGui::SetNextWindowPos(ImVec2(main_viewport->GetWorkPos().x + 20, 
             main_viewport->GetWorkPos().y + main_viewport->GetWorkSize().y - 80), ImGuiCond_Always);
 
-    if (startMenu(title, win_flags)) {
-        std::map<std::string, bool>::iterator itr;
-        for (itr = states.begin(); itr != states.end(); itr++) {
-            std::string full_string(itr->first);
-            std::size_t hash_pos(full_string.find('#'));
-            std::string title(full_string.substr(0, hash_pos));
+    if (startMenu("States", win_flags)) {
+        for (const std::pair<const char*, bool> &state : states) {
+            const char *full_string(state.first);
+            const char *hash(std::strchr(full_string, '#'));
+            int title_len(hash != NULL ? hash - full_string : std::strlen(full_string));
 
-            ImGui::Text("%s: ", title.c_str());
+            ImGui::Text("%.*s: ", title_len, full_string);
             ImGui::SameLine();
-            bool state(itr->second);
-            ImVec4 state_color(state ? kOnColor : kOffColor);
-
-            std::string state_val;
-            if (hash_pos != std::string::npos) {
-                auto toUppercase = [](std::string str) {
-                    std::string out_str;
-                    for (int i(0); i < str.size(); ++i) {
-                        out_str += std::toupper(str.at(i));
-                    }
-                    return out_str;
-                };
-
-                std::string opt_string(full_string.substr(hash_pos));
-                std::size_t separ_pos(opt_string.find('_'));
-                std::string on_opt, off_opt;
-                if (opt_string.size() >= 4 && separ_pos != std::string::npos) {
-                    on_opt = opt_string.substr(1, separ_pos-1);
-                    off_opt = opt_string.substr(separ_pos+1);
+            ImVec4 state_color(state.second ? kOnColor : kOffColor);
+
+            FrameString state_val;
+            if (hash != NULL) {
+                const char *separ(std::strchr(hash, '_'));
+                if (std::strlen(hash) >= 4 && separ != NULL) {
+                    state_val = state.second ? FrameString(hash + 1, separ) : FrameString(separ + 1);
                 }
 
-                state_val = state ? toUppercase(on_opt) : toUppercase(off_opt);
+                for (char &c : state_val) {
+                    c = std::toupper(c);
+                }
             }
             else {
-                state_val = state ? "ACTIVE" : "INACTIVE";
+                state_val = state.second ? "ACTIVE" : "INACTIVE";
             }
-            ImGui::TextColored(state_color, state_val.c_str());
+            ImGui::TextColored(state_color, "%s", state_val.c_str());
         }
         endMenu();
     }
@@ -553,12 +681,13 @@ void Layout::drawDisplaySelectors()
     static ImGuiComboFlags flags(0);
     flags |= ImGuiComboFlags_PopupAlignLeft;
     if (display_states_.getPrimaryLimitNum() != -1) {
-        std::vector<uint> prim_list(ring.getDisplayRoleList(LayoutDisplayRole::Primary));
-        for (int i(0); i < prim_list.size(); ++i) {
-            std::string label("Primary Display " + std::to_string(i));
-            int cur_prim_id(prim_list.at(i));
-            std::string preview(displays_.getDisplayInternalNameById(cur_prim_id));
-            if (ImGui::BeginCombo(label.c_str(), preview.c_str(), flags))
+        DisplayRing::RoleList prim_list(ring.getDisplayRoleList(LayoutDisplayRole::Primary));
+        for (int i(0); i < prim_list->size(); ++i) {
+            char label[32];
+            std::snprintf(label, sizeof(label), "Primary Display %d", i);
+            int cur_prim_id(prim_list->at(i));
+            const std::string &preview(displays_.getDisplayInternalNameById(cur_prim_id));
+            if (ImGui::BeginCombo(label, preview.c_str(), flags))
             {
                 auto it(ring.loopStart());
                 for (; it != ring.loopEnd(); ++it) {
@@ -568,7 +697,7 @@ void Layout::drawDisplaySelectors()
                         continue;
                     }
 
-                    std::string disp_name(displays_.getDisplayInternalNameById(id_to_list));
+                    const std::string &disp_name(displays_.getDisplayInternalNameById(id_to_list));
                     if (ImGui::Selectable(disp_name.c_str(), cur_active_id) && !cur_active_id) {
                         ring.unsetDisplayRole(cur_prim_id, LayoutDisplayRole::Primary);
                         ring.setDisplayRole(id_to_list, LayoutDisplayRole::Primary);
@@ -590,12 +719,13 @@ void Layout::drawDisplaySelectors()
     }
 
     if (display_states_.getSecondaryLimitNum() != -1) {
-        std::vector<uint> sec_list(ring.getDisplayRoleList(LayoutDisplayRole::Secondary));
-        for (int i(0); i < sec_list.size(); ++i) {
-            std::string label("Secondary Display " + std::to_string(i));
-            int cur_sec_id(sec_list.at(i));
-            std::string preview(displays_.getDisplayInternalNameById(cur_sec_id));
-            if (ImGui::BeginCombo(label.c_str(), preview.c_str(), flags))
+        DisplayRing::RoleList sec_list(ring.getDisplayRoleList(LayoutDisplayRole::Secondary));
+        for (int i(0); i < sec_list->size(); ++i) {
+            char label[32];
+            std::snprintf(label, sizeof(label), "Secondary Display %d", i);
+            int cur_sec_id(sec_list->at(i));
+            const std::string &preview(displays_.getDisplayInternalNameById(cur_sec_id));
+            if (ImGui::BeginCombo(label, preview.c_str(), flags))
             {
                 auto it(ring.loopStart());
                 for (; it != ring.loopEnd(); ++it) {
@@ -605,7 +735,7 @@ void Layout::drawDisplaySelectors()
                         continue;
                     }
 
-                    std::string disp_name(displays_.getDisplayInternalNameById(id_to_list));
+                    const std::string &disp_name(displays_.getDisplayInternalNameById(id_to_list));
                     if (ImGui::Selectable(disp_name.c_str(), cur_active_id) && !cur_active_id) {
                         ring.unsetDisplayRole(cur_sec_id, LayoutDisplayRole::Secondary);
                         ring.setDisplayRole(id_to_list, LayoutDisplayRole::Secondary);
@@ -0,0 +1,507 @@
+#include <fstream>
+#include <sstream>
+#include <cctype>
+#include <cstdlib>
+#include <sys/stat.h>
+
+#include "viewpoint_interface/json.hpp"
+#include "viewpoint_interface/layout_config.hpp"
+
+using json = nlohmann::json;
+
+
+namespace viewpoint_interface
+{
+
+// --- Parsing ---
+
+static bool stringToComponentType(const std::string &name, LayoutComponent::Type &type)
+{
+    if (name == "primary") {
+        type = LayoutComponent::Type::Primary;
+    }
+    else if (name == "pip") {
+        type = LayoutComponent::Type::Pic_In_Pic;
+    }
+    else if (name == "double_pip") {
+        type = LayoutComponent::Type::Double_PiP;
+    }
+    else if (name == "carousel") {
+        type = LayoutComponent::Type::Carousel;
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
+static bool stringToSpacing(const std::string &name, LayoutComponent::Spacing &spacing)
+{
+    if (name == "auto") {
+        spacing = LayoutComponent::Spacing::Auto;
+    }
+    else if (name == "full") {
+        spacing = LayoutComponent::Spacing::Full;
+    }
+    else if (name == "horizontal") {
+        spacing = LayoutComponent::Spacing::Horizontal;
+    }
+    else if (name == "vertical") {
+        spacing = LayoutComponent::Spacing::Vertical;
+    }
+    else if (name == "floating") {
+        spacing = LayoutComponent::Spacing::Floating;
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
+static bool stringToPositioning(const std::string &name, LayoutComponent::Positioning &positioning)
+{
+    static const std::vector<std::pair<std::string, LayoutComponent::Positioning>> kPositions = {
+        { "auto", LayoutComponent::ComponentPositioning_Auto },
+        { "full", LayoutComponent::ComponentPositioning_Full },
+        { "top", LayoutComponent::ComponentPositioning_Top },
+        { "bottom", LayoutComponent::ComponentPositioning_Bottom },
+        { "left", LayoutComponent::ComponentPositioning_Left },
+        { "right", LayoutComponent::ComponentPositioning_Right },
+        { "top_left", LayoutComponent::ComponentPositioning_Top_Left },
+        { "top_right", LayoutComponent::ComponentPositioning_Top_Right },
+        { "bottom_left", LayoutComponent::ComponentPositioning_Bottom_Left },
+        { "bottom_right", LayoutComponent::ComponentPositioning_Bottom_Right }
+    };
+
+    for (const auto &position : kPositions) {
+        if (position.first == name) {
+            positioning = position.second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Handled by App::keyCallback before any layout sees them
+static bool isReservedKey(int key)
+{
+    return key == GLFW_KEY_C || key == GLFW_KEY_B || key == GLFW_KEY_T;
+}
+
+// Letters and digits are named by themselves ("P", "1"), function keys as "F1" to "F12"
+static bool stringToKey(const std::string &name, int &key)
+{
+    static const std::vector<std::pair<std::string, int>> kNamedKeys = {
+        { "space", GLFW_KEY_SPACE },
+        { "enter", GLFW_KEY_ENTER },
+        { "tab", GLFW_KEY_TAB },
+        { "left", GLFW_KEY_LEFT },
+        { "right", GLFW_KEY_RIGHT },
+        { "up", GLFW_KEY_UP },
+        { "down", GLFW_KEY_DOWN },
+        { "page_up", GLFW_KEY_PAGE_UP },
+        { "page_down", GLFW_KEY_PAGE_DOWN },
+        { "home", GLFW_KEY_HOME },
+        { "end", GLFW_KEY_END }
+    };
+
+    if (name.size() == 1) {
+        char c(std::toupper(name[0]));
+        if (c >= 'A' && c <= 'Z') {
+            key = GLFW_KEY_A + (c - 'A');
+            return true;
+        }
+        if (c >= '0' && c <= '9') {
+            key = GLFW_KEY_0 + (c - '0');
+            return true;
+        }
+        return false;
+    }
+
+    if ((name[0] == 'F' || name[0] == 'f') && std::isdigit(name[1])) {
+        // The whole rest of the name must be the number, so "F1x" isn't taken as F1
+        char *end;
+        long num(std::strtol(name.c_str() + 1, &end, 10));
+        if (*end == '\0' && num >= 1 && num <= 12) {
+            key = GLFW_KEY_F1 + (num - 1);
+            return true;
+        }
+        return false;
+    }
+
+    for (const auto &named : kNamedKeys) {
+        if (named.first == name) {
+            key = named.second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool parseNumber(const json &j, const char *field, float &value, std::string &error)
+{
+    json::const_iterator it(j.find(field));
+    if (it == j.end()) {
+        return true;
+    }
+    if (!it->is_number()) {
+        error = std::string("'") + field + "' must be a number";
+        return false;
+    }
+
+    value = it->get<float>();
+    return true;
+}
+
+static bool parseString(const json &j, const char *field, std::string &value, std::string &error)
+{
+    json::const_iterator it(j.find(field));
+    if (it == j.end()) {
+        return true;
+    }
+    if (!it->is_string()) {
+        error = std::string("'") + field + "' must be a string";
+        return false;
+    }
+
+    value = it->get<std::string>();
+    return true;
+}
+
+static bool parseBool(const json &j, const char *field, bool &value, std::string &error)
+{
+    json::const_iterator it(j.find(field));
+    if (it == j.end()) {
+        return true;
+    }
+    if (!it->is_boolean()) {
+        error = std::string("'") + field + "' must be true or false";
+        return false;
+    }
+
+    value = it->get<bool>();
+    return true;
+}
+
+static bool parseComponent(const json &j, LayoutComponentSpec &component, std::string &error)
+{
+    if (!j.is_object()) {
+        error = "components must be objects";
+        return false;
+    }
+
+    std::string type("primary"), spacing("auto"), position("auto");
+    if (!parseString(j, "type", type, error) || !parseString(j, "spacing", spacing, error) ||
+            !parseString(j, "position", position, error)) {
+        return false;
+    }
+
+    if (!stringToComponentType(type, component.type)) {
+        error = "unknown component type '" + type + "'";
+        return false;
+    }
+    if (!stringToSpacing(spacing, component.spacing)) {
+        error = "unknown spacing '" + spacing + "'";
+        return false;
+    }
+    if (!stringToPositioning(position, component.positioning)) {
+        error = "unknown position '" + position + "'";
+        return false;
+    }
+
+    component.width = 0.0f;
+    component.height = 0.0f;
+    if (!parseNumber(j, "width", component.width, error) || !parseNumber(j, "height", component.height, error)) {
+        return false;
+    }
+    if (component.width < 0.0f || component.height < 0.0f) {
+        error = "component sizes can't be negative";
+        return false;
+    }
+
+    // Offsets of -1 let the component place itself
+    component.offset = ImVec2{-1.0, -1.0};
+    json::const_iterator offset(j.find("offset"));
+    if (offset != j.end()) {
+        if (!offset->is_array() || offset->size() != 2 || !(*offset)[0].is_number() ||
+                !(*offset)[1].is_number()) {
+            error = "'offset' must be [x, y]";
+            return false;
+        }
+        component.offset = ImVec2{(*offset)[0].get<float>(), (*offset)[1].get<float>()};
+    }
+
+    component.toggled = false;
+    return parseBool(j, "toggle", component.toggled, error);
+}
+
+static bool parseLayout(const json &j, LayoutSpec &spec, std::string &error)
+{
+    if (!j.is_object()) {
+        error = "layouts must be objects";
+        return false;
+    }
+
+    if (!parseString(j, "name", spec.name, error)) {
+        return false;
+    }
+    if (spec.name.empty()) {
+        error = "layout has no name";
+        return false;
+    }
+
+    spec.num_primary = 1;
+    spec.num_secondary = 0;
+    json::const_iterator roles(j.find("roles"));
+    if (roles != j.end()) {
+        float num_primary(spec.num_primary), num_secondary(spec.num_secondary);
+        if (!roles->is_object()) {
+            error = "'roles' of " + spec.name + " must give the number of primary and secondary displays";
+            return false;
+        }
+        if (!parseNumber(*roles, "primary", num_primary, error) ||
+                !parseNumber(*roles, "secondary", num_secondary, error)) {
+            error = "in 'roles' of " + spec.name + ": " + error;
+            return false;
+        }
+        spec.num_primary = num_primary;
+        spec.num_secondary = num_secondary;
+    }
+
+    json::const_iterator components(j.find("components"));
+    if (components == j.end() || !components->is_array() || components->empty()) {
+        error = spec.name + " needs a list of components";
+        return false;
+    }
+    for (const json &component_j : *components) {
+        LayoutComponentSpec component;
+        if (!parseComponent(component_j, component, error)) {
+            error = "in components of " + spec.name + ": " + error;
+            return false;
+        }
+        spec.components.push_back(component);
+    }
+
+    json::const_iterator keys(j.find("keys"));
+    if (keys != j.end()) {
+        if (!keys->is_object()) {
+            error = "'keys' of " + spec.name + " must map key names to commands";
+            return false;
+        }
+
+        for (json::const_iterator it(keys->begin()); it != keys->end(); ++it) {
+            LayoutKeyBinding binding;
+            if (!stringToKey(it.key(), binding.key)) {
+                error = "unknown key '" + it.key() + "' in " + spec.name;
+                return false;
+            }
+            if (isReservedKey(binding.key)) {
+                error = "key '" + it.key() + "' in " + spec.name + " is reserved for the control panel (C), " +
+                        "button panel (B) and trace capture (T)";
+                return false;
+            }
+
+            binding.command = it->is_string() ? Layout::translateStringInputToCommand(it->get<std::string>()) :
+                    LayoutCommand::INVALID_COMMAND;
+            if (binding.command == LayoutCommand::INVALID_COMMAND) {
+                error = "unknown command for key '" + it.key() + "' in " + spec.name;
+                return false;
+            }
+            spec.key_bindings.push_back(binding);
+        }
+    }
+
+    spec.show_states = true;
+    return parseBool(j, "show_states", spec.show_states, error);
+}
+
+bool parseLayoutConfig(const std::string &data, std::vector<LayoutSpec> &specs, std::string &error)
+{
+    if (data.find_first_not_of(" \t\r\n") == std::string::npos) {
+        specs.clear();
+        return true;
+    }
+
+    json j(json::parse(data, nullptr, false));
+    if (j.is_discarded()) {
+        error = "not valid JSON";
+        return false;
+    }
+
+    json::const_iterator layouts(j.find("layouts"));
+    if (!j.is_object() || layouts == j.end() || !layouts->is_array()) {
+        error = "expected an object with a list of 'layouts'";
+        return false;
+    }
+
+    std::vector<LayoutSpec> parsed;
+    for (const json &layout_j : *layouts) {
+        LayoutSpec spec;
+        if (!parseLayout(layout_j, spec, error)) {
+            return false;
+        }
+
+        for (const LayoutSpec &other : parsed) {
+            if (other.name == spec.name) {
+                error = "more than one layout is named " + spec.name;
+                return false;
+            }
+        }
+        parsed.push_back(spec);
+    }
+
+    specs.swap(parsed);
+    return true;
+}
+
+
+// --- LayoutConfigWatcher ---
+
+bool LayoutConfigWatcher::start(const std::string &path, std::function<void()> on_change)
+{
+    if (watching_) {
+        return false;
+    }
+
+    path_ = path;
+    if (!readModTime(mod_time_)) {
+        return false;
+    }
+    on_change_ = on_change;
+    loadFile();
+
+    stopping_ = false;
+    watching_ = true;
+    worker_ = std::thread(&LayoutConfigWatcher::watchFile, this);
+
+    return true;
+}
+
+void LayoutConfigWatcher::stop()
+{
+    if (worker_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        stop_requested_.notify_one();
+        worker_.join();
+    }
+
+    watching_ = false;
+}
+
+bool LayoutConfigWatcher::takeUpdate(std::vector<LayoutSpec> &specs)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_update_) {
+        return false;
+    }
+
+    specs.swap(pending_);
+    pending_.clear();
+    has_update_ = false;
+    return true;
+}
+
+bool LayoutConfigWatcher::takeError(std::string &error)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_error_.empty()) {
+        return false;
+    }
+
+    error.swap(pending_error_);
+    pending_error_.clear();
+    return true;
+}
+
+void LayoutConfigWatcher::drawPanel()
+{
+    if (!watching_) {
+        ImGui::Text("Not watching a layout config");
+        return;
+    }
+
+    ImGui::Text("%s", path_.c_str());
+    ImGui::Text("Layouts: %u", num_layouts_.load());
+    ImGui::Text("Loads: %llu (%llu failed)", (unsigned long long)num_loads_,
+            (unsigned long long)num_failed_loads_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!last_error_.empty()) {
+        ImGui::TextWrapped("Last error: %s", last_error_.c_str());
+    }
+}
+
+
+// --- Private ---
+
+bool LayoutConfigWatcher::readModTime(timespec &mod_time) const
+{
+    struct stat file_stat;
+    if (stat(path_.c_str(), &file_stat) != 0) {
+        return false;
+    }
+
+    mod_time = file_stat.st_mtim;
+    return true;
+}
+
+bool LayoutConfigWatcher::loadFile()
+{
+    std::ifstream file(path_);
+    std::stringstream data;
+    data << file.rdbuf();
+
+    std::vector<LayoutSpec> specs;
+    std::string error;
+    bool loaded(file && parseLayoutConfig(data.str(), specs, error));
+    if (!file) {
+        error = "could not read " + path_;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (loaded) {
+            num_layouts_ = specs.size();
+            pending_.swap(specs);
+            has_update_ = true;
+        }
+        else {
+            pending_error_ = error;
+            last_error_ = error;
+            ++num_failed_loads_;
+        }
+    }
+    ++num_loads_;
+
+    return loaded;
+}
+
+void LayoutConfigWatcher::watchFile()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_requested_.wait_for(lock, std::chrono::milliseconds(kPollPeriodMs),
+            [this]() { return stopping_; })) {
+        lock.unlock();
+
+        timespec mod_time;
+        if (readModTime(mod_time) && (mod_time.tv_sec != mod_time_.tv_sec ||
+                mod_time.tv_nsec != mod_time_.tv_nsec)) {
+            mod_time_ = mod_time;
+            loadFile();
+            if (on_change_) {
+                on_change_();
+            }
+        }
+
+        lock.lock();
+    }
+}
+
+} // viewpoint_interface
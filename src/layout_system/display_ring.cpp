@@ -8,9 +8,18 @@
 namespace viewpoint_interface
 {
 
-Layout::DisplayRing::DisplayRing() : active_frame_(0) {}
+const uint Layout::DisplayRing::kInvalidSlot;
 
-void Layout::DisplayRing::pushDisplay(uint id) { ring_.emplace_back(id); }
+Layout::DisplayRing::DisplayRing() : id_base_(0), primary_list_(std::make_shared<const std::vector<uint>>()),
+        secondary_list_(std::make_shared<const std::vector<uint>>()), generation_(0), active_frame_(0) {}
+
+void Layout::DisplayRing::pushDisplay(uint id)
+{
+    ring_.emplace_back(id);
+    roles_.emplace_back(0);
+    indexSlots(ring_.size() - 1);
+    ringChanged();
+}
 
 void Layout::DisplayRing::removeDisplay(uint id)
 {
@@ -28,6 +37,10 @@ void Layout::DisplayRing::removeDisplay(uint id)
 
     uint ix(getIndexForDisplayId(id));
     ring_.erase(ring_.begin() + ix);
+    roles_.erase(roles_.begin() + ix);
+    slot_by_id_[id - id_base_] = kInvalidSlot;
+    indexSlots(ix);
+    ringChanged();
 
     if (getActiveFrameIndex() >= ring_.size()) {
         setActiveFrameByIndex(0);
@@ -36,10 +49,11 @@ void Layout::DisplayRing::removeDisplay(uint id)
 
 void Layout::DisplayRing::swapDisplays(uint id, float delta)
 {
-        int first_ix(getIndexForDisplayId(id));
-        if (first_ix == -1) {
+        uint slot(getIndexForDisplayId(id));
+        if (slot == kInvalidSlot) {
             return;
         }
+        int first_ix(slot);
 
         int second_ix(-1);
         if (delta < 0 && first_ix > 0) {
@@ -52,9 +66,10 @@ void Layout::DisplayRing::swapDisplays(uint id, float delta)
             return;
         }
 
-        uint temp = ring_[first_ix];
-        ring_[first_ix] = ring_[second_ix];
-        ring_[second_ix] = temp;
+        std::swap(ring_[first_ix], ring_[second_ix]);
+        std::swap(roles_[first_ix], roles_[second_ix]);
+        indexSlots(std::min(first_ix, second_ix));
+        ringChanged();
 }
 
 void Layout::DisplayRing::toNextDisplay(LayoutDisplayRole role)
@@ -69,12 +84,12 @@ void Layout::DisplayRing::toNextDisplay(LayoutDisplayRole role)
 
     uint cur_frame_id(getActiveFrameDisplayId());
     if (!isDisplayRole(cur_frame_id, role)) {
-        auto role_vec(getDisplayRoleList(role));
+        RoleList role_vec(getDisplayRoleList(role));
 
-        if (role_vec.size() > 1) {
+        if (role_vec->size() > 1) {
             return;
         }
-        cur_frame_id = role_vec.at(0);
+        cur_frame_id = role_vec->at(0);
     }
 
     uint next_id(getNextIdWithoutRole(cur_frame_id, role));
@@ -97,12 +112,12 @@ void Layout::DisplayRing::toPrevDisplay(LayoutDisplayRole role)
 
     uint cur_frame_id(getActiveFrameDisplayId());
     if (!isDisplayRole(cur_frame_id, role)) {
-        auto role_vec(getDisplayRoleList(role));
+        RoleList role_vec(getDisplayRoleList(role));
 
-        if (role_vec.size() > 1) {
+        if (role_vec->size() > 1) {
             return;
         }
-        cur_frame_id = role_vec.at(0);
+        cur_frame_id = role_vec->at(0);
     }
 
     uint prev_id(getPrevIdWithoutRole(cur_frame_id, role));
@@ -147,141 +162,54 @@ void Layout::DisplayRing::unsetDisplayRole(uint id, LayoutDisplayRole role)
 
 void Layout::DisplayRing::unsetRoles(uint id)
 {
-    primary_displays_[id] = false;
-    secondary_displays_[id] = false;
+    uint ix(getIndexForDisplayId(id));
+    if (ix < roles_.size()) {
+        roles_[ix] = 0;
+    }
+    rolesChanged();
 }
 
 void Layout::DisplayRing::unsetAllForRole(LayoutDisplayRole role)
 {
-    std::map<uint, bool>::iterator it;
-    std::map<uint, bool>::iterator end_it;    
-    switch (role)
-    {
-        case LayoutDisplayRole::Primary:
-        {
-            it = primary_displays_.begin();
-            end_it = primary_displays_.end();
-        }   break;
-
-        case LayoutDisplayRole::Secondary:
-        {
-            it = secondary_displays_.begin();
-            end_it = secondary_displays_.end();
-        }   break;
-    }
-
-    for (; it != end_it; ++it) {
-        it->second = false;
+    uint8_t bit(getRoleBit(role));
+    for (uint8_t &roles : roles_) {
+        roles &= ~bit;
     }
+    rolesChanged();
 }
 
 bool Layout::DisplayRing::isPrimaryDisplay(uint id) const
 {
-    if (primary_displays_.find(id) == primary_displays_.end()) {
-        return false;
-    }
-
-    return primary_displays_.at(id); 
+    return isDisplayRole(id, LayoutDisplayRole::Primary);
 }
 
 bool Layout::DisplayRing::isSecondaryDisplay(uint id) const
 {
-    if (secondary_displays_.find(id) == secondary_displays_.end()) {
-        return false;
-    }
-
-    return secondary_displays_.at(id); 
+    return isDisplayRole(id, LayoutDisplayRole::Secondary);
 }
 
 bool Layout::DisplayRing::isDisplayRole(uint id, LayoutDisplayRole role) const
 {
-    switch (role)
-    {
-        case LayoutDisplayRole::Primary:
-        {
-            return isPrimaryDisplay(id);
-        }   break;
-
-        case LayoutDisplayRole::Secondary:
-        {
-            return isSecondaryDisplay(id);
-        }   break;
-    }
-}
-
-std::vector<uint> Layout::DisplayRing::getDisplayRoleList(LayoutDisplayRole role) const
-{
-    std::vector<uint> list;
-   
-    switch (role)
-    {
-        case LayoutDisplayRole::Primary:
-        {
-            for (uint display_id : ring_) {
-                if (isPrimaryDisplay(display_id)) {
-                    list.emplace_back(display_id);
-                }
-            }
-        }   break;
-
-        case LayoutDisplayRole::Secondary:
-        {
-            for (uint display_id : ring_) {
-                if (isSecondaryDisplay(display_id)) {
-                    list.emplace_back(display_id);
-                }
-            }
-        }   break;
-    }
-
-    return list;
+    uint ix(getIndexForDisplayId(id));
+    return ix < roles_.size() && (roles_[ix] & getRoleBit(role));
 }
 
-uint Layout::DisplayRing::getNumPrimaryDisplays() const
+Layout::DisplayRing::RoleList Layout::DisplayRing::getDisplayRoleList(LayoutDisplayRole role) const
 {
-    uint count(0);
-    auto it(primary_displays_.begin());
-    for (; it != primary_displays_.end(); ++it) {
-        if (it->second) {
-            ++count;
-        }
-    }
-
-    return count;
+    return role == LayoutDisplayRole::Primary ? primary_list_ : secondary_list_;
 }
 
-uint Layout::DisplayRing::getNumSecondaryDisplays() const
-{
-    uint count(0);
-    auto it(secondary_displays_.begin());
-    for (; it != secondary_displays_.end(); ++it) {
-        if (it->second) {
-            ++count;
-        }
-    }
-
-    return count;
-}
+uint Layout::DisplayRing::getNumPrimaryDisplays() const { return getNumForRole(LayoutDisplayRole::Primary); }
+uint Layout::DisplayRing::getNumSecondaryDisplays() const { return getNumForRole(LayoutDisplayRole::Secondary); }
 
 uint Layout::DisplayRing::getNumForRole(LayoutDisplayRole role) const
 {
-    switch (role)
-    {
-        case LayoutDisplayRole::Primary:
-        {
-            return getNumPrimaryDisplays();
-        }   break;
-
-        case LayoutDisplayRole::Secondary:
-        {
-            return getNumSecondaryDisplays();
-        }   break;
-    }
+    return getDisplayRoleList(role)->size();
 }
 
 uint Layout::DisplayRing::getDisplayIdByIx(uint ix) const
 {
-    ring_.at(ix);
+    return ring_.at(ix);
 }
 
 void Layout::DisplayRing::setActiveFrameByIndex(uint ix)
@@ -295,7 +223,8 @@ void Layout::DisplayRing::setActiveFrameByIndex(uint ix)
 
 void Layout::DisplayRing::setActiveFrameById(uint id)
 {
-    auto prim_vec(getDisplayRoleList(LayoutDisplayRole::Primary));
+    RoleList prim_list(getDisplayRoleList(LayoutDisplayRole::Primary));
+    const std::vector<uint> &prim_vec(*prim_list);
     for (int i(0); i < prim_vec.size(); ++i) {
         uint cur_id(prim_vec.at(i));
         if (cur_id == id) {
@@ -313,7 +242,7 @@ uint Layout::DisplayRing::getActiveFrameDisplayId() const
         return 0;
     }
 
-    return getDisplayRoleList(LayoutDisplayRole::Primary).at(active_frame_);
+    return getDisplayRoleList(LayoutDisplayRole::Primary)->at(active_frame_);
 }
 
 void Layout::DisplayRing::toNextActiveFrame()
@@ -354,55 +283,108 @@ uint Layout::DisplayRing::getImageIdForDisplayId(uint id) const
     return 0;
 }
 
+void Layout::DisplayRing::addThumbnailResponseForId(uint display_id, uint gl_id)
+{
+    thumbnail_ids_[display_id] = gl_id;
+}
+
+uint Layout::DisplayRing::getThumbnailIdForDisplayId(uint id) const
+{
+    auto entry(thumbnail_ids_.find(id));
+    if (entry != thumbnail_ids_.end()) {
+        return entry->second;
+    }
+
+    return 0;
+}
+
+
+void Layout::DisplayRing::setPrimaryDisplay(uint id) { setRoleBit(id, kPrimaryBit, true); }
+void Layout::DisplayRing::setSecondaryDisplay(uint id) { setRoleBit(id, kSecondaryBit, true); }
+void Layout::DisplayRing::unsetPrimaryDisplay(uint id) { setRoleBit(id, kPrimaryBit, false); }
+void Layout::DisplayRing::unsetSecondaryDisplay(uint id) { setRoleBit(id, kSecondaryBit, false); }
+
+uint8_t Layout::DisplayRing::getRoleBit(LayoutDisplayRole role)
+{
+    return role == LayoutDisplayRole::Primary ? kPrimaryBit : kSecondaryBit;
+}
+
+void Layout::DisplayRing::setRoleBit(uint id, uint8_t bit, bool state)
+{
+    uint ix(getIndexForDisplayId(id));
+    if (ix >= roles_.size()) {
+        return;
+    }
+
+    if (state) {
+        roles_[ix] |= bit;
+    }
+    else {
+        roles_[ix] &= ~bit;
+    }
+    rolesChanged();
+}
+
+void Layout::DisplayRing::rolesChanged()
+{
+    // Setting roles displays already have leaves the lists, and so the cached layout geometry, as they were
+    bool primary_changed(updateRoleList(primary_list_, kPrimaryBit));
+    bool secondary_changed(updateRoleList(secondary_list_, kSecondaryBit));
+    if (primary_changed || secondary_changed) {
+        ++generation_;
+    }
+}
 
-void Layout::DisplayRing::setPrimaryDisplay(uint id) { primary_displays_[id] = true; }
-void Layout::DisplayRing::setSecondaryDisplay(uint id) { secondary_displays_[id] = true; }
-void Layout::DisplayRing::unsetPrimaryDisplay(uint id) { primary_displays_[id] = false; }
-void Layout::DisplayRing::unsetSecondaryDisplay(uint id) { secondary_displays_[id] = false; }
+void Layout::DisplayRing::ringChanged()
+{
+    updateRoleList(primary_list_, kPrimaryBit);
+    updateRoleList(secondary_list_, kSecondaryBit);
+    ++generation_;
+}
+
+bool Layout::DisplayRing::updateRoleList(RoleList &list, uint8_t bit)
+{
+    // Lists are only replaced when their contents change, so setting roles that
+    // displays already have doesn't allocate
+    const RoleList &current(list);
+    uint num_matching(0);
+    bool changed(false);
+    for (uint ix(0); ix < ring_.size() && !changed; ++ix) {
+        if (roles_[ix] & bit) {
+            changed = num_matching >= current->size() || (*current)[num_matching] != ring_[ix];
+            ++num_matching;
+        }
+    }
+    if (!changed && num_matching == current->size()) {
+        return false;
+    }
+
+    std::shared_ptr<std::vector<uint>> rebuilt(std::make_shared<std::vector<uint>>());
+    for (uint ix(0); ix < ring_.size(); ++ix) {
+        if (roles_[ix] & bit) {
+            rebuilt->push_back(ring_[ix]);
+        }
+    }
+    list = rebuilt;
+    return true;
+}
 
 uint Layout::DisplayRing::getNextIdWithoutRole(uint start_id, LayoutDisplayRole role)
 {
     uint cur_ix(getIndexForDisplayId(start_id));
+    uint8_t role_bit(getRoleBit(role));
 
     // Loop from cur_ix through end of ring
     for (int i(cur_ix+1); i < ring_.size(); ++i) {
-        uint cur_id(ring_.at(i));
-        switch (role)
-        {
-            case LayoutDisplayRole::Primary:
-            {
-                if (!primary_displays_[cur_id]) {
-                    return cur_id;
-                }
-            }   break;
-
-            case LayoutDisplayRole::Secondary:
-            {
-                if (!secondary_displays_[cur_id]) {
-                    return cur_id;
-                }
-            }   break;
+        if (!(roles_.at(i) & role_bit)) {
+            return ring_.at(i);
         }
     }
 
     // If valid ID not found, loop back to beginning of ring
     for (int i(0); i < cur_ix; ++i) {
-        uint cur_id(ring_.at(i));
-        switch (role)
-        {
-            case LayoutDisplayRole::Primary:
-            {
-                if (!primary_displays_[cur_id]) {
-                    return cur_id;
-                }
-            }   break;
-
-            case LayoutDisplayRole::Secondary:
-            {
-                if (!secondary_displays_[cur_id]) {
-                    return cur_id;
-                }
-            }   break;
+        if (!(roles_.at(i) & role_bit)) {
+            return ring_.at(i);
         }
     }
 
@@ -412,63 +394,47 @@ uint Layout::DisplayRing::getNextIdWithoutRole(uint start_id, LayoutDisplayRole
 uint Layout::DisplayRing::getPrevIdWithoutRole(uint start_id, LayoutDisplayRole role)
 {
     uint cur_ix(getIndexForDisplayId(start_id));
+    uint8_t role_bit(getRoleBit(role));
 
     // Loop back from cur_ix through beginning of ring
     for (int i(cur_ix-1); i >= 0; --i) {
-        uint cur_id(ring_.at(i));
-        switch (role)
-        {
-            case LayoutDisplayRole::Primary:
-            {
-                if (!primary_displays_[cur_id]) {
-                    return cur_id;
-                }
-            }   break;
-
-            case LayoutDisplayRole::Secondary:
-            {
-                if (!secondary_displays_[cur_id]) {
-                    return cur_id;
-                }
-            }   break;
+        if (!(roles_.at(i) & role_bit)) {
+            return ring_.at(i);
         }
     }
 
     // If valid ID not found, loop back from end of ring
     for (int i(ring_.size()-1); i > cur_ix; --i) {
-        uint cur_id(ring_.at(i));
-        switch (role)
-        {
-            case LayoutDisplayRole::Primary:
-            {
-                if (!primary_displays_[cur_id]) {
-                    return cur_id;
-                }
-            }   break;
-
-            case LayoutDisplayRole::Secondary:
-            {
-                if (!secondary_displays_[cur_id]) {
-                    return cur_id;
-                }
-            }   break;
+        if (!(roles_.at(i) & role_bit)) {
+            return ring_.at(i);
         }
     }
 
     return start_id;
 }
 
-uint Layout::DisplayRing::getIndexForDisplayId(uint id)
+uint Layout::DisplayRing::getIndexForDisplayId(uint id) const
 {
-    uint index(0);
-    for (uint disp_id : ring_) {
-        if (disp_id == id) {
-            return index;
+    return (id >= id_base_ && id - id_base_ < slot_by_id_.size()) ? slot_by_id_[id - id_base_] : kInvalidSlot;
+}
+
+void Layout::DisplayRing::indexSlots(uint first_ix)
+{
+    for (uint ix(first_ix); ix < ring_.size(); ++ix) {
+        uint id(ring_[ix]);
+        if (slot_by_id_.empty()) {
+            id_base_ = id;
+        }
+        else if (id < id_base_) {
+            slot_by_id_.insert(slot_by_id_.begin(), id_base_ - id, kInvalidSlot);
+            id_base_ = id;
         }
-        ++index;
-    }
 
-    return -1;
+        if (id - id_base_ >= slot_by_id_.size()) {
+            slot_by_id_.resize(id - id_base_ + 1, kInvalidSlot);
+        }
+        slot_by_id_[id - id_base_] = ix;
+    }
 }
 
 
@@ -1,28 +1,34 @@
+#include <cstdio>
+
 #include "viewpoint_interface/layout.hpp"
 #include "viewpoint_interface/layout_component.hpp"
 
 
 namespace viewpoint_interface {
 
+// Carousel tiles are spaced by this much and shaped for 16:9 cameras
+static const float kCarouselPadding = 15.0f;
+static const float kCarouselTileAspect = 16.0f / 9.0f;
+// Fraction of the remaining distance to its target the ribbon scrolls per second
+static const float kCarouselScrollRate = 12.0f;
+
 // --- Public ---
-const std::vector<float> LayoutComponent::getDisplayBounds() const
+void LayoutComponent::updateDisplayBounds()
 {
-    std::vector<float> bounds;
+    display_bounds_.clear();
 
     switch (type_)
     {
         case Type::Primary:
         {
-            float x_pos, y_pos, width, height;
-            uint total_displays(layout_.display_states_.getDisplayRing().getNumPrimaryDisplays());
-            for (uint i = 0; i < total_displays; ++i) {
-                getPrimaryDisplayPositionAndSize(i, total_displays, x_pos, y_pos, width, height);
-                
+            // Off-page displays get empty bounds so indices still match the ring
+            for (const DisplayRect &rect : layout_.primary_rects_) {
                 // Top left corner
-                bounds.push_back(x_pos); bounds.push_back(y_pos);
+                display_bounds_.push_back(rect.pos.x); display_bounds_.push_back(rect.pos.y);
                 
                 // Bottom right corner
-                bounds.push_back(x_pos + width); bounds.push_back(y_pos + height);
+                display_bounds_.push_back(rect.pos.x + rect.size.x);
+                display_bounds_.push_back(rect.pos.y + rect.size.y);
             }
         }   break;
     
@@ -32,38 +38,16 @@ const std::vector<float> LayoutComponent::getDisplayBounds() const
             getPiPWindowPosition(pos);
 
             // Top left corner
-            bounds.push_back(pos.x); bounds.push_back(pos.y);
+            display_bounds_.push_back(pos.x); display_bounds_.push_back(pos.y);
 
             // Bottom right corner
-            bounds.push_back(pos.x + width_); bounds.push_back(pos.y + height_);
-        }   break;
-    
-        case Type::Carousel:
-        {
-            ImVec2 ribbon_pos;
-            std::vector<ImVec4> display_dim_data;
-            getCarouselRibbonPosAndDisplaysPosAndSize(ribbon_pos, display_dim_data);
-
-            for (int i(0); i < display_dim_data.size(); ++i) {
-                float x_pos(ribbon_pos.x + display_dim_data[i].x);
-                float y_pos(ribbon_pos.y + display_dim_data[i].y);
-                
-                // Top left corner
-                bounds.push_back(x_pos);
-                bounds.push_back(y_pos);
-
-                // Bottom right corner
-                bounds.push_back(x_pos + display_dim_data[i].z);
-                bounds.push_back(y_pos + display_dim_data[i].w);
-            }
+            display_bounds_.push_back(pos.x + width_); display_bounds_.push_back(pos.y + height_);
         }   break;
     
         default:
         {
         }   break;
     }
-
-    return bounds;
 }
 
 void LayoutComponent::draw()
@@ -213,56 +197,93 @@ void LayoutComponent::checkParameters()
     }
 }
 
-void LayoutComponent::getPrimaryDisplayPositionAndSize(uint cur_display, uint num_displays, float &x_pos, float &y_pos, 
-        float &width, float &height) const
+DisplayGrid DisplayGrid::fit(uint num_displays, uint max_per_page, uint active_ix, float width, float height,
+        float aspect_ratio)
 {
-    const static uint max_vertical_slices(4); // Note: This is half of total possible displays b/c of horizontal slicing
+    DisplayGrid grid;
+    if (num_displays == 0) {
+        return grid;
+    }
 
-    // Calculate slices
-    bool displays_even(num_displays % 2 == 0); // Even # of displays?
-    uint half_num_displays(std::ceil(num_displays / 2.0)); // Account for horizontal split
-    uint vert_slices(half_num_displays > max_vertical_slices ? max_vertical_slices : half_num_displays); // Clamp vertical slices
-    
-    // Calculate dimensions for each slice
-    width = width_ / (float)vert_slices;
-    height = height_ / (num_displays > 1 ? 2.0 : 1.0);
+    uint per_page(max_per_page > 0 ? std::min(num_displays, max_per_page) : num_displays);
+    grid.per_page = per_page;
+
+    // Try every column count and keep the one with the largest images. Ties
+    // go to fewer columns, which stacks a pair of displays vertically
+    float best_width(-1.0);
+    for (uint cols(1); cols <= per_page; ++cols) {
+        uint rows((per_page + cols - 1) / cols);
+        float cell_width(width / cols), cell_height(height / rows);
+        float img_width(std::min(cell_width, cell_height * aspect_ratio));
+
+        if (img_width > best_width + 1e-3) {
+            best_width = img_width;
+            grid.cols = cols;
+            grid.rows = rows;
+        }
+    }
+
+    grid.num_pages = (num_displays + per_page - 1) / per_page;
+    grid.page = std::min(active_ix / per_page, grid.num_pages - 1);
+    grid.page_start = grid.page * per_page;
+    grid.page_size = std::min(per_page, num_displays - grid.page_start);
 
-    // TODO: Handle more than [max_vert_slices * 2] displays
-    // In particular, add functionality to switch between 'pages' of displays
+    return grid;
+}
 
-    float width_pad;
-    if (displays_even) {
-        width_pad = 0.0;
+DisplayGrid LayoutComponent::getDisplayGrid() const
+{
+    Layout::DisplayRing& ring(layout_.display_states_.getDisplayRing());
+    Layout::DisplayRing::RoleList primary_list(ring.getDisplayRoleList(LayoutDisplayRole::Primary));
+    const std::vector<uint> &primary_displays(*primary_list);
+
+    // Cells are shaped for the average display
+    float aspect_ratio(0.0);
+    for (uint display_id : primary_displays) {
+        const DisplayDims &dims(layout_.displays_.getDisplayInfoById(display_id).dimensions);
+        aspect_ratio += dims.height > 0 ? (float)dims.width / dims.height : 1.0;
     }
-    else {
-        // Add padding to bottom windows if number of displays is odd
-        width_pad = (width / 2.0) * (cur_display % 2);
+    aspect_ratio = primary_displays.empty() ? 1.0 : aspect_ratio / primary_displays.size();
+
+    return DisplayGrid::fit(primary_displays.size(), layout_.max_displays_per_page_, ring.getActiveFrameIndex(),
+            width_, height_, aspect_ratio);
+}
+
+void LayoutComponent::getPrimaryDisplayPositionAndSize(uint cur_display, float &x_pos, float &y_pos, float &width,
+        float &height) const
+{
+    const DisplayGrid &grid(layout_.display_states_.getDisplayGrid());
+    if (!grid.isOnPage(cur_display)) {
+        x_pos = y_pos = width = height = 0.0;
+        return;
     }
-    // Move further to the right every other display
-    x_pos = (width * std::floor(cur_display / 2.0)) + width_pad;
-    // Jump back and forth b/w top and bottom halves
-    y_pos = height * (cur_display % 2);
+
+    width = width_ / grid.cols;
+    height = height_ / grid.rows;
+
+    uint row(grid.getRow(cur_display)), col(grid.getCol(cur_display));
+
+    // Center a partially filled last row
+    float width_pad((grid.cols - grid.getNumInRow(row)) * width * 0.5);
+
+    x_pos = offset_.x + (width * col) + width_pad;
+    y_pos = offset_.y + (height * row);
 }
 
-void LayoutComponent::drawPrimaryWindows() const
+std::vector<DisplayRect> LayoutComponent::getPrimaryDisplayRects() const
 {
     Layout::DisplayRing& ring(layout_.display_states_.getDisplayRing());
-    auto primary_displays(ring.getDisplayRoleList(LayoutDisplayRole::Primary));
-    uint num_displays(primary_displays.size());
-    
+    Layout::DisplayRing::RoleList primary_list(ring.getDisplayRoleList(LayoutDisplayRole::Primary));
+    const std::vector<uint> &primary_displays(*primary_list);
+
+    std::vector<DisplayRect> rects;
+    rects.reserve(primary_displays.size());
+
     uint cur_num(0);
     for (uint display_id : primary_displays) {
-        ImGuiWindowFlags win_flags = 0;
-        win_flags |= ImGuiWindowFlags_NoDecoration;
-        win_flags |= ImGuiWindowFlags_NoInputs;
-        win_flags |= ImGuiWindowFlags_NoSavedSettings;
-        win_flags |= ImGuiWindowFlags_NoMove;
-        win_flags |= ImGuiWindowFlags_NoBringToFrontOnFocus; // Otherwise, it overlays everything
-
-        float x_pos, y_pos, win_width, win_height;
-        getPrimaryDisplayPositionAndSize(cur_num, num_displays, x_pos, y_pos, win_width, win_height);
-        ImGui::SetNextWindowPos(ImVec2(x_pos, y_pos), ImGuiCond_Always);
-        ImGui::SetNextWindowSize(ImVec2(win_width, win_height));
+        DisplayRect rect;
+        rect.display_id = display_id;
+        getPrimaryDisplayPositionAndSize(cur_num, rect.pos.x, rect.pos.y, rect.size.x, rect.size.y);
 
         // Maintain the right aspect ratio
         const DisplayInfo &disp_info(layout_.displays_.getDisplayInfoById(display_id));
@@ -270,33 +291,80 @@ void LayoutComponent::drawPrimaryWindows() const
 
         ImVec2 padding{5, 5};
 
-        float img_width(win_width - (2*padding.x));
+        float img_width(rect.size.x - (2*padding.x));
         float img_height(img_width * (1.0/aspect_ratio));
 
-        if (img_height > win_height) {
+        if (img_height > rect.size.y) {
             // If converted height is too large, convert width instead
-            img_height = win_height - (2*padding.y);
+            img_height = rect.size.y - (2*padding.y);
             img_width = img_height * aspect_ratio;
         }
 
+        // Center the image on the cell
+        rect.image_size = ImVec2{img_width, img_height};
+        rect.image_offset = ImVec2{(rect.size.x - img_width) * 0.5f, (rect.size.y - img_height) * 0.5f};
+
+        rects.push_back(rect);
+        ++cur_num;
+    }
+
+    return rects;
+}
+
+void LayoutComponent::drawPrimaryWindows() const
+{
+    Layout::DisplayRing& ring(layout_.display_states_.getDisplayRing());
+    const DisplayGrid &grid(layout_.display_states_.getDisplayGrid());
+    uint num_displays(grid.page_size);
+    
+    for (uint cur_num(grid.page_start); cur_num < grid.page_start + grid.page_size; ++cur_num) {
+        const DisplayRect &rect(layout_.primary_rects_.at(cur_num));
+        uint display_id(rect.display_id);
+
+        ImGuiWindowFlags win_flags = 0;
+        win_flags |= ImGuiWindowFlags_NoDecoration;
+        win_flags |= ImGuiWindowFlags_NoInputs;
+        win_flags |= ImGuiWindowFlags_NoSavedSettings;
+        win_flags |= ImGuiWindowFlags_NoMove;
+        win_flags |= ImGuiWindowFlags_NoBringToFrontOnFocus; // Otherwise, it overlays everything
+
         bool active_frame(cur_num == ring.getActiveFrameIndex());
+        const std::string &title(layout_.displays_.getDisplayExternalNameById(display_id));
+        layout_.addFullSizeDisplay(display_id, active_frame ? UploadPriority::ActiveFrame : UploadPriority::Primary);
+
+        if (layout_.batched_displays_) {
+            // The compositor draws the image, so only the overlay goes through ImGui
+            ImVec2 image_pos{rect.pos.x + rect.image_offset.x, rect.pos.y + rect.image_offset.y};
+            layout_.addDisplayQuad(DisplayQuad{display_id, image_pos, rect.image_size});
+
+            ImDrawList *draw_list(ImGui::GetBackgroundDrawList());
+            draw_list->AddText(ImVec2{image_pos.x + 10, image_pos.y + 5}, ImGui::GetColorU32(ImGuiCol_Text),
+                    title.c_str());
+            if (num_displays > 1 && active_frame) {
+                draw_list->AddRect(rect.pos, ImVec2{rect.pos.x + rect.size.x, rect.pos.y + rect.size.y},
+                        ImGui::GetColorU32(layout_.kActiveBorderColor), 0.0f, 0, 3.0f);
+            }
+
+            continue;
+        }
+
+        ImGui::SetNextWindowPos(rect.pos, ImGuiCond_Always);
+        ImGui::SetNextWindowSize(rect.size);
+
         if (num_displays > 1 && active_frame) {
             ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 3.0);
             ImGui::PushStyleColor(ImGuiCol_Border, layout_.kActiveBorderColor);
         }
 
-        std::string menu_name("Primary Display " + std::to_string(cur_num));
+        char menu_name[32];
+        std::snprintf(menu_name, sizeof(menu_name), "Primary Display %u", cur_num);
         if (startMenu(menu_name, win_flags)) {
-            // Center the image on the window
-            ImVec2 image_pos(ImVec2{(ImGui::GetWindowSize().x - img_width) * 0.5f, 
-                                        (ImGui::GetWindowSize().y - img_height) * 0.5f});
-            ImGui::SetCursorPos(image_pos);
+            ImGui::SetCursorPos(rect.image_offset);
 
-            ImGui::Image(reinterpret_cast<ImTextureID>(ring.getImageIdForDisplayId(display_id)), ImVec2 {img_width, img_height});
+            ImGui::Image(reinterpret_cast<ImTextureID>(ring.getImageIdForDisplayId(display_id)), rect.image_size);
             
             // Show camera external name on top of image
-            ImGui::SetCursorPos({image_pos.x + 10, image_pos.y + 5});
-            const std::string &title(layout_.displays_.getDisplayExternalNameById(display_id));
+            ImGui::SetCursorPos({rect.image_offset.x + 10, rect.image_offset.y + 5});
             ImGui::Text(title.c_str());
 
             endMenu();
@@ -306,123 +374,133 @@ void LayoutComponent::drawPrimaryWindows() const
             ImGui::PopStyleVar();
             ImGui::PopStyleColor();
         }
-
-        ++cur_num;
     }
 }
 
-void LayoutComponent::getCarouselRibbonPosAndDisplaysPosAndSize(ImVec2 &ribbon_pos, 
-        std::vector<ImVec4> &display_dim_data) const
-{    
-    ImVec2 display_size{250.0, 140.0};
+void LayoutComponent::updateCarouselScroll(const std::vector<uint> &tile_displays, float stride,
+        float tile_length, float ribbon_length) const
+{
+    Layout::CarouselScroll &scroll(layout_.carousel_scroll_);
+    ImGuiIO &io(ImGui::GetIO());
+
+    // Center the ribbon on the active display whenever it changes, but leave
+    // the operator free to scroll away from it in between
+    uint active_id(layout_.display_states_.getActiveFrameDisplayId());
+    if (active_id != scroll.followed_id) {
+        scroll.followed_id = active_id;
+
+        auto tile(std::find(tile_displays.begin(), tile_displays.end(), active_id));
+        if (tile != tile_displays.end()) {
+            float tile_center(kCarouselPadding + ((tile - tile_displays.begin()) * stride) + (tile_length / 2));
+            scroll.target = tile_center - (ribbon_length / 2);
+        }
+    }
 
     ImGuiViewport* main_viewport(ImGui::GetMainViewport());
-    ImVec2 work_pos(main_viewport->GetWorkPos());
-    ribbon_pos = ImVec2(work_pos.x + offset_.x, work_pos.y + offset_.y);
+    ImVec2 ribbon_pos(main_viewport->GetWorkPos().x + offset_.x, main_viewport->GetWorkPos().y + offset_.y);
+    if (io.MouseWheel != 0.0f && ImGui::IsMouseHoveringRect(ribbon_pos,
+            ImVec2{ribbon_pos.x + width_, ribbon_pos.y + height_}, false)) {
+        scroll.target -= io.MouseWheel * stride;
+    }
+
+    float content_length((tile_displays.size() * stride) + kCarouselPadding);
+    float max_scroll(std::max(0.0f, content_length - ribbon_length));
+    scroll.target = std::min(std::max(scroll.target, 0.0f), max_scroll);
 
-    // Calculate number of displays in carousel
-    const float padding(15.0); // Padding b/w displays as well as edges
-    uint num_displays(0); // Number of displays that can fit w/in ribbon
-    if (spacing_ == Spacing::Horizontal) {
-        num_displays = (width_ - padding) / (display_size.x + padding);
+    float blend(std::min(1.0f, io.DeltaTime * kCarouselScrollRate));
+    scroll.pos += (scroll.target - scroll.pos) * blend;
+    if (std::abs(scroll.target - scroll.pos) < 0.5f) {
+        scroll.pos = scroll.target;
     }
-    else {
-        num_displays = (height_ - padding) / (display_size.y + padding);
+}
+
+void LayoutComponent::drawCarouselRibbon() const
+{
+    Layout::DisplayRing& ring(layout_.display_states_.getDisplayRing());
+    Layout::DisplayRing::RoleList tile_list(ring.getDisplayRoleList(LayoutDisplayRole::Secondary));
+    const std::vector<uint> &tile_displays(*tile_list);
+
+    // Tiles fill the ribbon's breadth and are laid out along its length
+    bool horizontal(spacing_ == Spacing::Horizontal);
+    float ribbon_length(horizontal ? width_ : height_);
+    float tile_breadth((horizontal ? height_ : width_) - (2 * kCarouselPadding));
+    ImVec2 tile_size(horizontal ? ImVec2{tile_breadth * kCarouselTileAspect, tile_breadth} :
+            ImVec2{tile_breadth, tile_breadth / kCarouselTileAspect});
+    float tile_length(horizontal ? tile_size.x : tile_size.y);
+    float stride(tile_length + kCarouselPadding);
+    if (tile_breadth <= 0.0f || tile_displays.empty()) {
+        return;
     }
 
-    // if (layout_.secondary_ring_.size() < num_displays) {
-    //     num_displays = layout_.secondary_ring_.size();
-    // }
+    updateCarouselScroll(tile_displays, stride, tile_length, ribbon_length);
 
-    // Calculate the display position within the ribbon. In the future, 
-    // this could also calculate a variable size for certain displays
-    for (int i(0); i < num_displays; ++i) {
-        uint spacing_factor(std::ceil(i / 2.0));
-        int side(i % 2 == 0 ? -1 : 1); // -1 = left/top, 1 = right/bottom
+    // Only the tiles within view are visited, so the cost per frame doesn't
+    // depend on the number of cameras. A short ribbon is centered instead
+    float content_length((tile_displays.size() * stride) + kCarouselPadding);
+    float lead(std::max(0.0f, (ribbon_length - content_length) / 2));
+    float start(lead + kCarouselPadding - layout_.carousel_scroll_.pos); // Of the first tile
+    uint first(std::max(0.0f, std::floor(-start / stride)));
+    uint last(std::min((float)tile_displays.size(), std::ceil((ribbon_length - start) / stride)));
 
-        // Calculate spacing b/w displays
-        float disp_spacing(0);
-        if (side == 1) { // Right side
-            disp_spacing = (spacing_factor * padding) + ((spacing_factor-1) * display_size.x);
-        }
-        else if (side == -1 && spacing_factor != 0) {
-            disp_spacing = spacing_factor * (padding + display_size.x);
-        }
+    ImGuiWindowFlags win_flags = 0;
+    win_flags |= ImGuiWindowFlags_NoDecoration;
+    win_flags |= ImGuiWindowFlags_NoInputs;
+    win_flags |= ImGuiWindowFlags_NoSavedSettings;
+    win_flags |= ImGuiWindowFlags_NoMove;
+    win_flags |= ImGuiWindowFlags_NoBringToFrontOnFocus;
 
-        // Calculate position of display
-        ImVec2 display_pos;
-        if (spacing_ == Spacing::Vertical) {
-            float ribbon_middle(height_ / 2.0);
-            display_pos = ImVec2(padding, ribbon_middle + (side * ((display_size.y / 2) + disp_spacing)));
-        }
-        else {
-            float ribbon_middle(width_ / 2.0);
-            display_pos = ImVec2(ribbon_middle + (side * ((display_size.x / 2) + disp_spacing)), padding);
+    ImGuiViewport* main_viewport(ImGui::GetMainViewport());
+    ImVec2 ribbon_pos(main_viewport->GetWorkPos().x + offset_.x, main_viewport->GetWorkPos().y + offset_.y);
+    ImGui::SetNextWindowPos(ribbon_pos, ImGuiCond_Always);
+    ImGui::SetNextWindowSize(ImVec2{width_, height_});
+
+    if (startMenu("Carousel", win_flags)) {
+        ImDrawList *draw_list(ImGui::GetWindowDrawList());
+        uint active_id(layout_.display_states_.getActiveFrameDisplayId());
+
+        for (uint ix(first); ix < last; ++ix) {
+            uint display_id(tile_displays[ix]);
+            float along(start + (ix * stride));
+            ImVec2 tile_pos(horizontal ? ImVec2{ribbon_pos.x + along, ribbon_pos.y + kCarouselPadding} :
+                    ImVec2{ribbon_pos.x + kCarouselPadding, ribbon_pos.y + along});
+            ImVec2 tile_end{tile_pos.x + tile_size.x, tile_pos.y + tile_size.y};
+
+            // Fit the thumbnail within the tile
+            const DisplayDims &dims(layout_.displays_.getDisplayInfoById(display_id).dimensions);
+            float aspect_ratio(dims.height > 0 ? (float)dims.width / dims.height : kCarouselTileAspect);
+            ImVec2 image_size(tile_size);
+            if (aspect_ratio > kCarouselTileAspect) {
+                image_size.y = tile_size.x / aspect_ratio;
+            }
+            else {
+                image_size.x = tile_size.y * aspect_ratio;
+            }
+            ImVec2 image_pos{tile_pos.x + ((tile_size.x - image_size.x) / 2),
+                    tile_pos.y + ((tile_size.y - image_size.y) / 2)};
+
+            uint thumbnail_id(ring.getThumbnailIdForDisplayId(display_id));
+            if (thumbnail_id != 0) {
+                draw_list->AddImage(reinterpret_cast<ImTextureID>(thumbnail_id), image_pos,
+                        ImVec2{image_pos.x + image_size.x, image_pos.y + image_size.y});
+            }
+            else {
+                draw_list->AddRectFilled(tile_pos, tile_end, ImGui::GetColorU32(ImGuiCol_FrameBg));
+            }
+            layout_.addThumbnailRequest(display_id);
+
+            const std::string &title(layout_.displays_.getDisplayExternalNameById(display_id));
+            draw_list->AddText(ImVec2{tile_pos.x + 10, tile_pos.y + 5}, ImGui::GetColorU32(ImGuiCol_Text),
+                    title.c_str());
+            if (display_id == active_id) {
+                draw_list->AddRect(tile_pos, tile_end, ImGui::GetColorU32(layout_.kActiveBorderColor), 0.0f, 0,
+                        3.0f);
+            }
         }
 
-        // Add position and size data to display dimensions vector
-        display_dim_data.push_back(ImVec4(display_pos.x, display_pos.y, display_size.x, display_size.y));
+        endMenu();
     }
 }
 
-void LayoutComponent::drawCarouselRibbon() const
-{
-    // ImGuiWindowFlags win_flags = 0;
-    // win_flags |= ImGuiWindowFlags_NoDecoration;
-    // win_flags |= ImGuiWindowFlags_NoInputs;
-    // win_flags |= ImGuiWindowFlags_NoSavedSettings;
-    // win_flags |= ImGuiWindowFlags_NoMove;
-
-    // std::vector<ImVec4> display_dim_data;
-    // ImVec2 ribbon_pos;
-    // getCarouselRibbonPosAndDisplaysPosAndSize(ribbon_pos, display_dim_data);
-    // ImGui::SetNextWindowPos(ribbon_pos);
-    // ImGui::SetNextWindowSize(ImVec2(width_, height_));
-    
-    // ImGuiStyle& style(ImGui::GetStyle());
-    // float orig_border_size(style.WindowBorderSize);
-    // ImVec4 orig_border_color(style.Colors[ImGuiCol_Border]);
-    // if (startMenu("Carousel", win_flags)) {
-    //     win_flags |= ImGuiWindowFlags_NoBackground;
-    //     win_flags |= ImGuiWindowFlags_AlwaysAutoResize;
-
-    //     for (uint i(0); i < display_dim_data.size(); ++i) {
-    //         ImVec2 display_pos(ribbon_pos.x + display_dim_data[i].x, ribbon_pos.y + display_dim_data[i].y);
-    //         ImGui::SetNextWindowPos(display_pos);
-    //         uint display_id(layout_.secondary_ring_.getDisplayIdAt(i));
-
-    //         if (display_id == layout_.primary_ring_.getActiveFrameDisplayId()) {
-    //             ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 3.0);
-    //             ImGui::PushStyleColor(ImGuiCol_Border, layout_.kActiveBorderColor);
-    //             win_flags ^= ImGuiWindowFlags_NoBackground;
-    //         }
-
-    //         std::string title("Carousel Display " + std::to_string(i));
-    //         if (startMenu(title, win_flags)) {
-    //             ImGui::SetCursorPos(ImVec2(0.0, 0.0));
-
-    //             ImGui::Image(reinterpret_cast<ImTextureID>(layout_.secondary_ring_.getImageIdForDisplayId(display_id)), 
-    //                 ImVec2{display_dim_data[i].z, display_dim_data[i].w});
-                
-    //             // Show camera external name on top of image
-    //             ImGui::SetCursorPos(ImVec2(10, 5));
-    //             const std::string &title(layout_.displays_.getDisplayExternalNameById(display_id));
-    //             ImGui::Text(title.c_str());
-
-    //             endMenu();
-    //         }
-
-    //         if (display_id == layout_.primary_ring_.getActiveFrameDisplayId()) {
-    //             ImGui::PopStyleVar();
-    //             ImGui::PopStyleColor();
-    //             win_flags |= ImGuiWindowFlags_NoBackground;
-    //         }
-    //     }
-
-    //     endMenu();
-    // }
-}
-
 void LayoutComponent::getPiPWindowPosition(ImVec2 &pos) const
 {
     ImGuiViewport* main_viewport(ImGui::GetMainViewport());
@@ -457,6 +535,10 @@ void LayoutComponent::drawPiPWindow() const
     win_flags |= ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoCollapse;
     win_flags |= ImGuiWindowFlags_NoTitleBar;
     win_flags |= ImGuiWindowFlags_AlwaysAutoResize;
+    if (layout_.batched_displays_) {
+        // The window would otherwise be drawn over the composited image
+        win_flags |= ImGuiWindowFlags_NoBackground;
+    }
 
     ImVec2 window_pos;
     getPiPWindowPosition(window_pos);
@@ -464,21 +546,34 @@ void LayoutComponent::drawPiPWindow() const
 
     if (startMenu("Picture-in-Picture", win_flags)) {
         Layout::DisplayRing& ring(layout_.display_states_.getDisplayRing());
-        if (ring.getNumSecondaryDisplays() == 0) { 
+        Layout::DisplayRing::RoleList secondary_list(ring.getDisplayRoleList(LayoutDisplayRole::Secondary));
+        if (secondary_list->empty()) { 
             ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "No secondary displays specified.");
             endMenu();
             return;
         }
 
-        uint active_id(ring.getDisplayRoleList(LayoutDisplayRole::Secondary).at(0));
-        std::string title(layout_.displays_.getDisplayExternalNameById(active_id));
-        ImGui::Text("%s", title.c_str());
-        ImGui::Image(reinterpret_cast<ImTextureID>(ring.getImageIdForDisplayId(active_id)),
-            ImVec2(width_, height_));
+        drawPiPDisplay(secondary_list->at(0));
         endMenu();
     }
 }
 
+void LayoutComponent::drawPiPDisplay(uint display_id) const
+{
+    const std::string &title(layout_.displays_.getDisplayExternalNameById(display_id));
+    ImGui::Text("%s", title.c_str());
+    if (layout_.batched_displays_) {
+        ImGui::Dummy(ImVec2(width_, height_));
+        layout_.addDisplayQuad(DisplayQuad{display_id, ImGui::GetItemRectMin(), ImGui::GetItemRectSize()});
+    }
+    else {
+        Layout::DisplayRing& ring(layout_.display_states_.getDisplayRing());
+        ImGui::Image(reinterpret_cast<ImTextureID>(ring.getImageIdForDisplayId(display_id)),
+            ImVec2(width_, height_));
+    }
+    layout_.addFullSizeDisplay(display_id, UploadPriority::Secondary);
+}
+
 void LayoutComponent::getDoublePiPWindowPositions(ImVec4 &pos) const
 {
     ImGuiViewport* main_viewport(ImGui::GetMainViewport());
@@ -504,42 +599,42 @@ void LayoutComponent::getDoublePiPWindowPositions(ImVec4 &pos) const
 
 void LayoutComponent::drawDoublePiPWindows() const
 {
-    // ImGuiWindowFlags win_flags(0);
-    // win_flags |= ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoCollapse;
-    // win_flags |= ImGuiWindowFlags_NoTitleBar;
-    // win_flags |= ImGuiWindowFlags_AlwaysAutoResize;
-
-    // ImVec4 windows_pos;
-    // getDoublePiPWindowPositions(windows_pos);
-
-    // ImGui::SetNextWindowPos(ImVec2{windows_pos.x, windows_pos.y}, ImGuiCond_Once);
-    // if (startMenu("Picture-in-Picture 1", win_flags)) {
-    //     if (layout_.secondary_ring_.empty()) { 
-    //         ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "No secondary displays specified.");
-    //         endMenu();
-    //         return;
-    //     }
-
-    //     uint active_id(layout_.secondary_ring_.getActiveFrameDisplayId());
-    //     std::string title(layout_.displays_.getDisplayExternalNameById(active_id));
-    //     ImGui::Text("%s", title.c_str());
-    //     ImGui::Image(reinterpret_cast<ImTextureID>(layout_.secondary_ring_.getImageIdForDisplayId(active_id)),
-    //         ImVec2(width_, height_));
-    //     endMenu();
-    // }
-
-    // // Since window above returns when there are no secondary displays, it shouldn't be
-    // // necessary to check again
-    // ImGui::SetNextWindowPos(ImVec2{windows_pos.z, windows_pos.w}, ImGuiCond_Once);
-    // if (startMenu("Picture-in-Picture 2", win_flags)) {
-    //     // This will get the active display again if there's only one active
-    //     uint next_id(layout_.secondary_ring_.getNextActiveFrameDisplayId());
-    //     std::string title(layout_.displays_.getDisplayExternalNameById(next_id));
-    //     ImGui::Text("%s", title.c_str());
-    //     ImGui::Image(reinterpret_cast<ImTextureID>(layout_.secondary_ring_.getImageIdForDisplayId(next_id)),
-    //         ImVec2(width_, height_));
-    //     endMenu();
-    // }
+    ImGuiWindowFlags win_flags(0);
+    win_flags |= ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoCollapse;
+    win_flags |= ImGuiWindowFlags_NoTitleBar;
+    win_flags |= ImGuiWindowFlags_AlwaysAutoResize;
+    if (layout_.batched_displays_) {
+        win_flags |= ImGuiWindowFlags_NoBackground;
+    }
+
+    ImVec4 windows_pos;
+    getDoublePiPWindowPositions(windows_pos);
+
+    Layout::DisplayRing& ring(layout_.display_states_.getDisplayRing());
+    Layout::DisplayRing::RoleList secondary_list(ring.getDisplayRoleList(LayoutDisplayRole::Secondary));
+    const std::vector<uint> &secondary_displays(*secondary_list);
+
+    ImGui::SetNextWindowPos(ImVec2{windows_pos.x, windows_pos.y}, ImGuiCond_Always);
+    if (startMenu("Picture-in-Picture 1", win_flags)) {
+        if (secondary_displays.empty()) { 
+            ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "No secondary displays specified.");
+            endMenu();
+            return;
+        }
+
+        drawPiPDisplay(secondary_displays.at(0));
+        endMenu();
+    }
+
+    // With a single secondary display there's nothing for the second window to show
+    if (secondary_displays.size() < 2) {
+        return;
+    }
+    ImGui::SetNextWindowPos(ImVec2{windows_pos.z, windows_pos.w}, ImGuiCond_Always);
+    if (startMenu("Picture-in-Picture 2", win_flags)) {
+        drawPiPDisplay(secondary_displays.at(1));
+        endMenu();
+    }
 }
 
 } // viewpoint_interface
\ No newline at end of file
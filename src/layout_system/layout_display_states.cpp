@@ -21,7 +21,7 @@ uint Layout::LayoutDisplayStates::size() const { return states_.size(); }
 bool Layout::LayoutDisplayStates::empty() const { return size() == 0; }
 uint Layout::LayoutDisplayStates::getNumActiveDisplays() const { return num_active_displays_; }
 bool Layout::LayoutDisplayStates::noDisplaysActive() const { return getNumActiveDisplays() == 0; }
-uint Layout::LayoutDisplayStates::setActiveLimit(uint limit) { active_limit_ = limit; }
+uint Layout::LayoutDisplayStates::setActiveLimit(uint limit) { active_limit_ = limit; return active_limit_; }
 
 uint Layout::LayoutDisplayStates::setNumDisplaysForRole(int num, LayoutDisplayRole role)
 {
@@ -62,6 +62,8 @@ uint Layout::LayoutDisplayStates::setNumDisplaysForRole(int num, LayoutDisplayRo
 
         ++it;
     }
+
+    return role_count;
 }
 
 std::map<uint, bool>::const_iterator Layout::LayoutDisplayStates::loopStart() const { return states_.begin(); }
@@ -223,55 +225,89 @@ void Layout::LayoutDisplayStates::toPrevActiveFrame() { display_ring_.toPrevActi
 
 void Layout::LayoutDisplayStates::handleActiveFrameDirectionInput(LayoutCommand command)
 {
-    int cur_ix(display_ring_.getActiveFrameIndex());
+    const DisplayGrid &grid(display_grid_);
+    uint cur_ix(display_ring_.getActiveFrameIndex());
+    if (!grid.isOnPage(cur_ix)) {
+        return;
+    }
 
-    int factor;
+    int row(grid.getRow(cur_ix)), col(grid.getCol(cur_ix));
     switch (command)
     {
         case LayoutCommand::ACTIVE_FRAME_UP:
         {
-            factor = -1;
-
-            if (cur_ix % 2 == 0) {
-                factor = 0;
-            }
+            --row;
         }   break;
         
         case LayoutCommand::ACTIVE_FRAME_DOWN:
         {
-            factor = 1;
-
-            if (cur_ix % 2 == 1) {
-                factor = 0;
-            }
-
-            if (cur_ix == display_ring_.getNumPrimaryDisplays()-1) {
-                factor = -1;
-            }
-
+            ++row;
         }   break;
         
         case LayoutCommand::ACTIVE_FRAME_LEFT:
         {
-            factor = -2;
+            --col;
         }   break;
         
         case LayoutCommand::ACTIVE_FRAME_RIGHT:
         {
-            factor = 2;
+            ++col;
+        }   break;
+
+        default:
+        {
+            return;
         }   break;
     }
 
-    if (factor == 0) {
+    if (row < 0 || col < 0 || col >= (int)grid.cols) {
         return;
     }
 
-    int ix_to_set(cur_ix + factor);
-    if (ix_to_set < display_ring_.getNumPrimaryDisplays() && ix_to_set >= 0) {
+    uint ix_to_set(grid.page_start + (row * grid.cols) + col);
+    if (grid.isOnPage(ix_to_set)) {
         display_ring_.setActiveFrameByIndex(ix_to_set);
     }
 }
 
+bool Layout::LayoutDisplayStates::isDisplayOnPage(uint id) const
+{
+    if (display_grid_.num_pages <= 1 || !display_ring_.isPrimaryDisplay(id)) {
+        return true;
+    }
+
+    DisplayRing::RoleList primary_list(display_ring_.getDisplayRoleList(LayoutDisplayRole::Primary));
+    const std::vector<uint> &primary_displays(*primary_list);
+    for (uint ix(0); ix < primary_displays.size(); ++ix) {
+        if (primary_displays[ix] == id) {
+            return display_grid_.isOnPage(ix);
+        }
+    }
+
+    return true;
+}
+
+// Paging moves the active frame, and the grid follows it to its page
+void Layout::LayoutDisplayStates::toNextPage()
+{
+    if (display_grid_.num_pages <= 1) {
+        return;
+    }
+
+    uint next_page((display_grid_.page + 1) % display_grid_.num_pages);
+    display_ring_.setActiveFrameByIndex(next_page * display_grid_.per_page);
+}
+
+void Layout::LayoutDisplayStates::toPrevPage()
+{
+    if (display_grid_.num_pages <= 1) {
+        return;
+    }
+
+    uint prev_page(display_grid_.page == 0 ? display_grid_.num_pages - 1 : display_grid_.page - 1);
+    display_ring_.setActiveFrameByIndex(prev_page * display_grid_.per_page);
+}
+
 void Layout::LayoutDisplayStates::addImageResponseForId(uint display_id, uint gl_id)
 { 
     display_ring_.addImageResponseForId(display_id, gl_id); 
@@ -279,7 +315,7 @@ void Layout::LayoutDisplayStates::addImageResponseForId(uint display_id, uint gl
 
 uint Layout::LayoutDisplayStates::getImageIdForDisplayId(uint id) const
 {
-    display_ring_.getImageIdForDisplayId(id);
+    return display_ring_.getImageIdForDisplayId(id);
 }
 
 
@@ -0,0 +1,87 @@
+#include <cstdlib>
+
+#include <imgui/imgui.h>
+
+#include "viewpoint_interface/memory_tracker.hpp"
+
+
+namespace viewpoint_interface
+{
+
+std::atomic<int64_t> MemoryTracker::bytes_[(int)MemoryTracker::Category::Count];
+
+static const char *kCategoryNames[(int)MemoryTracker::Category::Count] = {
+    "Camera images", "Textures", "Pixel buffers", "Meshes", "ImGui"
+};
+
+// Each ImGui block is prefixed with its size, padded to keep the block aligned
+static const size_t kImGuiHeaderSize = 16;
+
+static void* imguiAlloc(size_t size, void *user_data)
+{
+    uint8_t *block((uint8_t *)malloc(size + kImGuiHeaderSize));
+    if (block == NULL) {
+        return NULL;
+    }
+
+    *(size_t *)block = size;
+    MemoryTracker::add(MemoryTracker::Category::ImGui, size);
+    return block + kImGuiHeaderSize;
+}
+
+static void imguiFree(void *ptr, void *user_data)
+{
+    if (ptr == NULL) {
+        return;
+    }
+
+    uint8_t *block((uint8_t *)ptr - kImGuiHeaderSize);
+    MemoryTracker::add(MemoryTracker::Category::ImGui, -(int64_t)*(size_t *)block);
+    free(block);
+}
+
+int64_t MemoryTracker::getTotal()
+{
+    int64_t total(0);
+    for (int i(0); i < (int)Category::Count; ++i) {
+        total += bytes_[i].load(std::memory_order_relaxed);
+    }
+
+    return total;
+}
+
+const char* MemoryTracker::categoryToString(Category category)
+{
+    return kCategoryNames[(int)category];
+}
+
+void MemoryTracker::installImGuiAllocator()
+{
+    ImGui::SetAllocatorFunctions(imguiAlloc, imguiFree);
+}
+
+void MemoryTracker::drawPanel()
+{
+    if (ImGui::BeginTable("##Memory", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Held by");
+        ImGui::TableSetupColumn("MB");
+        ImGui::TableHeadersRow();
+
+        for (int i(0); i < (int)Category::Count; ++i) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", categoryToString((Category)i));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", bytes_[i] / (1024.0 * 1024.0));
+        }
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("Total");
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", getTotal() / (1024.0 * 1024.0));
+        ImGui::EndTable();
+    }
+}
+
+} // viewpoint_interface
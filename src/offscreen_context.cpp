@@ -0,0 +1,148 @@
+#include <cstring>
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "viewpoint_interface/offscreen_context.hpp"
+#include "viewpoint_interface/memory_tracker.hpp"
+
+
+namespace viewpoint_interface
+{
+
+bool OffscreenContext::create(uint width, uint height)
+{
+    width_ = width;
+    height_ = height;
+
+    display_ = getDisplay();
+    if (display_ == EGL_NO_DISPLAY || !eglInitialize(display_, NULL, NULL)) {
+        error_ = "Could not initialize EGL display.";
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        error_ = "EGL does not support desktop OpenGL.";
+        return false;
+    }
+
+    const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint num_configs(0);
+    if (!eglChooseConfig(display_, config_attribs, &config, 1, &num_configs) || num_configs < 1) {
+        error_ = "No suitable EGL config.";
+        return false;
+    }
+
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context_ = eglCreateContext(display_, config, EGL_NO_CONTEXT, context_attribs);
+    if (context_ == EGL_NO_CONTEXT) {
+        error_ = "Could not create OpenGL 3.3 core context.";
+        return false;
+    }
+
+    // Everything is drawn to our own framebuffer, so a surface is only needed
+    // when the driver can't make a context current without one
+    if (!eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, context_)) {
+        const EGLint pbuffer_attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        surface_ = eglCreatePbufferSurface(display_, config, pbuffer_attribs);
+        if (surface_ == EGL_NO_SURFACE || !eglMakeCurrent(display_, surface_, surface_, context_)) {
+            error_ = "Could not make EGL context current.";
+            return false;
+        }
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        error_ = "Failed to initialize GLAD";
+        return false;
+    }
+
+    return createFramebuffer();
+}
+
+void OffscreenContext::destroy()
+{
+    if (display_ == EGL_NO_DISPLAY) {
+        return;
+    }
+
+    if (context_ != EGL_NO_CONTEXT && fbo_ != 0) {
+        glDeleteFramebuffers(1, &fbo_);
+        glDeleteRenderbuffers(1, &color_rbo_);
+        glDeleteRenderbuffers(1, &depth_rbo_);
+        MemoryTracker::add(MemoryTracker::Category::PixelBuffers, -(int64_t)width_ * height_ * 8);
+        fbo_ = 0;
+    }
+
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface_ != EGL_NO_SURFACE) {
+        eglDestroySurface(display_, surface_);
+        surface_ = EGL_NO_SURFACE;
+    }
+    if (context_ != EGL_NO_CONTEXT) {
+        eglDestroyContext(display_, context_);
+        context_ = EGL_NO_CONTEXT;
+    }
+    eglTerminate(display_);
+    display_ = EGL_NO_DISPLAY;
+}
+
+
+// --- Private ---
+
+EGLDisplay OffscreenContext::getDisplay() const
+{
+    const char *extensions(eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS));
+    if (extensions && std::strstr(extensions, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display((PFNEGLGETPLATFORMDISPLAYEXTPROC)
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display) {
+            EGLDisplay display(get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL));
+            if (display != EGL_NO_DISPLAY) {
+                return display;
+            }
+        }
+    }
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool OffscreenContext::createFramebuffer()
+{
+    glGenRenderbuffers(1, &color_rbo_);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_rbo_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width_, height_);
+
+    glGenRenderbuffers(1, &depth_rbo_);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_rbo_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width_, height_);
+    // Four bytes of color and four of depth and stencil per pixel
+    MemoryTracker::add(MemoryTracker::Category::PixelBuffers, (int64_t)width_ * height_ * 8);
+
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_rbo_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_rbo_);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        error_ = "Offscreen framebuffer is incomplete.";
+        return false;
+    }
+
+    return true;
+}
+
+} // viewpoint_interface
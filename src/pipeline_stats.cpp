@@ -0,0 +1,239 @@
+#include <cstdio>
+#include <algorithm>
+
+#include "viewpoint_interface/pipeline_stats.hpp"
+
+
+namespace viewpoint_interface
+{
+
+constexpr float PipelineStats::kBinMs;
+const uint PipelineStats::kNumBins;
+
+PipelineStats::PipelineStats() : last_report_(Clock::now()), frames_(0), frame_max_us_(0), bytes_uploaded_(0),
+        controller_packets_(0), last_frames_(0), last_bytes_uploaded_(0), last_controller_packets_(0)
+{
+    for (std::atomic<uint64_t> &bin : frame_bins_) {
+        bin = 0;
+    }
+    for (std::atomic<uint> &depth : queue_depths_) {
+        depth = 0;
+    }
+}
+
+void PipelineStats::addCamera(uint id, const std::string &name)
+{
+    std::unique_ptr<Camera> camera(new Camera());
+    camera->name = name;
+    camera->received = 0;
+    camera->uploaded = 0;
+    camera->dropped = 0;
+    camera->drops_known = false;
+    camera->age_sum_us = 0;
+    camera->age_count = 0;
+    camera->age_max_us = 0;
+    camera->convert_sum_us = 0;
+    camera->convert_count = 0;
+    camera->last_received = 0;
+    camera->last_uploaded = 0;
+    camera->last_age_sum_us = 0;
+    camera->last_age_count = 0;
+    camera->last_convert_sum_us = 0;
+    camera->last_convert_count = 0;
+    cameras_[id] = std::move(camera);
+}
+
+void PipelineStats::imageReceived(uint id, float age_ms)
+{
+    auto found(cameras_.find(id));
+    if (found == cameras_.end()) {
+        return;
+    }
+    Camera &camera(*found->second);
+
+    camera.received.fetch_add(1, std::memory_order_relaxed);
+
+    if (age_ms >= 0.0f) {
+        uint64_t age_us(age_ms * 1000.0f);
+        camera.age_sum_us.fetch_add(age_us, std::memory_order_relaxed);
+        camera.age_count.fetch_add(1, std::memory_order_relaxed);
+        storeMax(camera.age_max_us, age_us);
+    }
+}
+
+void PipelineStats::setDropped(uint id, uint64_t dropped)
+{
+    auto found(cameras_.find(id));
+    if (found == cameras_.end()) {
+        return;
+    }
+
+    found->second->dropped.store(dropped, std::memory_order_relaxed);
+    found->second->drops_known.store(true, std::memory_order_relaxed);
+}
+
+void PipelineStats::imageConverted(uint id, float convert_ms)
+{
+    auto found(cameras_.find(id));
+    if (found == cameras_.end()) {
+        return;
+    }
+
+    found->second->convert_sum_us.fetch_add((uint64_t)(convert_ms * 1000.0f), std::memory_order_relaxed);
+    found->second->convert_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PipelineStats::imageUploaded(uint id)
+{
+    auto found(cameras_.find(id));
+    if (found != cameras_.end()) {
+        found->second->uploaded.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void PipelineStats::frameSwapped()
+{
+    Clock::time_point now(Clock::now());
+    if (last_swap_.time_since_epoch().count() != 0) {
+        std::chrono::duration<float, std::milli> frame(now - last_swap_);
+        uint bin(std::min(kNumBins - 1, (uint)(frame.count() / kBinMs)));
+        frame_bins_[bin].fetch_add(1, std::memory_order_relaxed);
+        storeMax(frame_max_us_, (uint64_t)(frame.count() * 1000.0f));
+        frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+    last_swap_ = now;
+}
+
+diagnostic_msgs::DiagnosticArray PipelineStats::makeDiagnostics()
+{
+    Clock::time_point now(Clock::now());
+    std::chrono::duration<double> interval(now - last_report_);
+    last_report_ = now;
+    double seconds(std::max(interval.count(), 1e-3));
+
+    diagnostic_msgs::DiagnosticArray msg;
+    msg.header.stamp = ros::Time::now();
+
+    auto addValue = [](diagnostic_msgs::DiagnosticStatus &status, const std::string &key, const std::string &value) {
+        diagnostic_msgs::KeyValue key_value;
+        key_value.key = key;
+        key_value.value = value;
+        status.values.push_back(key_value);
+    };
+    auto toString = [](double value) {
+        char text[32];
+        snprintf(text, sizeof(text), "%.2f", value);
+        return std::string(text);
+    };
+
+    // The histogram is taken bin by bin, so a frame landing meanwhile is counted in this report or the next
+    std::vector<uint64_t> bins(kNumBins);
+    uint64_t num_binned(0);
+    for (uint i(0); i < kNumBins; ++i) {
+        bins[i] = frame_bins_[i].exchange(0, std::memory_order_relaxed);
+        num_binned += bins[i];
+    }
+    uint64_t frame_max_us(frame_max_us_.exchange(0, std::memory_order_relaxed));
+    uint64_t frames(frames_.load(std::memory_order_relaxed));
+    uint64_t bytes_uploaded(bytes_uploaded_.load(std::memory_order_relaxed));
+    uint64_t controller_packets(controller_packets_.load(std::memory_order_relaxed));
+
+    diagnostic_msgs::DiagnosticStatus pipeline;
+    pipeline.name = "viewpoint_interface: Pipeline";
+    pipeline.hardware_id = "viewpoint_interface";
+    pipeline.level = diagnostic_msgs::DiagnosticStatus::OK;
+    float p99_ms(getBinPercentile(bins, num_binned, 0.99f));
+    pipeline.message = num_binned == 0 ? "No frames" : "p99 frame " + toString(p99_ms) + " ms";
+    if (num_binned == 0) {
+        pipeline.level = diagnostic_msgs::DiagnosticStatus::WARN;
+    }
+    addValue(pipeline, "Frame rate (Hz)", toString((frames - last_frames_) / seconds));
+    addValue(pipeline, "Frame time p50 (ms)", toString(getBinPercentile(bins, num_binned, 0.5f)));
+    addValue(pipeline, "Frame time p90 (ms)", toString(getBinPercentile(bins, num_binned, 0.9f)));
+    addValue(pipeline, "Frame time p99 (ms)", toString(p99_ms));
+    addValue(pipeline, "Frame time max (ms)", toString(frame_max_us / 1000.0));
+    addValue(pipeline, "Upload (MB/s)", toString((bytes_uploaded - last_bytes_uploaded_) / seconds / (1024.0 * 1024.0)));
+    addValue(pipeline, "Controller packets (Hz)", toString((controller_packets - last_controller_packets_) / seconds));
+    addValue(pipeline, "Image requests", std::to_string(queue_depths_[(int)Queue::ImageRequests].load()));
+    addValue(pipeline, "Pending uploads", std::to_string(queue_depths_[(int)Queue::PendingUploads].load()));
+    addValue(pipeline, "Thumbnail requests", std::to_string(queue_depths_[(int)Queue::ThumbnailRequests].load()));
+    msg.status.push_back(pipeline);
+    last_frames_ = frames;
+    last_bytes_uploaded_ = bytes_uploaded;
+    last_controller_packets_ = controller_packets;
+
+    for (auto &entry : cameras_) {
+        Camera &camera(*entry.second);
+        uint64_t received(camera.received.load(std::memory_order_relaxed));
+        uint64_t uploaded(camera.uploaded.load(std::memory_order_relaxed));
+        uint64_t age_sum_us(camera.age_sum_us.load(std::memory_order_relaxed));
+        uint64_t age_count(camera.age_count.load(std::memory_order_relaxed));
+        uint64_t convert_sum_us(camera.convert_sum_us.load(std::memory_order_relaxed));
+        uint64_t convert_count(camera.convert_count.load(std::memory_order_relaxed));
+        uint64_t age_max_us(camera.age_max_us.exchange(0, std::memory_order_relaxed));
+
+        diagnostic_msgs::DiagnosticStatus status;
+        status.name = "viewpoint_interface: Camera " + camera.name;
+        status.hardware_id = "viewpoint_interface";
+        if (received == camera.last_received) {
+            status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+            status.message = received == 0 ? "No images yet" : "No images";
+        }
+        else {
+            status.level = diagnostic_msgs::DiagnosticStatus::OK;
+            status.message = "OK";
+        }
+
+        uint64_t num_ages(age_count - camera.last_age_count);
+        uint64_t num_converts(convert_count - camera.last_convert_count);
+        addValue(status, "Received (Hz)", toString((received - camera.last_received) / seconds));
+        addValue(status, "Displayed (Hz)", toString((uploaded - camera.last_uploaded) / seconds));
+        addValue(status, "Dropped", camera.drops_known.load(std::memory_order_relaxed) ?
+                std::to_string(camera.dropped.load(std::memory_order_relaxed)) : "unknown");
+        addValue(status, "Frame age (ms)", toString(num_ages == 0 ? 0.0 :
+                (age_sum_us - camera.last_age_sum_us) / 1000.0 / num_ages));
+        addValue(status, "Frame age max (ms)", toString(age_max_us / 1000.0));
+        addValue(status, "Conversion (ms)", toString(num_converts == 0 ? 0.0 :
+                (convert_sum_us - camera.last_convert_sum_us) / 1000.0 / num_converts));
+        msg.status.push_back(status);
+
+        camera.last_received = received;
+        camera.last_uploaded = uploaded;
+        camera.last_age_sum_us = age_sum_us;
+        camera.last_age_count = age_count;
+        camera.last_convert_sum_us = convert_sum_us;
+        camera.last_convert_count = convert_count;
+    }
+
+    return msg;
+}
+
+
+// --- Private ---
+
+void PipelineStats::storeMax(std::atomic<uint64_t> &max, uint64_t value)
+{
+    uint64_t current(max.load(std::memory_order_relaxed));
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+float PipelineStats::getBinPercentile(const std::vector<uint64_t> &bins, uint64_t total, float fraction)
+{
+    if (total == 0) {
+        return 0.0f;
+    }
+
+    // Upper edge of the bin holding the sample at that fraction
+    uint64_t target(std::max<uint64_t>(1, (uint64_t)(fraction * total + 0.5f)));
+    uint64_t count(0);
+    for (uint i(0); i < bins.size(); ++i) {
+        count += bins[i];
+        if (count >= target) {
+            return (i + 1) * kBinMs;
+        }
+    }
+
+    return bins.size() * kBinMs;
+}
+
+} // viewpoint_interface
@@ -0,0 +1,535 @@
+#include <ctime>
+#include <cstdio>
+#include <algorithm>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <imgui/imgui.h>
+
+#include "viewpoint_interface/profiler.hpp"
+
+
+namespace viewpoint_interface
+{
+
+const uint Profiler::kRingSize;
+const uint Profiler::kMaxThreads;
+const uint Profiler::kFrameHistory;
+const uint Profiler::kMaxCaptureSamples;
+
+std::atomic<bool> Profiler::enabled_(false);
+std::atomic<bool> Profiler::capturing_(false);
+std::atomic<Profiler::ThreadRing*> Profiler::rings_[Profiler::kMaxThreads];
+std::atomic<uint> Profiler::num_rings_(0);
+std::atomic<uint64_t> Profiler::unregistered_dropped_(0);
+thread_local Profiler::ThreadRing* Profiler::thread_ring_(NULL);
+thread_local const char* Profiler::thread_name_(NULL);
+thread_local bool Profiler::thread_ring_full_(false);
+
+Profiler& getProfiler()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::setThreadName(const char *name)
+{
+    if (thread_name_ == name) {
+        return;
+    }
+    thread_name_ = name;
+
+    // The OS thread gets the name too, so its CPU time can be told apart in /proc and top
+    char os_name[16];
+    snprintf(os_name, sizeof(os_name), "%s", name);
+    pthread_setname_np(pthread_self(), os_name);
+}
+
+uint16_t Profiler::enterZone()
+{
+    ThreadRing *ring(getThreadRing());
+    if (ring == NULL) {
+        return 0;
+    }
+
+    return ring->depth++;
+}
+
+void Profiler::exitZone(const char *name, int64_t start_ns, uint16_t depth)
+{
+    Sample sample;
+    sample.name = name;
+    sample.start_ns = start_ns;
+    sample.end_ns = now();
+    sample.flow_id = 0;
+    sample.depth = depth;
+    sample.kind = SampleKind::Zone;
+    pushSample(sample);
+
+    if (thread_ring_ != NULL) {
+        thread_ring_->depth = depth;
+    }
+}
+
+void Profiler::flow(const char *name, SampleKind kind, uint64_t id)
+{
+    if (!isCapturing()) {
+        return;
+    }
+
+    Sample sample;
+    sample.name = name;
+    sample.start_ns = now();
+    sample.end_ns = sample.start_ns;
+    sample.flow_id = id;
+    sample.depth = 0;
+    sample.kind = kind;
+    pushSample(sample);
+}
+
+uint64_t Profiler::getNumDropped()
+{
+    uint64_t dropped(unregistered_dropped_.load(std::memory_order_relaxed));
+    uint num_rings(std::min(num_rings_.load(std::memory_order_acquire), kMaxThreads));
+    for (uint i(0); i < num_rings; ++i) {
+        ThreadRing *ring(rings_[i].load(std::memory_order_acquire));
+        if (ring != NULL) {
+            dropped += ring->dropped.load(std::memory_order_relaxed);
+        }
+    }
+
+    return dropped;
+}
+
+Profiler::~Profiler()
+{
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+void Profiler::setCaptureParams(float seconds, const std::string &dir)
+{
+    capture_seconds_ = seconds;
+    capture_dir_ = dir;
+}
+
+bool Profiler::requestCapture()
+{
+    if (isCapturing() || writing_) {
+        return false;
+    }
+
+    capture_requested_ = true;
+    return true;
+}
+
+bool Profiler::takeCaptureResult(std::string &result)
+{
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    if (!has_result_) {
+        return false;
+    }
+
+    result = result_;
+    has_result_ = false;
+    return true;
+}
+
+void Profiler::frameMark()
+{
+    int64_t now_ns(now());
+    if (capture_requested_.exchange(false) && !isCapturing() && !writing_) {
+        startCapture(now_ns);
+    }
+    bool record(isEnabled() && last_mark_ns_ != 0);
+
+    Frame &frame(frames_[next_frame_]);
+    bool keep_frame(record && !paused_);
+    if (keep_frame) {
+        frame.start_ns = last_mark_ns_;
+        frame.end_ns = now_ns;
+        frame.samples.clear();
+    }
+
+    for (auto &zone : zones_) {
+        zone.second.frame_ms = 0.0f;
+        zone.second.frame_calls = 0;
+    }
+
+    // Zones from other threads are counted in the frame they are drained in
+    uint num_rings(std::min(num_rings_.load(std::memory_order_acquire), kMaxThreads));
+    for (uint i(0); i < num_rings; ++i) {
+        ThreadRing *ring(rings_[i].load(std::memory_order_acquire));
+        if (ring == NULL) {
+            continue;
+        }
+
+        uint64_t head(ring->head.load(std::memory_order_acquire));
+        uint64_t tail(ring->tail.load(std::memory_order_relaxed));
+        for (; record && tail != head; ++tail) {
+            Sample sample(ring->samples[tail % kRingSize]);
+            sample.thread = i;
+
+            if (isCapturing()) {
+                capture_.push_back(sample);
+            }
+            if (sample.kind != SampleKind::Zone) {
+                continue;
+            }
+
+            auto zone(zones_.find(sample.name));
+            if (zone == zones_.end()) {
+                zone = zones_.emplace(sample.name, ZoneStats()).first;
+            }
+            zone->second.thread = i;
+            zone->second.frame_ms += (sample.end_ns - sample.start_ns) / 1.0e6f;
+            ++zone->second.frame_calls;
+
+            if (keep_frame) {
+                frame.samples.push_back(sample);
+            }
+        }
+        ring->tail.store(head, std::memory_order_release);
+    }
+
+    if (record) {
+        for (auto &zone : zones_) {
+            ZoneStats &stats(zone.second);
+            stats.last_ms = stats.frame_ms;
+            stats.last_calls = stats.frame_calls;
+            stats.mean_ms = (0.95f * stats.mean_ms) + (0.05f * stats.frame_ms);
+            stats.max_ms = std::max(stats.max_ms, stats.frame_ms);
+        }
+    }
+
+    if (keep_frame) {
+        next_frame_ = (next_frame_ + 1) % kFrameHistory;
+        num_frames_ = std::min(num_frames_ + 1, kFrameHistory);
+    }
+    last_mark_ns_ = now_ns;
+
+    if (isCapturing() && (now_ns >= capture_end_ns_ || capture_.size() >= kMaxCaptureSamples)) {
+        finishCapture();
+    }
+}
+
+void Profiler::drawPanel()
+{
+    bool enabled(isEnabled());
+    if (ImGui::Checkbox("Enabled", &enabled)) {
+        setEnabled(enabled);
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Pause", &paused_);
+    ImGui::SameLine();
+    if (ImGui::Button("Reset")) {
+        zones_.clear();
+        num_frames_ = 0;
+        selected_frame_ = 0;
+    }
+
+#ifndef VIEWPOINT_PROFILER
+    ImGui::Text("Built without VIEWPOINT_PROFILER, no zones are recorded");
+#endif
+    ImGui::Text("Threads: %u, dropped zones: %llu", std::min(num_rings_.load(), kMaxThreads),
+            (unsigned long long)getNumDropped());
+
+    if (isCapturing()) {
+        ImGui::Text("Capturing trace: %.1f s left", std::max<int64_t>(0, capture_end_ns_ - now()) / 1.0e9f);
+    }
+    else if (writing_) {
+        ImGui::Text("Writing %s", capture_path_.c_str());
+    }
+    else if (ImGui::Button("Capture trace")) {
+        requestCapture();
+    }
+
+    if (zones_.empty()) {
+        return;
+    }
+
+    if (ImGui::BeginTable("##Zones", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("Thread");
+        ImGui::TableSetupColumn("Last ms");
+        ImGui::TableSetupColumn("Mean ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableHeadersRow();
+
+        for (const auto &zone : zones_) {
+            const ZoneStats &stats(zone.second);
+            ThreadRing *ring(rings_[stats.thread].load(std::memory_order_acquire));
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", zone.first);
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", ring != NULL ? ring->name : "");
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.last_ms);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.mean_ms);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.max_ms);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", stats.last_calls);
+        }
+        ImGui::EndTable();
+    }
+
+    if (num_frames_ == 0) {
+        return;
+    }
+
+    selected_frame_ = std::min(selected_frame_, (int)num_frames_ - 1);
+    ImGui::SliderInt("Frames ago", &selected_frame_, 0, num_frames_ - 1);
+    drawFlameGraph(frames_[(next_frame_ + kFrameHistory - 1 - selected_frame_) % kFrameHistory]);
+}
+
+bool Profiler::getZoneMeanMs(const char *name, float &mean_ms) const
+{
+    auto zone(zones_.find(name));
+    if (zone == zones_.end()) {
+        return false;
+    }
+
+    mean_ms = zone->second.mean_ms;
+    return true;
+}
+
+
+// --- Private ---
+
+Profiler::ThreadRing* Profiler::getThreadRing()
+{
+    if (thread_ring_ != NULL || thread_ring_full_) {
+        return thread_ring_;
+    }
+
+    // The count never passes kMaxThreads, and threads that found no ring left
+    // don't try again
+    uint ix(num_rings_.load());
+    do {
+        if (ix >= kMaxThreads) {
+            thread_ring_full_ = true;
+            return NULL;
+        }
+    } while (!num_rings_.compare_exchange_weak(ix, ix + 1));
+
+    // Registered once per thread and kept for the life of the process, so the
+    // render thread never reads a ring that was freed
+    ThreadRing *ring(new ThreadRing());
+    if (thread_name_ != NULL) {
+        snprintf(ring->name, sizeof(ring->name), "%s", thread_name_);
+    }
+    else {
+        snprintf(ring->name, sizeof(ring->name), "thread %u", ix);
+    }
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+    ring->depth = 0;
+
+    rings_[ix].store(ring, std::memory_order_release);
+    thread_ring_ = ring;
+    return ring;
+}
+
+void Profiler::pushSample(const Sample &sample)
+{
+    ThreadRing *ring(getThreadRing());
+    if (ring == NULL) {
+        unregistered_dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Only this thread moves head, so a full ring just drops the sample
+    uint64_t head(ring->head.load(std::memory_order_relaxed));
+    if (head - ring->tail.load(std::memory_order_acquire) >= kRingSize) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring->samples[head % kRingSize] = sample;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::startCapture(int64_t now_ns)
+{
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+
+    char stamp[32];
+    time_t wall_time(time(NULL));
+    tm local_time;
+    localtime_r(&wall_time, &local_time);
+    strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &local_time);
+    capture_path_ = capture_dir_ + "/viewpoint_trace_" + stamp + ".json";
+
+    capture_.clear();
+    capture_.reserve(64 * 1024);
+    capture_end_ns_ = now_ns + (int64_t)(capture_seconds_ * 1.0e9f);
+
+    // Zones are only recorded while enabled, so a capture enables them until it ends
+    was_enabled_ = isEnabled();
+    setEnabled(true);
+    capturing_ = true;
+}
+
+void Profiler::finishCapture()
+{
+    capturing_ = false;
+    setEnabled(was_enabled_);
+
+    std::vector<std::string> thread_names;
+    uint num_rings(std::min(num_rings_.load(std::memory_order_acquire), kMaxThreads));
+    for (uint i(0); i < num_rings; ++i) {
+        ThreadRing *ring(rings_[i].load(std::memory_order_acquire));
+        thread_names.push_back(ring != NULL ? ring->name : "");
+    }
+
+    // Writing a few seconds of samples takes long enough to drop frames
+    writing_ = true;
+    std::vector<Sample> samples;
+    samples.swap(capture_);
+    writer_ = std::thread(&Profiler::writeCapture, this, std::move(samples), std::move(thread_names),
+            capture_path_);
+}
+
+void Profiler::writeCapture(std::vector<Sample> samples, std::vector<std::string> thread_names, std::string path)
+{
+    std::string result;
+    FILE *file(fopen(path.c_str(), "w"));
+    if (file == NULL) {
+        result = "Could not open " + path;
+    }
+    else {
+        int64_t base_ns(samples.empty() ? 0 : samples.front().start_ns);
+        for (const Sample &sample : samples) {
+            base_ns = std::min(base_ns, sample.start_ns);
+        }
+        int pid(getpid());
+
+        fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+        fprintf(file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"args\": "
+                "{\"name\": \"viewpoint_interface\"}}", pid);
+        for (uint i(0); i < thread_names.size(); ++i) {
+            fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %u, "
+                    "\"args\": {\"name\": \"%s\"}}", pid, i, thread_names[i].c_str());
+        }
+
+        // Timestamps and durations are in microseconds. Flow points bind to
+        // the zone around them, the end point to the zone it falls inside
+        for (const Sample &sample : samples) {
+            double ts((sample.start_ns - base_ns) / 1000.0);
+            switch (sample.kind)
+            {
+                case SampleKind::Zone:
+                {
+                    fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"zone\", \"ph\": \"X\", \"ts\": %.3f, "
+                            "\"dur\": %.3f, \"pid\": %d, \"tid\": %u}", sample.name, ts,
+                            (sample.end_ns - sample.start_ns) / 1000.0, pid, sample.thread);
+                }   break;
+
+                case SampleKind::FlowStart:
+                case SampleKind::FlowStep:
+                case SampleKind::FlowEnd:
+                {
+                    const char *phase(sample.kind == SampleKind::FlowStart ? "s" :
+                            (sample.kind == SampleKind::FlowStep ? "t" : "f"));
+                    fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"flow\", \"ph\": \"%s\", \"id\": %llu, "
+                            "\"ts\": %.3f, \"pid\": %d, \"tid\": %u%s}", sample.name, phase,
+                            (unsigned long long)sample.flow_id, ts, pid, sample.thread,
+                            sample.kind == SampleKind::FlowEnd ? ", \"bp\": \"e\"" : "");
+                }   break;
+            }
+        }
+        fprintf(file, "\n]}\n");
+
+        if (fclose(file) != 0) {
+            result = "Could not write " + path;
+        }
+        else {
+            result = "Wrote " + std::to_string(samples.size()) + " trace events to " + path;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    result_ = result;
+    has_result_ = true;
+    writing_ = false;
+}
+
+void Profiler::drawFlameGraph(const Frame &frame)
+{
+    int64_t duration_ns(std::max<int64_t>(1, frame.end_ns - frame.start_ns));
+    ImGui::Text("Frame: %.2f ms", duration_ns / 1.0e6f);
+
+    // One lane per thread, as deep as its deepest zone
+    int max_depth[kMaxThreads];
+    std::fill(max_depth, max_depth + kMaxThreads, -1);
+    for (const Sample &sample : frame.samples) {
+        max_depth[sample.thread] = std::max(max_depth[sample.thread], (int)sample.depth);
+    }
+
+    float row_height(ImGui::GetTextLineHeight() + 2.0f);
+    float lane_y[kMaxThreads];
+    float height(0.0f);
+    for (uint i(0); i < kMaxThreads; ++i) {
+        lane_y[i] = height;
+        if (max_depth[i] >= 0) {
+            height += (max_depth[i] + 2) * row_height;
+        }
+    }
+    if (height == 0.0f) {
+        return;
+    }
+
+    ImVec2 origin(ImGui::GetCursorScreenPos());
+    ImVec2 size(std::max(100.0f, ImGui::GetContentRegionAvail().x), height);
+    ImGui::InvisibleButton("##Flame graph", size);
+
+    ImDrawList *draw_list(ImGui::GetWindowDrawList());
+    ImVec2 end(origin.x + size.x, origin.y + size.y);
+    draw_list->PushClipRect(origin, end, true);
+    draw_list->AddRectFilled(origin, end, ImGui::GetColorU32(ImGuiCol_FrameBg));
+
+    for (uint i(0); i < kMaxThreads; ++i) {
+        ThreadRing *ring(rings_[i].load(std::memory_order_acquire));
+        if (max_depth[i] >= 0 && ring != NULL) {
+            draw_list->AddText(ImVec2(origin.x + 2.0f, origin.y + lane_y[i]), ImGui::GetColorU32(ImGuiCol_Text),
+                    ring->name);
+        }
+    }
+
+    float scale(size.x / duration_ns);
+    for (const Sample &sample : frame.samples) {
+        float x0(origin.x + (std::max(sample.start_ns, frame.start_ns) - frame.start_ns) * scale);
+        float x1(origin.x + (std::min(sample.end_ns, frame.end_ns) - frame.start_ns) * scale);
+        x1 = std::max(x1, x0 + 1.0f);
+        float y0(origin.y + lane_y[sample.thread] + (sample.depth + 1) * row_height);
+        ImVec2 min(x0, y0), max(x1, y0 + row_height - 1.0f);
+
+        // Same colour for a zone in every frame
+        uint32_t hash(2166136261u);
+        for (const char *c(sample.name); *c != '\0'; ++c) {
+            hash = (hash ^ (uint8_t)*c) * 16777619u;
+        }
+        draw_list->AddRectFilled(min, max, IM_COL32(80 + hash % 150, 80 + (hash >> 8) % 150,
+                80 + (hash >> 16) % 150, 255));
+
+        if (x1 - x0 > ImGui::CalcTextSize(sample.name).x + 4.0f) {
+            draw_list->AddText(ImVec2(x0 + 2.0f, y0), IM_COL32_WHITE, sample.name);
+        }
+        if (ImGui::IsMouseHoveringRect(min, max)) {
+            ImGui::SetTooltip("%s: %.3f ms", sample.name, (sample.end_ns - sample.start_ns) / 1.0e6f);
+        }
+    }
+
+    draw_list->PopClipRect();
+}
+
+} // viewpoint_interface
@@ -0,0 +1,97 @@
+#include <cstdio>
+
+#include <imgui/imgui.h>
+
+#include "viewpoint_interface/quality_governor.hpp"
+
+
+namespace viewpoint_interface
+{
+
+const uint QualityGovernor::kStepDownFrames;
+const uint QualityGovernor::kStepUpFrames;
+constexpr float QualityGovernor::kRecoverFactor;
+constexpr float QualityGovernor::kReducedSecondaryRate;
+constexpr float QualityGovernor::kReducedSecondaryScale;
+constexpr float QualityGovernor::kDecimatedPrimaryRate;
+
+static const char* kStageNames[] = { "full", "secondary_rate", "secondary_resolution", "primary_decimation" };
+
+const char* QualityGovernor::stageToString(Stage stage)
+{
+    return kStageNames[(int)stage];
+}
+
+void QualityGovernor::setEnabled(bool enabled)
+{
+    enabled_ = enabled;
+    frames_over_ = 0;
+    frames_under_ = 0;
+}
+
+bool QualityGovernor::update(float work_ms, float target_ms)
+{
+    last_work_ms_ = work_ms;
+    last_target_ms_ = target_ms;
+
+    if (!enabled_) {
+        if (stage_ != Stage::Full) {
+            setStage(Stage::Full, "governor disabled");
+            return true;
+        }
+        return false;
+    }
+
+    if (target_ms <= 0.0f) {
+        return false;
+    }
+
+    frames_over_ = (work_ms > target_ms) ? frames_over_ + 1 : 0;
+    frames_under_ = (work_ms < kRecoverFactor * target_ms) ? frames_under_ + 1 : 0;
+
+    if (frames_over_ >= kStepDownFrames && stage_ != Stage::PrimaryDecimation) {
+        setStage((Stage)((int)stage_ + 1), "over budget");
+        return true;
+    }
+
+    if (frames_under_ >= kStepUpFrames && stage_ != Stage::Full) {
+        setStage((Stage)((int)stage_ - 1), "recovered");
+        return true;
+    }
+
+    return false;
+}
+
+void QualityGovernor::drawPanel()
+{
+    bool enabled(enabled_);
+    if (ImGui::Checkbox("Enabled", &enabled)) {
+        setEnabled(enabled);
+    }
+
+    ImGui::Text("Stage: %s", stageToString(stage_));
+    ImGui::Text("Build + render: %.2f ms of %.2f ms", last_work_ms_, last_target_ms_);
+    ImGui::Text("Transitions: %llu", (unsigned long long)num_transitions_);
+    if (!transition_.empty()) {
+        ImGui::TextWrapped("Last: %s", transition_.c_str());
+    }
+}
+
+
+// --- Private ---
+
+void QualityGovernor::setStage(Stage stage, const char *reason)
+{
+    char text[160];
+    snprintf(text, sizeof(text), "%s -> %s (%s, %.2f ms of %.2f ms)", stageToString(stage_),
+            stageToString(stage), reason, last_work_ms_, last_target_ms_);
+    transition_ = text;
+
+    // Each stage gets a full window to take effect before the next decision
+    stage_ = stage;
+    frames_over_ = 0;
+    frames_under_ = 0;
+    ++num_transitions_;
+}
+
+} // viewpoint_interface
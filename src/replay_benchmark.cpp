@@ -0,0 +1,293 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "viewpoint_interface/replay_benchmark.hpp"
+
+
+namespace viewpoint_interface
+{
+
+const int64_t ReplayBenchmark::kMaxCameraWaitMs;
+const uint ReplayBenchmark::kSwapsPerImage;
+
+void ReplayBenchmark::addCamera(uint id, const std::string &name)
+{
+    std::unique_ptr<Camera> camera(new Camera());
+    camera->name = name;
+    camera->ingested = 0;
+    camera->uploaded = 0;
+    camera->displayed = 0;
+    camera->ingest_ns = 0;
+    camera->ingest_pending = false;
+    camera->wait_uploads = 0;
+    camera->wait_swaps = 0;
+    cameras_[id] = std::move(camera);
+}
+
+void ReplayBenchmark::start()
+{
+    start_cpu_ = readThreadCpu();
+    start_time_ = Clock::now();
+}
+
+void ReplayBenchmark::finish(uint64_t num_messages, double bag_seconds)
+{
+    std::chrono::duration<double> wall(Clock::now() - start_time_);
+    end_cpu_ = readThreadCpu();
+    wall_seconds_ = wall.count();
+    num_messages_ = num_messages;
+    bag_seconds_ = bag_seconds;
+    finished_ = true;
+}
+
+void ReplayBenchmark::imageIngested(uint id, Clock::time_point time)
+{
+    auto found(cameras_.find(id));
+    if (found == cameras_.end()) {
+        return;
+    }
+    Camera &camera(*found->second);
+
+    std::lock_guard<std::mutex> lock(swap_mutex_);
+    ++camera.ingested;
+    camera.ingest_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    camera.ingest_pending = true;
+    camera.wait_uploads = camera.uploaded;
+    camera.wait_swaps = num_swaps_;
+}
+
+void ReplayBenchmark::waitForCamera(uint id)
+{
+    auto found(cameras_.find(id));
+    if (found == cameras_.end() || found->second->ingested == 0) {
+        return;
+    }
+    Camera &camera(*found->second);
+
+    std::unique_lock<std::mutex> lock(swap_mutex_);
+    swapped_.wait_for(lock, std::chrono::milliseconds(kMaxCameraWaitMs), [this, &camera]() {
+        return camera.uploaded != camera.wait_uploads || num_swaps_ >= camera.wait_swaps + kSwapsPerImage;
+    });
+}
+
+void ReplayBenchmark::imageUploaded(uint id)
+{
+    auto found(cameras_.find(id));
+    if (found == cameras_.end()) {
+        return;
+    }
+
+    Camera &camera(*found->second);
+
+    // Uploads of displays the scheduler sees for the first time, or repeats of
+    // an image that was already counted, don't carry a new ingest
+    int64_t ingest_ns;
+    {
+        std::lock_guard<std::mutex> lock(swap_mutex_);
+        if (!camera.ingest_pending) {
+            return;
+        }
+        camera.ingest_pending = false;
+        ++camera.uploaded;
+        ingest_ns = camera.ingest_ns;
+    }
+    pending_.emplace_back(id, ingest_ns);
+}
+
+void ReplayBenchmark::frameSwapped()
+{
+    Clock::time_point now(Clock::now());
+    int64_t now_ns(std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count());
+
+    for (const std::pair<uint, int64_t> &image : pending_) {
+        ++cameras_.at(image.first)->displayed;
+        latencies_ms_.push_back((now_ns - image.second) / 1e6f);
+    }
+    pending_.clear();
+
+    if (last_swap_.time_since_epoch().count() != 0) {
+        std::chrono::duration<float, std::milli> frame(now - last_swap_);
+        frame_ms_.push_back(frame.count());
+    }
+    last_swap_ = now;
+
+    // The lock keeps the bag thread from missing the notification between its check and its wait
+    {
+        std::lock_guard<std::mutex> lock(swap_mutex_);
+        ++num_swaps_;
+    }
+    swapped_.notify_all();
+}
+
+std::string ReplayBenchmark::getReport() const
+{
+    std::string report;
+    if (!finished_) {
+        return "Bag replay didn't run, benchmark FAILED";
+    }
+
+    char line[256];
+
+    snprintf(line, sizeof(line), "Bag replay: %llu messages, %.2f s of bag in %.2f s (%.2fx real time)\n",
+            (unsigned long long)num_messages_, bag_seconds_, wall_seconds_,
+            wall_seconds_ > 0.0 ? bag_seconds_ / wall_seconds_ : 0.0);
+    report += line;
+
+    snprintf(line, sizeof(line), "%-24s %10s %10s %10s %10s\n", "Camera", "Ingested", "Uploaded", "Displayed",
+            "Disp. Hz");
+    report += line;
+    for (const auto &camera : cameras_) {
+        snprintf(line, sizeof(line), "%-24s %10llu %10llu %10llu %10.1f\n", camera.second->name.c_str(),
+                (unsigned long long)camera.second->ingested.load(), (unsigned long long)camera.second->uploaded.load(),
+                (unsigned long long)camera.second->displayed,
+                wall_seconds_ > 0.0 ? camera.second->displayed / wall_seconds_ : 0.0);
+        report += line;
+    }
+
+    if (!latencies_ms_.empty()) {
+        snprintf(line, sizeof(line), "Ingest to swap: p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+                percentile(latencies_ms_, 0.5f), percentile(latencies_ms_, 0.9f), percentile(latencies_ms_, 0.99f),
+                percentile(latencies_ms_, 1.0f));
+        report += line;
+    }
+    if (!frame_ms_.empty()) {
+        snprintf(line, sizeof(line), "Frame time: %zu frames, p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+                frame_ms_.size(), percentile(frame_ms_, 0.5f), percentile(frame_ms_, 0.9f),
+                percentile(frame_ms_, 0.99f), percentile(frame_ms_, 1.0f));
+        report += line;
+    }
+
+    // Threads sharing a name, like the ROS callback threads, are added up
+    std::map<std::string, double> cpu_by_name;
+    for (const auto &thread : end_cpu_) {
+        auto start(start_cpu_.find(thread.first));
+        double start_seconds(start != start_cpu_.end() ? start->second.seconds : 0.0);
+        cpu_by_name[thread.second.name] += thread.second.seconds - start_seconds;
+    }
+    report += "CPU per thread:\n";
+    for (const auto &thread : cpu_by_name) {
+        if (thread.second <= 0.0) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "  %-24s %8.2f s %6.1f %%\n", thread.first.c_str(), thread.second,
+                wall_seconds_ > 0.0 ? 100.0 * thread.second / wall_seconds_ : 0.0);
+        report += line;
+    }
+
+    snprintf(line, sizeof(line), "Peak RSS: %.1f MB\n", getPeakRssMb());
+    report += line;
+
+    bool passed(checkThresholds(&report));
+    report += passed ? "Benchmark passed" : "Benchmark FAILED";
+
+    return report;
+}
+
+bool ReplayBenchmark::passed() const
+{
+    return finished_ && checkThresholds(NULL);
+}
+
+
+// --- Private ---
+
+bool ReplayBenchmark::checkThresholds(std::string *report) const
+{
+    bool passed(true);
+    auto check = [&passed, report](const char *name, float value, float limit) {
+        if (limit <= 0.0f) {
+            return;
+        }
+
+        bool ok(value <= limit);
+        passed = passed && ok;
+        if (report != NULL) {
+            char line[128];
+            snprintf(line, sizeof(line), "%s %.2f (limit %.2f): %s\n", name, value, limit, ok ? "ok" : "EXCEEDED");
+            *report += line;
+        }
+    };
+
+    check("p99 ingest to swap ms", latencies_ms_.empty() ? 0.0f : percentile(latencies_ms_, 0.99f),
+            thresholds_.max_latency_ms);
+    check("p99 frame time ms", frame_ms_.empty() ? 0.0f : percentile(frame_ms_, 0.99f), thresholds_.max_frame_ms);
+    check("Peak RSS MB", getPeakRssMb(), thresholds_.max_rss_mb);
+
+    return passed;
+}
+
+std::map<int, ReplayBenchmark::ThreadCpu> ReplayBenchmark::readThreadCpu()
+{
+    std::map<int, ThreadCpu> threads;
+    DIR *dir(opendir("/proc/self/task"));
+    if (dir == NULL) {
+        return threads;
+    }
+
+    double ticks_per_second(sysconf(_SC_CLK_TCK));
+    while (dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+
+        std::ifstream file(std::string("/proc/self/task/") + entry->d_name + "/stat");
+        std::string stat;
+        if (!std::getline(file, stat)) {
+            continue;
+        }
+
+        // The name is in parentheses and may contain spaces, the fields after it are
+        // the state and then utime and stime in 12th and 13th place
+        size_t open(stat.find('(')), close(stat.rfind(')'));
+        if (open == std::string::npos || close == std::string::npos || close < open) {
+            continue;
+        }
+        std::istringstream fields(stat.substr(close + 1));
+        std::string field;
+        unsigned long long utime(0), stime(0);
+        for (int i(0); i < 13 && (fields >> field); ++i) {
+            if (i == 11) {
+                utime = std::strtoull(field.c_str(), NULL, 10);
+            }
+            else if (i == 12) {
+                stime = std::strtoull(field.c_str(), NULL, 10);
+            }
+        }
+
+        ThreadCpu &thread(threads[std::atoi(entry->d_name)]);
+        thread.name = stat.substr(open + 1, close - open - 1);
+        thread.seconds = (utime + stime) / ticks_per_second;
+    }
+    closedir(dir);
+
+    return threads;
+}
+
+float ReplayBenchmark::getPeakRssMb()
+{
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0f;
+    }
+
+    return usage.ru_maxrss / 1024.0f; // Kilobytes on Linux
+}
+
+float ReplayBenchmark::percentile(std::vector<float> values, float fraction)
+{
+    if (values.empty()) {
+        return 0.0f;
+    }
+
+    size_t ix(std::min(values.size() - 1, (size_t)(fraction * (values.size() - 1) + 0.5f)));
+    std::nth_element(values.begin(), values.begin() + ix, values.end());
+    return values[ix];
+}
+
+} // viewpoint_interface
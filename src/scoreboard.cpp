@@ -1,9 +1,9 @@
 #include "viewpoint_interface/scoreboard.hpp"
 
 // ImGui menu management functions
-static bool startMenu(std::string title, ImGuiWindowFlags window_flags)
+static bool startMenu(const char *title, ImGuiWindowFlags window_flags)
 {
-    if (!ImGui::Begin(title.c_str(), (bool *)NULL, window_flags)) {
+    if (!ImGui::Begin(title, (bool *)NULL, window_flags)) {
         ImGui::End();
         return false;    
     }
@@ -24,7 +24,7 @@ void Scoreboard::checkMessageExpiration()
     std::vector<ScoreMessage>::iterator message(score_messages_.begin());
     for ( ; message != score_messages_.end(); ) {
         if (message->timer_.timerExpired()) {
-            score_messages_.erase(message);
+            message = score_messages_.erase(message);
         }
         else {
             ++message;
@@ -37,14 +37,28 @@ void Scoreboard::addEventMessage(std::string message, int score_change, int time
     score_ += score_change;
 
     ScoreMessage new_message {message, score_change, CountdownTimer(timeout_secs) };
+    new_message.timer_.init();
     score_messages_.push_back(new_message);
 }
 
+int64_t Scoreboard::getNextExpirationMs() const
+{
+    int64_t next(-1);
+    for (const ScoreMessage &message : score_messages_) {
+        int64_t remaining(message.timer_.getMillisecondsRemaining());
+        if (remaining >= 0 && (next < 0 || remaining < next)) {
+            next = remaining;
+        }
+    }
+
+    return next;
+}
+
 void Scoreboard::draw()
 {
     checkMessageExpiration();
 
-    std::string title = "Score";
+    const char *title = "Score";
     ImGuiWindowFlags win_flags = 0;
     win_flags |= ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs;
     win_flags |= ImGuiWindowFlags_NoBackground;
@@ -55,11 +69,11 @@ void Scoreboard::draw()
 
     if (startMenu(title, win_flags)) {
         ImGui::Text("Score: %d", score_);
-        for (ScoreMessage message : score_messages_) {
+        for (const ScoreMessage &message : score_messages_) {
             ImGui::Text("%s - ", message.message_.c_str());
             ImGui::SameLine();
             ImVec4 score_color(message.score_change_ >= 0 ? kIncrColor : kDecrColor);
-            ImGui::TextColored(score_color, std::to_string(message.score_change_).c_str());
+            ImGui::TextColored(score_color, "%d", message.score_change_);
         }
         endMenu();
     }
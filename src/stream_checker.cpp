@@ -0,0 +1,156 @@
+#include <cstdio>
+#include <algorithm>
+
+#include <imgui/imgui.h>
+
+#include "viewpoint_interface/stream_checker.hpp"
+
+
+namespace viewpoint_interface
+{
+
+void StreamChecker::addStream(uint id, const std::string &name)
+{
+    std::unique_ptr<Stream> stream(new Stream());
+    stream->name = name;
+    stream->received = 0;
+    stream->dropped = 0;
+    stream->reordered = 0;
+    stream->duplicates = 0;
+    stream->restarts = 0;
+    stream->last_seq = 0;
+    stream->mean_age_ms = 0.0f;
+    stream->max_age_ms = 0.0f;
+    streams_[id] = std::move(stream);
+}
+
+void StreamChecker::frameReceived(uint id, uint64_t seq, float age_ms)
+{
+    auto found(streams_.find(id));
+    if (found == streams_.end()) {
+        return;
+    }
+    Stream &stream(*found->second);
+
+    // Only this stream's callback writes, so the loads and stores don't race
+    uint64_t last(stream.last_seq.load(std::memory_order_relaxed));
+    if (stream.received == 0) {
+        stream.last_seq = seq;
+    }
+    else if (seq > last) {
+        stream.dropped += seq - last - 1;
+        stream.last_seq = seq;
+    }
+    else if (seq == last) {
+        ++stream.duplicates;
+    }
+    else if (seq == 0) {
+        ++stream.restarts;
+        stream.last_seq = seq;
+    }
+    else {
+        // Counted as dropped when the gap it left was seen
+        ++stream.reordered;
+        if (stream.dropped > 0) {
+            --stream.dropped;
+        }
+    }
+    ++stream.received;
+
+    if (age_ms >= 0.0f) {
+        float mean(stream.mean_age_ms.load(std::memory_order_relaxed));
+        stream.mean_age_ms = (mean == 0.0f) ? age_ms : (0.95f * mean) + (0.05f * age_ms);
+        stream.max_age_ms = std::max(stream.max_age_ms.load(std::memory_order_relaxed), age_ms);
+    }
+}
+
+bool StreamChecker::hasFrames() const
+{
+    for (const auto &stream : streams_) {
+        if (stream.second->received != 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+StreamChecker::Stats StreamChecker::getStats(uint id) const
+{
+    Stats stats = {};
+    auto found(streams_.find(id));
+    if (found == streams_.end()) {
+        return stats;
+    }
+
+    const Stream &stream(*found->second);
+    stats.received = stream.received;
+    stats.dropped = stream.dropped;
+    stats.reordered = stream.reordered;
+    stats.duplicates = stream.duplicates;
+    stats.restarts = stream.restarts;
+    stats.mean_age_ms = stream.mean_age_ms;
+    stats.max_age_ms = stream.max_age_ms;
+
+    return stats;
+}
+
+std::string StreamChecker::getSummary() const
+{
+    std::string summary;
+    for (const auto &stream : streams_) {
+        Stats stats(getStats(stream.first));
+        if (stats.received == 0) {
+            continue;
+        }
+
+        char line[256];
+        snprintf(line, sizeof(line), "%s: %llu received, %llu dropped, %llu reordered, %llu duplicates, "
+                "age %.1f ms (max %.1f ms)\n", stream.second->name.c_str(), (unsigned long long)stats.received,
+                (unsigned long long)stats.dropped, (unsigned long long)stats.reordered,
+                (unsigned long long)stats.duplicates, stats.mean_age_ms, stats.max_age_ms);
+        summary += line;
+    }
+
+    return summary;
+}
+
+void StreamChecker::drawPanel()
+{
+    if (!hasFrames()) {
+        ImGui::TextWrapped("No frames with sequence markers yet, run synthetic_cameras to check streams");
+        return;
+    }
+
+    if (ImGui::BeginTable("##Streams", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Camera");
+        ImGui::TableSetupColumn("Received");
+        ImGui::TableSetupColumn("Dropped");
+        ImGui::TableSetupColumn("Reordered");
+        ImGui::TableSetupColumn("Drop %");
+        ImGui::TableSetupColumn("Age ms");
+        ImGui::TableHeadersRow();
+
+        for (const auto &stream : streams_) {
+            Stats stats(getStats(stream.first));
+            uint64_t expected(stats.received + stats.dropped);
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", stream.second->name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)stats.received);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)stats.dropped);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)stats.reordered);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", expected > 0 ? 100.0 * stats.dropped / expected : 0.0);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f / %.1f", stats.mean_age_ms, stats.max_age_ms);
+        }
+        ImGui::EndTable();
+    }
+}
+
+} // viewpoint_interface
@@ -0,0 +1,316 @@
+// Standard libraries
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+
+// ROS
+#include "ros/ros.h"
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/image_encodings.h>
+#include <std_msgs/Float32MultiArray.h>
+
+// Custom headers
+void printText(std::string text="", int newlines=1, bool flush=false);
+#include "viewpoint_interface/helpers.hpp"
+#include "viewpoint_interface/json.hpp"
+#include "viewpoint_interface/frame_marker.hpp"
+
+using json = nlohmann::json;
+
+
+namespace viewpoint_interface
+{
+
+struct SyntheticParams
+{
+    // Width and height default to each camera's size in the config
+    int width = 0;
+    int height = 0;
+    std::string encoding = "rgb8";
+    float rate = 30.0f;
+    // Each frame is published up to this far before or after its slot
+    float jitter_ms = 0.0f;
+    // Every burst_period seconds, each camera also publishes burst_frames frames at once
+    float burst_period = 0.0f;
+    int burst_frames = 0;
+    // Stop after this many seconds, 0 runs until shutdown
+    float duration = 0.0f;
+    int seed = 0;
+};
+
+/**
+ * Publishes synthetic images and pose matrices on the topics of the cameras
+ * in a camera config, for load testing the interface without real cameras.
+ *
+ * Each camera runs on its own thread, so a slow subscriber on one topic
+ * doesn't hold back the others. Images are color bars with a moving stripe,
+ * and carry their sequence number in a frame marker (see frame_marker.hpp)
+ * that the interface checks for drops and reordering.
+ */
+class SyntheticCameras
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    SyntheticCameras() : node_("~"), stopping_(false) {}
+
+    bool initialize();
+    void run();
+
+private:
+    struct Camera
+    {
+        std::string name, topic;
+        uint width, height, bytes_per_pixel;
+        std::vector<uint8_t> pattern; // Color bars, copied into each frame
+        ros::Publisher image_pub, matrix_pub;
+        uint64_t next_seq;
+        std::atomic<uint64_t> num_published;
+    };
+
+    ros::NodeHandle node_;
+    SyntheticParams params_;
+    std::vector<std::unique_ptr<Camera>> cameras_;
+    std::atomic<bool> stopping_;
+
+    bool addCamera(const json &config, uint index);
+    void publishFrames(Camera &camera, uint index);
+    void publishFrame(Camera &camera, double time);
+};
+
+bool SyntheticCameras::initialize()
+{
+    std::string config_data;
+    node_.getParam("config_data", config_data);
+    node_.getParam("width", params_.width);
+    node_.getParam("height", params_.height);
+    node_.getParam("encoding", params_.encoding);
+    node_.getParam("rate", params_.rate);
+    node_.getParam("jitter_ms", params_.jitter_ms);
+    node_.getParam("burst_period", params_.burst_period);
+    node_.getParam("burst_frames", params_.burst_frames);
+    node_.getParam("duration", params_.duration);
+    node_.getParam("seed", params_.seed);
+
+    if (config_data.empty()) {
+        printText("No camera config data.");
+        return false;
+    }
+    if (params_.rate <= 0.0f) {
+        printText("The camera rate must be above 0.");
+        return false;
+    }
+
+    json j = json::parse(config_data);
+    for (json::iterator it(j.begin()); it != j.end(); ++it) {
+        if (it.key() == "buttons") {
+            continue;
+        }
+
+        if (!addCamera(*it, cameras_.size())) {
+            return false;
+        }
+    }
+
+    return !cameras_.empty();
+}
+
+void SyntheticCameras::run()
+{
+    std::vector<std::thread> threads;
+    for (uint i(0); i < cameras_.size(); ++i) {
+        threads.emplace_back(&SyntheticCameras::publishFrames, this, std::ref(*cameras_[i]), i);
+    }
+
+    Clock::time_point start(Clock::now());
+    while (ros::ok()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        std::chrono::duration<float> elapsed(Clock::now() - start);
+        if (params_.duration > 0.0f && elapsed.count() >= params_.duration) {
+            break;
+        }
+    }
+
+    stopping_ = true;
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    std::chrono::duration<float> elapsed(Clock::now() - start);
+    for (const std::unique_ptr<Camera> &camera : cameras_) {
+        char line[256];
+        snprintf(line, sizeof(line), "%s: %llu frames, %.1f Hz", camera->topic.c_str(),
+                (unsigned long long)camera->num_published.load(), camera->num_published / elapsed.count());
+        printText(line);
+    }
+}
+
+
+// --- Private ---
+
+bool SyntheticCameras::addCamera(const json &config, uint index)
+{
+    std::unique_ptr<Camera> camera(new Camera());
+    camera->name = config["internal_name"];
+    camera->topic = config["topic"];
+    camera->width = params_.width > 0 ? params_.width : (uint)config["width"];
+    camera->height = params_.height > 0 ? params_.height : (uint)config["height"];
+    camera->next_seq = 0;
+    camera->num_published = 0;
+
+    int channels(0), depth(0);
+    try
+    {
+        channels = sensor_msgs::image_encodings::numChannels(params_.encoding);
+        depth = sensor_msgs::image_encodings::bitDepth(params_.encoding);
+    }
+    catch (std::runtime_error &e)
+    {
+        printText("Unknown image encoding " + params_.encoding + ".");
+        return false;
+    }
+    if (depth % 8 != 0) {
+        printText("Image encoding " + params_.encoding + " isn't byte aligned.");
+        return false;
+    }
+    camera->bytes_per_pixel = channels * (depth / 8);
+
+    if (camera->width < kFrameMarkerPixels || camera->height == 0) {
+        printText(camera->topic + " is too small for a frame marker, it must be at least " +
+                std::to_string(kFrameMarkerPixels) + " pixels wide.");
+        return false;
+    }
+
+    // Eight vertical bars, rotated by the camera's index so each camera looks different
+    static const uint8_t kBars[8][3] = {
+        {255, 255, 255}, {255, 255, 0}, {0, 255, 255}, {0, 255, 0},
+        {255, 0, 255}, {255, 0, 0}, {0, 0, 255}, {0, 0, 0}
+    };
+    uint row_bytes(camera->width * camera->bytes_per_pixel);
+    camera->pattern.resize(row_bytes * camera->height);
+    for (uint x(0); x < camera->width; ++x) {
+        const uint8_t *bar(kBars[((x * 8 / camera->width) + index) % 8]);
+        uint8_t *pixel(camera->pattern.data() + (x * camera->bytes_per_pixel));
+        for (uint b(0); b < camera->bytes_per_pixel; ++b) {
+            uint channel(b / (depth / 8));
+            pixel[b] = channel < 3 ? bar[channel] : 0xFF; // Opaque alpha
+        }
+    }
+    for (uint y(1); y < camera->height; ++y) {
+        std::copy(camera->pattern.begin(), camera->pattern.begin() + row_bytes,
+                camera->pattern.begin() + (y * row_bytes));
+    }
+
+    camera->image_pub = node_.advertise<sensor_msgs::Image>(camera->topic, 1);
+    camera->matrix_pub = node_.advertise<std_msgs::Float32MultiArray>(camera->topic + "_matrix", 1);
+    cameras_.push_back(std::move(camera));
+
+    return true;
+}
+
+void SyntheticCameras::publishFrames(Camera &camera, uint index)
+{
+    std::mt19937 random(params_.seed + index);
+    std::uniform_real_distribution<float> jitter(-params_.jitter_ms, params_.jitter_ms);
+
+    Clock::duration period(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / params_.rate)));
+    Clock::duration burst_period(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(params_.burst_period)));
+
+    // Cameras are spread across the period rather than all publishing at once
+    Clock::time_point start(Clock::now());
+    Clock::time_point next(start + (period * index / cameras_.size()));
+    Clock::time_point next_burst(start + burst_period);
+
+    while (!stopping_ && ros::ok()) {
+        Clock::time_point publish_time(next);
+        if (params_.jitter_ms > 0.0f) {
+            publish_time += std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<float, std::milli>(jitter(random)));
+        }
+        std::this_thread::sleep_until(publish_time);
+
+        std::chrono::duration<double> time(Clock::now() - start);
+        publishFrame(camera, time.count());
+
+        if (params_.burst_period > 0.0f && params_.burst_frames > 0 && Clock::now() >= next_burst) {
+            for (int i(0); i < params_.burst_frames; ++i) {
+                publishFrame(camera, time.count());
+            }
+            next_burst += burst_period;
+        }
+
+        // A camera that falls behind drops the missed slots instead of catching up
+        next += period;
+        if (Clock::now() > next + period) {
+            next = Clock::now();
+        }
+    }
+}
+
+void SyntheticCameras::publishFrame(Camera &camera, double time)
+{
+    sensor_msgs::ImagePtr image(new sensor_msgs::Image());
+    image->header.stamp = ros::Time::now();
+    image->header.seq = camera.next_seq;
+    image->header.frame_id = camera.name;
+    image->width = camera.width;
+    image->height = camera.height;
+    image->encoding = params_.encoding;
+    image->is_bigendian = 0;
+    image->step = camera.width * camera.bytes_per_pixel;
+    image->data = camera.pattern;
+
+    // A stripe crossing the image once every two seconds, so motion is visible
+    static const uint kStripeWidth = 8;
+    uint stripe_x((uint)(std::fmod(time * 0.5, 1.0) * (camera.width - kStripeWidth)));
+    for (uint y(0); y < camera.height; ++y) {
+        uint8_t *stripe(image->data.data() + (y * image->step) + (stripe_x * camera.bytes_per_pixel));
+        std::fill(stripe, stripe + (kStripeWidth * camera.bytes_per_pixel), 0x80);
+    }
+
+    writeFrameMarker(image->data.data(), camera.width, camera.bytes_per_pixel, camera.next_seq);
+
+    // The camera orbits the origin once every ten seconds, looking along z
+    std_msgs::Float32MultiArray matrix;
+    matrix.data.assign(12, 0.0f);
+    float angle(time * 2.0 * M_PI / 10.0);
+    matrix.data[0] = std::cos(angle);
+    matrix.data[2] = std::sin(angle);
+    matrix.data[5] = 1.0f;
+    matrix.data[8] = -std::sin(angle);
+    matrix.data[10] = std::cos(angle);
+    matrix.data[3] = std::cos(angle);
+    matrix.data[11] = std::sin(angle);
+
+    camera.image_pub.publish(image);
+    camera.matrix_pub.publish(matrix);
+    ++camera.next_seq;
+    ++camera.num_published;
+}
+
+} // viewpoint_interface
+
+
+/**
+ * Entry point to the synthetic camera publisher.
+ */
+int main(int argc, char *argv[])
+{
+    ros::init(argc, argv, "synthetic_cameras");
+
+    viewpoint_interface::SyntheticCameras cameras;
+    if (!cameras.initialize()) {
+        return 1;
+    }
+    cameras.run();
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <glad/glad.h>
+
+#include "viewpoint_interface/thumbnail_cache.hpp"
+#include "viewpoint_interface/memory_tracker.hpp"
+
+
+namespace viewpoint_interface
+{
+
+void ThumbnailCache::setRefreshRate(float rate)
+{
+    if (rate <= 0.0f) {
+        return;
+    }
+
+    std::chrono::duration<double> period(1.0 / rate);
+    refresh_period_ = std::chrono::duration_cast<Clock::duration>(period);
+}
+
+void ThumbnailCache::destroy()
+{
+    for (auto &entry : thumbnails_) {
+        glDeleteTextures(1, &entry.second.texture);
+        MemoryTracker::add(MemoryTracker::Category::Textures, -(int64_t)getBytes(entry.second));
+    }
+    thumbnails_.clear();
+}
+
+uint64_t ThumbnailCache::getTotalBytes() const
+{
+    uint64_t bytes(0);
+    for (const auto &entry : thumbnails_) {
+        bytes += getBytes(entry.second);
+    }
+
+    return bytes;
+}
+
+uint64_t ThumbnailCache::evictCold(Clock::duration min_age, uint64_t bytes, std::vector<uint> &evicted_ids)
+{
+    Clock::time_point now(Clock::now());
+    uint64_t freed(0);
+    while (freed < bytes) {
+        auto coldest(thumbnails_.end());
+        for (auto entry(thumbnails_.begin()); entry != thumbnails_.end(); ++entry) {
+            if (now - entry->second.requested >= min_age &&
+                    (coldest == thumbnails_.end() || entry->second.requested < coldest->second.requested)) {
+                coldest = entry;
+            }
+        }
+        if (coldest == thumbnails_.end()) {
+            break;
+        }
+
+        glDeleteTextures(1, &coldest->second.texture);
+        freed += getBytes(coldest->second);
+        MemoryTracker::add(MemoryTracker::Category::Textures, -(int64_t)getBytes(coldest->second));
+        evicted_ids.push_back(coldest->first);
+        thumbnails_.erase(coldest);
+        ++num_evicted_;
+    }
+
+    return freed;
+}
+
+void ThumbnailCache::update(const std::vector<uint> &display_ids, const DisplayManager &displays,
+        std::vector<DisplayImageResponse> &responses)
+{
+    num_refreshed_ = 0;
+    if (display_ids.empty()) {
+        return;
+    }
+
+    Clock::time_point now(Clock::now());
+
+    // New tiles get their thumbnail straight away, within the same budget
+    for (uint display_id : display_ids) {
+        if (thumbnails_.count(display_id) != 0 || num_refreshed_ >= kMaxRefreshesPerFrame) {
+            continue;
+        }
+
+        const DisplayInfo &info(displays.getDisplayInfoById(display_id));
+        if (info.dimensions.width == 0 || info.dimensions.height == 0 || info.dimensions.channels != 3) {
+            continue;
+        }
+
+        Thumbnail thumbnail;
+        thumbnail.source_ns = 0;
+        thumbnail.width = kWidth;
+        thumbnail.height = std::max(1u, (uint)(kWidth * ((float)info.dimensions.height / info.dimensions.width)));
+        glGenTextures(1, &thumbnail.texture);
+        glBindTexture(GL_TEXTURE_2D, thumbnail.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, thumbnail.width, thumbnail.height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+
+        MemoryTracker::add(MemoryTracker::Category::Textures, getBytes(thumbnail));
+
+        refresh(thumbnail, info);
+        thumbnail.refreshed = now;
+        thumbnail.requested = now;
+        thumbnails_.emplace(display_id, thumbnail);
+        ++num_refreshed_;
+    }
+
+    // Refresh the rest in turn, starting after the last one refreshed
+    uint num_ids(display_ids.size());
+    uint start(next_refresh_ % num_ids);
+    for (uint i(0); i < num_ids && num_refreshed_ < kMaxRefreshesPerFrame; ++i) {
+        uint ix((start + i) % num_ids);
+        auto entry(thumbnails_.find(display_ids[ix]));
+        if (entry == thumbnails_.end() || now - entry->second.refreshed < refresh_period_) {
+            continue;
+        }
+
+        const DisplayInfo &info(displays.getDisplayInfoById(entry->first));
+        if (refresh(entry->second, info)) {
+            entry->second.refreshed = now;
+            ++num_refreshed_;
+            next_refresh_ = ix + 1;
+        }
+    }
+
+    for (uint display_id : display_ids) {
+        auto entry(thumbnails_.find(display_id));
+        if (entry != thumbnails_.end()) {
+            entry->second.requested = now;
+            responses.push_back(DisplayImageResponse{entry->second.texture, display_id});
+        }
+    }
+}
+
+
+// --- Private ---
+
+bool ThumbnailCache::refresh(Thumbnail &thumbnail, const DisplayInfo &info)
+{
+    // Nothing new has arrived since the last refresh
+    int64_t source_ns(info.last_frame_ns.load());
+    if (source_ns == thumbnail.source_ns && source_ns != 0) {
+        return false;
+    }
+
+    cv::Mat image(info.dimensions.height, info.dimensions.width, CV_8UC3, (void*)info.data.data());
+    cv::resize(image, scaled_, cv::Size(thumbnail.width, thumbnail.height), 0, 0, cv::INTER_AREA);
+    thumbnail.source_ns = source_ns;
+
+    glBindTexture(GL_TEXTURE_2D, thumbnail.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, thumbnail.width, thumbnail.height, GL_RGB, GL_UNSIGNED_BYTE,
+            (GLvoid*)scaled_.data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return true;
+}
+
+} // viewpoint_interface
@@ -49,6 +49,39 @@ int64_t Timer::getDuration() const
     return 0;
 }
 
+std::chrono::nanoseconds Timer::getLength() const
+{
+    switch (type_)
+    {
+    case DurationType::NANOSECONDS:
+        {
+            return std::chrono::nanoseconds(time_);
+        }   break;
+
+    case DurationType::MICROSECONDS:
+        {
+            return std::chrono::microseconds(time_);
+        }   break;
+
+    case DurationType::MILLISECONDS:
+        {
+            return std::chrono::milliseconds(time_);
+        }   break;
+
+    case DurationType::SECONDS:
+        {
+            return std::chrono::seconds(time_);
+        }   break;
+
+    case DurationType::MINUTES:
+        {
+            return std::chrono::minutes(time_);
+        }   break;
+    }
+
+    return std::chrono::nanoseconds(0);
+}
+
 
 // --- CountdownTimer ---
 void CountdownTimer::reset()
@@ -91,6 +124,16 @@ int64_t CountdownTimer::getTimeRemaining() {
     return (int64_t)time_ - duration;
 }
 
+int64_t CountdownTimer::getMillisecondsRemaining() const
+{
+    if (!initialized_ || expired_) { return -1; }
+
+    auto elapsed = std::chrono::high_resolution_clock::now() - start_;
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(getLength() - elapsed);
+
+    return remaining.count() > 0 ? remaining.count() : 0;
+}
+
 
 // --- Stopwatch ---
 int64_t Stopwatch::getRunningTime()
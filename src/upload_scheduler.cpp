@@ -0,0 +1,178 @@
+#include <algorithm>
+
+#include <imgui/imgui.h>
+
+#include "viewpoint_interface/upload_scheduler.hpp"
+
+
+namespace viewpoint_interface
+{
+
+const uint UploadScheduler::kMaxDeferrals;
+const uint UploadScheduler::kWindowSize;
+
+const std::vector<uint>& UploadScheduler::schedule(const std::vector<DisplayImageRequest> &queue,
+        const DisplayManager &displays)
+{
+    Clock::time_point now(Clock::now());
+    stats_ = Stats();
+    stats_.num_requests = queue.size();
+    candidates_.clear();
+    uploads_.clear();
+
+    for (uint i(0); i < queue.size(); ++i) {
+        const DisplayImageRequest &request(queue[i]);
+        const DisplayInfo &info(displays.getDisplayInfoById(request.getDisplayId()));
+
+        // Displays seen for the first time are always uploaded, even before an image arrives
+        auto state(states_.find(request.getDisplayId()));
+        if (state == states_.end()) {
+            candidates_.push_back(i);
+            continue;
+        }
+
+        if (state->second.source_ns == info.last_frame_ns.load()) {
+            ++stats_.num_unchanged;
+            continue;
+        }
+
+        if (now - state->second.uploaded < getPeriod(request.getPriority())) {
+            ++stats_.num_held;
+            continue;
+        }
+
+        candidates_.push_back(i);
+    }
+
+    // Most urgent role first, then whichever has waited longest
+    std::sort(candidates_.begin(), candidates_.end(), [&](uint a, uint b) {
+        if (queue[a].getPriority() != queue[b].getPriority()) {
+            return queue[a].getPriority() < queue[b].getPriority();
+        }
+
+        auto state_a(states_.find(queue[a].getDisplayId())), state_b(states_.find(queue[b].getDisplayId()));
+        Clock::time_point uploaded_a(state_a == states_.end() ? Clock::time_point() : state_a->second.uploaded);
+        Clock::time_point uploaded_b(state_b == states_.end() ? Clock::time_point() : state_b->second.uploaded);
+        return uploaded_a < uploaded_b;
+    });
+
+    for (uint ix : candidates_) {
+        const DisplayImageRequest &request(queue[ix]);
+        const DisplayInfo &info(displays.getDisplayInfoById(request.getDisplayId()));
+        DisplayState &state(states_[request.getDisplayId()]);
+        float scale(getUploadScale(request.getPriority()));
+        uint64_t bytes(info.data.size() * scale * scale);
+
+        bool within_budget(budget_bytes_ == 0 || stats_.bytes_uploaded + bytes <= budget_bytes_);
+        if (request.getPriority() == UploadPriority::Secondary && !within_budget &&
+                state.deferrals < kMaxDeferrals) {
+            ++state.deferrals;
+            ++stats_.num_deferred;
+            continue;
+        }
+
+        state.uploaded = now;
+        state.source_ns = info.last_frame_ns.load();
+        state.deferrals = 0;
+        stats_.bytes_uploaded += bytes;
+        ++stats_.num_uploaded;
+        uploads_.push_back(ix);
+    }
+
+    total_uploaded_ += stats_.num_uploaded;
+    total_deferred_ += stats_.num_deferred;
+    if (budget_bytes_ != 0) {
+        addUtilisationSample((float)stats_.bytes_uploaded / budget_bytes_);
+    }
+
+    return uploads_;
+}
+
+void UploadScheduler::drawPanel()
+{
+    if (primary_period_ != Clock::duration::zero()) {
+        ImGui::Text("Primary displays: %.1f Hz", 1.0f / std::chrono::duration<float>(primary_period_).count());
+    }
+    else {
+        ImGui::Text("Primary displays: every new image");
+    }
+    if (secondary_period_ != Clock::duration::zero()) {
+        ImGui::Text("Secondary displays: %.1f Hz at %.0f%% size",
+                1.0f / std::chrono::duration<float>(secondary_period_).count(), 100.0f * secondary_scale_);
+    }
+    else {
+        ImGui::Text("Secondary displays: every new image at %.0f%% size", 100.0f * secondary_scale_);
+    }
+
+    ImGui::Text("Uploaded: %u of %u requested (%.2f MB)", stats_.num_uploaded, stats_.num_requests,
+            stats_.bytes_uploaded / (1024.0f * 1024.0f));
+    ImGui::Text("Unchanged: %u, held to rate: %u, deferred: %u", stats_.num_unchanged, stats_.num_held,
+            stats_.num_deferred);
+    ImGui::Text("Total: %llu uploaded, %llu deferred", (unsigned long long)total_uploaded_,
+            (unsigned long long)total_deferred_);
+
+    if (budget_bytes_ == 0) {
+        ImGui::Text("Budget: none");
+        return;
+    }
+
+    ImGui::Text("Budget: %.2f MB per frame", budget_bytes_ / (1024.0f * 1024.0f));
+    if (!utilisation_.empty()) {
+        ImGui::Text("Utilisation: %.0f%% mean, %.0f%% peak", 100.0f * utilisation_sum_ / utilisation_.size(),
+                100.0f * peak_utilisation_);
+        ImGui::PlotLines("##Budget utilisation", utilisation_.data(), utilisation_.size(),
+                utilisation_.size() < kWindowSize ? 0 : next_sample_, NULL, 0.0f,
+                std::max(1.0f, peak_utilisation_), ImVec2(0, 60));
+    }
+}
+
+
+// --- Private ---
+
+UploadScheduler::Clock::duration UploadScheduler::rateToPeriod(float rate)
+{
+    if (rate <= 0.0f) {
+        return Clock::duration::zero();
+    }
+
+    std::chrono::duration<double> period(1.0 / rate);
+    return std::chrono::duration_cast<Clock::duration>(period);
+}
+
+UploadScheduler::Clock::duration UploadScheduler::getPeriod(UploadPriority priority) const
+{
+    switch (priority)
+    {
+        case UploadPriority::Primary:
+        {
+            return primary_period_;
+        }   break;
+
+        case UploadPriority::Secondary:
+        {
+            return secondary_period_;
+        }   break;
+
+        default:
+        {
+            return Clock::duration::zero();
+        }   break;
+    }
+}
+
+void UploadScheduler::addUtilisationSample(float utilisation)
+{
+    if (utilisation_.size() < kWindowSize) {
+        utilisation_.push_back(utilisation);
+    }
+    else {
+        utilisation_sum_ -= utilisation_[next_sample_];
+        utilisation_[next_sample_] = utilisation;
+    }
+    utilisation_sum_ += utilisation;
+    next_sample_ = (next_sample_ + 1) % kWindowSize;
+
+    peak_utilisation_ = *std::max_element(utilisation_.begin(), utilisation_.end());
+}
+
+} // viewpoint_interface
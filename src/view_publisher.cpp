@@ -0,0 +1,160 @@
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/CompressedImage.h>
+#include <sensor_msgs/image_encodings.h>
+
+#include <opencv2/opencv.hpp>
+#include <imgui/imgui.h>
+
+#include "viewpoint_interface/profiler.hpp"
+#include "viewpoint_interface/view_publisher.hpp"
+
+
+namespace viewpoint_interface
+{
+
+bool ViewPublisher::start(ros::NodeHandle &node, const std::string &topic, float rate, uint width,
+        bool compressed, int src_width, int src_height)
+{
+    if (publishing_ || rate <= 0.0f || width == 0 || src_width <= 0 || src_height <= 0) {
+        return false;
+    }
+
+    uint height(std::max(1, (int)(width * ((float)src_height / src_width))));
+    if (!capture_.init(width, height)) {
+        return false;
+    }
+
+    if (compressed) {
+        pub_ = node.advertise<sensor_msgs::CompressedImage>(topic + "/compressed", 1);
+    }
+    else {
+        pub_ = node.advertise<sensor_msgs::Image>(topic, 1);
+    }
+
+    rate_ = rate;
+    compressed_ = compressed;
+    next_capture_ = FrameCapture::Clock::now();
+    stopping_ = false;
+    publishing_ = true;
+    worker_ = std::thread(&ViewPublisher::publishFrames, this);
+
+    return true;
+}
+
+void ViewPublisher::stop()
+{
+    if (worker_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        frame_ready_.notify_one();
+        worker_.join();
+    }
+
+    capture_.destroy();
+    publishing_ = false;
+}
+
+void ViewPublisher::frameRendered(int src_width, int src_height)
+{
+    if (!publishing_) {
+        return;
+    }
+
+    FrameCapture::Clock::time_point now(FrameCapture::Clock::now());
+
+    if (now >= next_capture_ && pub_.getNumSubscribers() > 0) {
+        capture_.capture(src_width, src_height, now);
+
+        std::chrono::duration<double> period(1.0 / rate_);
+        next_capture_ = now + std::chrono::duration_cast<FrameCapture::Clock::duration>(period);
+    }
+
+    capture_.collect([this](const uint8_t *data, uint width, uint height, FrameCapture::Clock::time_point stamp) {
+        std::chrono::duration<double> age(FrameCapture::Clock::now() - stamp);
+        ros::Time ros_stamp(ros::Time::now() - ros::Duration(age.count()));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (has_pending_) {
+                ++frames_replaced_;
+            }
+            pending_.assign(data, data + width * height * FrameCapture::kChannels);
+            pending_stamp_ = ros_stamp;
+            has_pending_ = true;
+        }
+        frame_ready_.notify_one();
+    });
+}
+
+void ViewPublisher::drawPanel()
+{
+    if (!publishing_) {
+        ImGui::Text("Not publishing");
+        return;
+    }
+
+    ImGui::Text("%s at %.1f Hz, %ux%u", compressed_ ? "jpeg" : "rgb8", rate_, capture_.getWidth(),
+            capture_.getHeight());
+    ImGui::Text("Subscribers: %u", pub_.getNumSubscribers());
+    ImGui::Text("Published: %llu", (unsigned long long)frames_published_);
+    ImGui::Text("Dropped: %llu capture, %llu replaced", (unsigned long long)capture_.getNumDropped(),
+            (unsigned long long)frames_replaced_);
+}
+
+
+// --- Private ---
+
+void ViewPublisher::publishFrames()
+{
+    Profiler::setThreadName("view publisher");
+    uint width(capture_.getWidth()), height(capture_.getHeight());
+    std::vector<uint8_t> frame;
+    ros::Time stamp;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            frame_ready_.wait(lock, [this]() { return stopping_ || has_pending_; });
+            if (stopping_) {
+                return;
+            }
+            frame.swap(pending_);
+            stamp = pending_stamp_;
+            has_pending_ = false;
+        }
+
+        PROFILE_ZONE("publish view");
+
+        cv::Mat rgba(height, width, CV_8UC4, frame.data());
+
+        if (compressed_) {
+            sensor_msgs::CompressedImage msg;
+            msg.header.stamp = stamp;
+            msg.format = "jpeg";
+
+            cv::Mat bgr;
+            cv::cvtColor(rgba, bgr, cv::COLOR_RGBA2BGR);
+            cv::imencode(".jpg", bgr, msg.data, std::vector<int>{ cv::IMWRITE_JPEG_QUALITY, kJpegQuality });
+            pub_.publish(msg);
+        }
+        else {
+            sensor_msgs::Image msg;
+            msg.header.stamp = stamp;
+            msg.width = width;
+            msg.height = height;
+            msg.encoding = sensor_msgs::image_encodings::RGB8;
+            msg.step = width * 3;
+            msg.data.resize(msg.step * height);
+
+            cv::Mat rgb(height, width, CV_8UC3, msg.data.data());
+            cv::cvtColor(rgba, rgb, cv::COLOR_RGBA2RGB);
+            pub_.publish(msg);
+        }
+
+        ++frames_published_;
+    }
+}
+
+} // viewpoint_interface
@@ -0,0 +1,303 @@
+#include <cmath>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <opencv2/opencv.hpp>
+#include <imgui/imgui.h>
+
+#include "viewpoint_interface/profiler.hpp"
+#include "viewpoint_interface/view_recorder.hpp"
+
+
+namespace viewpoint_interface
+{
+
+static bool endsWith(const std::string &str, const std::string &suffix)
+{
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ * Runs ffmpeg with args, without a shell, so the output path is passed as is.
+ *
+ * Returns: the write end of its stdin, or NULL if it couldn't be started
+ */
+static FILE* startFfmpeg(const std::vector<std::string> &args, pid_t &pid)
+{
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        return NULL;
+    }
+
+    std::vector<char*> argv;
+    for (const std::string &arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(NULL);
+
+    pid = fork();
+    if (pid == 0) {
+        // dup2 clears close-on-exec for stdin only
+        dup2(fds[0], STDIN_FILENO);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+
+    close(fds[0]);
+    if (pid < 0) {
+        close(fds[1]);
+        return NULL;
+    }
+
+    FILE *pipe(fdopen(fds[1], "w"));
+    if (!pipe) {
+        close(fds[1]);
+        waitpid(pid, NULL, 0);
+    }
+    return pipe;
+}
+
+bool ViewRecorder::start(const std::string &path, float scale, uint fps, int src_width, int src_height)
+{
+    if (recording_ || fps == 0 || scale <= 0.0f) {
+        return false;
+    }
+
+    // 4:2:0 chroma needs even dimensions
+    uint width(std::max(2, (int)(src_width * scale) & ~1));
+    uint height(std::max(2, (int)(src_height * scale) & ~1));
+
+    use_ffmpeg_ = !endsWith(path, ".y4m");
+    if (use_ffmpeg_) {
+        // A leading dash would make the path an option
+        std::string output((path.compare(0, 1, "-") == 0) ? "./" + path : path);
+        std::vector<std::string> args{ "ffmpeg", "-loglevel", "error", "-y", "-f", "rawvideo", "-pix_fmt", "rgba",
+                "-s", std::to_string(width) + "x" + std::to_string(height), "-r", std::to_string(fps),
+                "-i", "-", "-c:v", "libx264", "-preset", "ultrafast", "-pix_fmt", "yuv420p", output };
+
+        // SIGPIPE is ignored in main(), so if ffmpeg dies the writes fail instead
+        ffmpeg_ = startFfmpeg(args, ffmpeg_pid_);
+        if (!ffmpeg_) {
+            return false;
+        }
+    }
+    else {
+        y4m_.open(path, std::ios::binary | std::ios::trunc);
+        if (!y4m_.is_open()) {
+            return false;
+        }
+        y4m_ << "YUV4MPEG2 W" << width << " H" << height << " F" << fps << ":1 Ip A1:1 C420jpeg\n";
+    }
+
+    if (!capture_.init(width, height)) {
+        stop();
+        return false;
+    }
+
+    path_ = path;
+    fps_ = fps;
+    next_capture_ = FrameCapture::Clock::now();
+    write_failed_ = false;
+    stopping_ = false;
+    recording_ = true;
+    writer_ = std::thread(&ViewRecorder::writeFrames, this);
+
+    return true;
+}
+
+void ViewRecorder::stop()
+{
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        frame_ready_.notify_one();
+        writer_.join();
+    }
+
+    capture_.destroy();
+
+    if (ffmpeg_) {
+        // Closing its stdin ends the video, then ffmpeg finishes the file and exits
+        fclose(ffmpeg_);
+        ffmpeg_ = NULL;
+        waitpid(ffmpeg_pid_, NULL, 0);
+        ffmpeg_pid_ = -1;
+    }
+    if (y4m_.is_open()) {
+        y4m_.close();
+    }
+
+    recording_ = false;
+}
+
+void ViewRecorder::frameRendered(int src_width, int src_height)
+{
+    if (!recording_) {
+        return;
+    }
+
+    FrameCapture::Clock::time_point now(FrameCapture::Clock::now());
+
+    if (now >= next_capture_) {
+        capture_.capture(src_width, src_height, now);
+
+        std::chrono::duration<double> period(1.0 / fps_);
+        next_capture_ += std::chrono::duration_cast<FrameCapture::Clock::duration>(period);
+        if (next_capture_ < now) {
+            next_capture_ = now;
+        }
+    }
+
+    capture_.collect([this](const uint8_t *data, uint width, uint height, FrameCapture::Clock::time_point stamp) {
+        queueFrame(data, width, height, stamp);
+    });
+
+    std::chrono::duration<float, std::milli> overhead(FrameCapture::Clock::now() - now);
+    overhead_ema_ms_ = (0.95f * overhead_ema_ms_) + (0.05f * overhead.count());
+    overhead_max_ms_ = std::max(overhead_max_ms_, overhead.count());
+}
+
+std::string ViewRecorder::getSummary() const
+{
+    return "View recording " + path_ + ": " + std::to_string(frames_written_) + " frames (" +
+            std::to_string(frames_repeated_) + " repeated), " + std::to_string(capture_.getNumDropped()) +
+            " capture drops, " + std::to_string(writer_drops_) + " writer drops" +
+            (write_failed_ ? ", stopped early as writing failed" : "");
+}
+
+void ViewRecorder::drawPanel()
+{
+    if (!recording_) {
+        ImGui::Text("Not recording");
+        return;
+    }
+
+    ImGui::Text("Recording to %s", path_.c_str());
+    if (write_failed_) {
+        ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Writing failed, later frames are discarded");
+    }
+    ImGui::Text("%ux%u at %u fps", capture_.getWidth(), capture_.getHeight(), fps_);
+    ImGui::Text("Frames written: %llu (%llu repeated)", (unsigned long long)frames_written_,
+            (unsigned long long)frames_repeated_);
+    ImGui::Text("Dropped: %llu capture, %llu writer", (unsigned long long)capture_.getNumDropped(),
+            (unsigned long long)writer_drops_);
+    ImGui::Text("Render loop overhead: %.3f ms avg, %.3f ms max", overhead_ema_ms_, overhead_max_ms_);
+}
+
+
+// --- Private ---
+
+void ViewRecorder::queueFrame(const uint8_t *data, uint width, uint height, FrameCapture::Clock::time_point stamp)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (queue_.size() >= kMaxQueuedFrames) {
+        ++writer_drops_;
+        return;
+    }
+
+    Frame frame;
+    if (!free_buffers_.empty()) {
+        frame.data.swap(free_buffers_.back());
+        free_buffers_.pop_back();
+    }
+    frame.data.assign(data, data + width * height * FrameCapture::kChannels);
+    frame.stamp = stamp;
+
+    queue_.push_back(std::move(frame));
+    frame_ready_.notify_one();
+}
+
+void ViewRecorder::writeFrames()
+{
+    uint width(capture_.getWidth()), height(capture_.getHeight());
+    std::vector<uint8_t> encoded;
+    FrameCapture::Clock::time_point first_stamp;
+    int64_t last_index(-1);
+
+    Profiler::setThreadName("view recorder");
+    while (true) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            frame_ready_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return; // Only once stopping and fully drained
+            }
+            frame = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        PROFILE_ZONE("record view");
+
+        if (write_failed_) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_buffers_.push_back(std::move(frame.data));
+            continue;
+        }
+
+        if (last_index < 0) {
+            first_stamp = frame.stamp;
+        }
+        std::chrono::duration<double> offset(frame.stamp - first_stamp);
+        int64_t index(std::llround(offset.count() * fps_));
+
+        if (index > last_index) {
+            // Fill any gap with the last frame so playback keeps real time
+            for (int64_t i(last_index + 1); i < index && !encoded.empty(); ++i) {
+                writeEncoded(encoded);
+                ++frames_repeated_;
+            }
+
+            if (use_ffmpeg_) {
+                encoded.swap(frame.data);
+            }
+            else {
+                cv::Mat rgba(height, width, CV_8UC4, frame.data.data());
+                cv::Mat yuv;
+                cv::cvtColor(rgba, yuv, cv::COLOR_RGBA2YUV_I420);
+                encoded.assign(yuv.data, yuv.data + (width * height * 3 / 2));
+            }
+
+            writeEncoded(encoded);
+            last_index = index;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_buffers_.push_back(std::move(frame.data));
+    }
+}
+
+bool ViewRecorder::writeEncoded(const std::vector<uint8_t> &encoded)
+{
+    if (write_failed_) {
+        return false;
+    }
+
+    bool written;
+    if (use_ffmpeg_) {
+        // Fails with EPIPE once ffmpeg has exited
+        written = fwrite(encoded.data(), 1, encoded.size(), ffmpeg_) == encoded.size();
+    }
+    else {
+        y4m_ << "FRAME\n";
+        y4m_.write((const char *)encoded.data(), encoded.size());
+        written = y4m_.good();
+    }
+
+    if (written) {
+        ++frames_written_;
+    }
+    else {
+        write_failed_ = true;
+    }
+
+    return written;
+}
+
+} // viewpoint_interface
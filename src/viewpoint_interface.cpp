@@ -1,9 +1,12 @@
 // Standard libraries
 #include <iostream>
 #include <thread>
+#include <csignal>
 #include <sys/socket.h>
 #include <poll.h>
 #include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
 
 // ROS
 #include <sensor_msgs/Image.h>
@@ -14,6 +17,10 @@
 #include <std_msgs/Float32MultiArray.h>
 #include <sensor_msgs/Joy.h>
 #include <geometry_msgs/Point32.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <std_srvs/Trigger.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
 
 // OpenCV
 #include <opencv2/opencv.hpp>
@@ -29,6 +36,7 @@
 // Custom headers
 #include "viewpoint_interface/helpers.hpp"
 #include "viewpoint_interface/json.hpp"
+#include "viewpoint_interface/frame_marker.hpp"
 #include "viewpoint_interface/viewpoint_interface.hpp"
 #include "viewpoint_interface/shader.hpp"
 #include "viewpoint_interface/mesh.hpp"
@@ -48,17 +56,23 @@ int main(int argc, char *argv[])
 {   
     ros::init(argc, argv, "viewpoint_interface");
 
+    // Writes to a closed pipe or socket (an ffmpeg view recorder that exited, a
+    // controller that disconnected) should fail with EPIPE, not kill the node
+    std::signal(SIGPIPE, SIG_IGN);
+
     // Change working directory so we can specify resources more easily
     // NOTE: This depends on the 'cwd' param of the launch file being set to "node"
     chdir("../../../src/camera_viewpoint_interface");
 
-    App app = App();
-    app.run(argc, argv);
+    App app;
     
-    return 0;
+    return app.run(argc, argv) == 0 ? 0 : 1;
 }
 
 
+const int App::kColdTextureSeconds;
+
+
 // App init/shutdown
 bool App::parseConfigFile(std::string config_data)
 {
@@ -105,15 +119,23 @@ bool App::initialize()
     if (!parseConfigFile(config_data)) {
         return false;
     } 
+    initializeParams();
 
     if (!initializeSocket()) {
         return false;
     }
     initializeROS();
-    if (!initializeGlfw()) {
+    if (app_params_.headless) {
+        if (!initializeOffscreen()) {
+            return false;
+        }
+    }
+    else if (!initializeGlfw()) {
         return false;
     }
     initializeImGui();
+    initializeCompositor();
+    initializeViewCapture();
 
     return true;
 }
@@ -138,27 +160,173 @@ bool App::initializeSocket()
     return true;
 }
 
+void App::initializeParams()
+{
+    node_.getParam("latency_test_commands", app_params_.latency_test_commands);
+    node_.getParam("latency_csv_file", app_params_.latency_csv_file);
+    node_.getParam("record_inputs_file", app_params_.record_inputs_file);
+    node_.getParam("replay_inputs_file", app_params_.replay_inputs_file);
+    node_.getParam("replay_max_speed", app_params_.replay_max_speed);
+    node_.getParam("replay_exit_on_end", app_params_.replay_exit_on_end);
+    node_.getParam("bag_file", app_params_.bag_file);
+    node_.getParam("bag_rate", app_params_.bag_rate);
+    node_.getParam("bench_max_latency_ms", app_params_.bench_max_latency_ms);
+    node_.getParam("bench_max_frame_ms", app_params_.bench_max_frame_ms);
+    node_.getParam("bench_max_rss_mb", app_params_.bench_max_rss_mb);
+    node_.getParam("frame_pacing", app_params_.frame_pacing);
+    node_.getParam("headless", app_params_.headless);
+    node_.getParam("headless_width", app_params_.headless_width);
+    node_.getParam("headless_height", app_params_.headless_height);
+    node_.getParam("headless_frames", app_params_.headless_frames);
+    node_.getParam("record_view_file", app_params_.record_view_file);
+    node_.getParam("record_view_scale", app_params_.record_view_scale);
+    node_.getParam("record_view_fps", app_params_.record_view_fps);
+    node_.getParam("publish_view_rate", app_params_.publish_view_rate);
+    node_.getParam("publish_view_width", app_params_.publish_view_width);
+    node_.getParam("publish_view_compressed", app_params_.publish_view_compressed);
+    node_.getParam("batched_compositor", app_params_.batched_compositor);
+    node_.getParam("max_displays_per_page", app_params_.max_displays_per_page);
+    node_.getParam("layout_config_file", app_params_.layout_config_file);
+    node_.getParam("thumbnail_rate", app_params_.thumbnail_rate);
+    node_.getParam("secondary_upload_rate", app_params_.secondary_upload_rate);
+    node_.getParam("upload_budget_mb", app_params_.upload_budget_mb);
+    node_.getParam("quality_governor", app_params_.quality_governor);
+    node_.getParam("governor_target_ms", app_params_.governor_target_ms);
+    node_.getParam("profiler", app_params_.profiler);
+    node_.getParam("trace_seconds", app_params_.trace_seconds);
+    node_.getParam("trace_dir", app_params_.trace_dir);
+    node_.getParam("texture_memory_mb", app_params_.texture_memory_mb);
+    node_.getParam("max_cached_layouts", app_params_.max_cached_layouts);
+    node_.getParam("diagnostics_rate", app_params_.diagnostics_rate);
+
+    FramePacer::Mode pacing_mode;
+    if (!FramePacer::stringToMode(app_params_.frame_pacing, pacing_mode)) {
+        printText("Unknown frame pacing mode " + app_params_.frame_pacing + ", using vsync.");
+        pacing_mode = FramePacer::Mode::VSync;
+    }
+    // There are no window events to wait on headless
+    frame_pacer_.setOnDemandAvailable(!app_params_.headless);
+    if (pacing_mode == FramePacer::Mode::OnDemand && !frame_pacer_.isOnDemandAvailable()) {
+        printText("On-demand pacing isn't available headless, using fixed.");
+        pacing_mode = FramePacer::Mode::Fixed;
+    }
+    frame_pacer_.setMode(pacing_mode);
+    frame_pacer_.setFixedRate(app_params_.loop_rate);
+    layouts_.setMaxDisplaysPerPage(std::max(0, app_params_.max_displays_per_page));
+    layouts_.setMaxCachedLayouts(std::max(0, app_params_.max_cached_layouts));
+    thumbnails_.setRefreshRate(app_params_.thumbnail_rate);
+    upload_scheduler_.setSecondaryRate(app_params_.secondary_upload_rate);
+    upload_scheduler_.setBudget((uint64_t)(std::max(0.0f, app_params_.upload_budget_mb) * 1024 * 1024));
+    governor_.setEnabled(app_params_.quality_governor);
+    Profiler::setEnabled(app_params_.profiler);
+    getProfiler().setCaptureParams(app_params_.trace_seconds, app_params_.trace_dir);
+
+    ReplayBenchmark::Thresholds thresholds;
+    thresholds.max_latency_ms = app_params_.bench_max_latency_ms;
+    thresholds.max_frame_ms = app_params_.bench_max_frame_ms;
+    thresholds.max_rss_mb = app_params_.bench_max_rss_mb;
+    bag_bench_.setThresholds(thresholds);
+
+    if (!app_params_.record_inputs_file.empty()) {
+        if (!input_recorder_.open(app_params_.record_inputs_file)) {
+            printText("Could not open input log " + app_params_.record_inputs_file + " for recording.");
+        }
+    }
+
+    if (isReplaying()) {
+        std::string error;
+        if (loadInputLog(app_params_.replay_inputs_file, replay_events_, error)) {
+            printText("Replaying " + std::to_string(replay_events_.size()) + " inputs from " + 
+                    app_params_.replay_inputs_file + "...");
+            replay_start_ = std::chrono::steady_clock::now();
+        }
+        else {
+            printText("Could not load input log " + app_params_.replay_inputs_file + ": it " + error + ".");
+            app_params_.replay_inputs_file.clear();
+        }
+    }
+
+    if (!app_params_.layout_config_file.empty()) {
+        if (layout_config_.start(app_params_.layout_config_file, [this]() { requestRedraw(); })) {
+            applyLayoutConfigUpdates();
+        }
+        else {
+            printText("Could not watch layout config " + app_params_.layout_config_file + ".");
+        }
+    }
+
+    layouts_.addControlPanelSection("Layout Config", [this]() {
+        layout_config_.drawPanel();
+    });
+    layouts_.addControlPanelSection("Input Latency", [this]() {
+        latency_.drawPanel(app_params_.latency_csv_file);
+    });
+    layouts_.addControlPanelSection("Frame Pacing", [this]() {
+        frame_pacer_.drawPanel();
+    });
+    layouts_.addControlPanelSection("Profiler", [this]() {
+        getProfiler().drawPanel();
+        ImGui::Separator();
+        gpu_timer_.drawPanel();
+    });
+    layouts_.addControlPanelSection("Quality Governor", [this]() {
+        governor_.drawPanel();
+    });
+    layouts_.addControlPanelSection("Image Uploads", [this]() {
+        upload_scheduler_.drawPanel();
+    });
+    layouts_.addControlPanelSection("Stream Check", [this]() {
+        stream_checker_.drawPanel();
+    });
+    layouts_.addControlPanelSection("Frame Memory", [this]() {
+        const FrameArena &arena(getFrameArena());
+        ImGui::Text("Heap allocations last frame: %llu", (unsigned long long)last_frame_allocations_);
+        ImGui::Text("Arena: %zu / %zu bytes (peak %zu)", arena.getBytesUsed(), arena.getCapacity(),
+                arena.getPeakBytes());
+        ImGui::Text("Arena overflows: %llu", (unsigned long long)arena.getNumOverflows());
+    });
+    layouts_.addControlPanelSection("Memory", [this]() {
+        MemoryTracker::drawPanel();
+        if (app_params_.texture_memory_mb > 0.0f) {
+            ImGui::Text("Texture cap: %.1f MB", app_params_.texture_memory_mb);
+        }
+        ImGui::Text("Evicted textures: %llu displays, %llu thumbnails", (unsigned long long)num_evicted_textures_,
+                (unsigned long long)thumbnails_.getNumEvicted());
+        ImGui::Text("Cached layouts: %u (%llu evicted)", layouts_.getNumCachedLayouts(),
+                (unsigned long long)layouts_.getNumEvictedLayouts());
+    });
+}
+
 void App::initializeROS()
 {
     spinner_.start();
     
-    // Init display image callbacks
     for (int i = 0; i < layouts_.getNumTotalDisplays(); ++i) {
-        ros::Subscriber disp_sub(node_.subscribe<sensor_msgs::Image>(layouts_.getDisplayInfo(i).topic, 1, 
-                boost::bind(&App::cameraImageCallback, this, _1, layouts_.getDisplayInfo(i).id)));
-        disp_subs_.push_back(disp_sub);
+        stream_checker_.addStream(layouts_.getDisplayInfo(i).id, layouts_.getDisplayInfo(i).external);
+        bag_bench_.addCamera(layouts_.getDisplayInfo(i).id, layouts_.getDisplayInfo(i).external);
+        pipeline_stats_.addCamera(layouts_.getDisplayInfo(i).id, layouts_.getDisplayInfo(i).external);
     }
 
-    // Init camera pose matrix callbacks
-    for (int i = 0; i < layouts_.getNumTotalDisplays(); ++i) {
-        ros::Subscriber cam_matrix_sub(node_.subscribe<std_msgs::Float32MultiArray>(layouts_.getDisplayInfo(i).topic + "_matrix", 1,
-                boost::bind(&App::cameraMatrixCallback, this, _1, layouts_.getDisplayInfo(i).id)));
-        cam_matrix_subs_.push_back(cam_matrix_sub);
-    }
+    // A bag being played feeds these callbacks itself
+    if (!isPlayingBag()) {
+        // Init display image callbacks
+        for (int i = 0; i < layouts_.getNumTotalDisplays(); ++i) {
+            ros::Subscriber disp_sub(node_.subscribe<sensor_msgs::Image>(layouts_.getDisplayInfo(i).topic, 1, 
+                    boost::bind(&App::cameraImageCallback, this, _1, layouts_.getDisplayInfo(i).id)));
+            disp_subs_.push_back(disp_sub);
+        }
 
-    grasping_sub_ = node_.subscribe<std_msgs::Bool>("/robot_state/grasping", 10, boost::bind(&App::graspingCallback, this, _1));
-    clutching_sub_ = node_.subscribe<std_msgs::Bool>("/robot_state/clutching", 10, boost::bind(&App::clutchingCallback, this, _1));
-    collision_sub_ = node_.subscribe<std_msgs::String>("/robot_state/collisions", 10, boost::bind(&App::collisionCallback, this, _1));
+        // Init camera pose matrix callbacks
+        for (int i = 0; i < layouts_.getNumTotalDisplays(); ++i) {
+            ros::Subscriber cam_matrix_sub(node_.subscribe<std_msgs::Float32MultiArray>(layouts_.getDisplayInfo(i).topic + "_matrix", 1,
+                    boost::bind(&App::cameraMatrixCallback, this, _1, layouts_.getDisplayInfo(i).id)));
+            cam_matrix_subs_.push_back(cam_matrix_sub);
+        }
+
+        grasping_sub_ = node_.subscribe<std_msgs::Bool>("/robot_state/grasping", 10, boost::bind(&App::graspingCallback, this, _1));
+        clutching_sub_ = node_.subscribe<std_msgs::Bool>("/robot_state/clutching", 10, boost::bind(&App::clutchingCallback, this, _1));
+        collision_sub_ = node_.subscribe<std_msgs::String>("/robot_state/collisions", 10, boost::bind(&App::collisionCallback, this, _1));
+    }
     active_display_sub_ = node_.subscribe<std_msgs::UInt8>("/viewpoint_interface/active_display", 10, 
             boost::bind(&App::activeDisplayCallback, this, _1));
     manual_command_sub_ = node_.subscribe<std_msgs::String>("/viewpoint_interface/manual_command", 10,
@@ -170,6 +338,8 @@ void App::initializeROS()
     mouse_pos_normalized_ = node_.advertise<geometry_msgs::Point32>("/viewpoint_interface/mouse_pos_normalized", 10);
     mouse_buttons_ = node_.advertise<sensor_msgs::Joy>("/viewpoint_interface/mouse_buttons", 10);
     mouse_scroll_ = node_.advertise<geometry_msgs::Point32>("/viewpoint_interface/mouse_scroll", 10);
+    diagnostics_pub_ = node_.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 10);
+    capture_trace_srv_ = node_.advertiseService("capture_trace", &App::captureTraceService, this);
 }
 
 bool App::initializeGlfw()
@@ -213,6 +383,8 @@ bool App::initializeGlfw()
         return false;
     }
 
+    frame_pacer_.setRefreshRate(glfwGetVideoMode(monitor_)->refreshRate);
+
     // Tells stb_image.h to flip loaded textures on y-axis
     stbi_set_flip_vertically_on_load(true);
 
@@ -233,9 +405,37 @@ bool App::initializeGlfw()
     return true;
 }
 
+bool App::initializeOffscreen()
+{
+    if (app_params_.headless_width <= 0 || app_params_.headless_height <= 0) {
+        printText("Invalid headless resolution.");
+        return false;
+    }
+
+    if (!offscreen_.create(app_params_.headless_width, app_params_.headless_height)) {
+        printText(offscreen_.getError());
+        return false;
+    }
+
+    printText("Rendering headless at " + std::to_string(app_params_.headless_width) + "x" +
+            std::to_string(app_params_.headless_height) + " (" + (const char *)glGetString(GL_RENDERER) + ").");
+
+    // Tells stb_image.h to flip loaded textures on y-axis
+    stbi_set_flip_vertically_on_load(true);
+
+    int frame_width, frame_height, x, y;
+    getFramebufferSize(&frame_width, &frame_height);
+    transformFramebufferDims(&x, &y, &frame_width, &frame_height);
+    glViewport(0, 0, frame_width, frame_height);
+    glEnable(GL_DEPTH_TEST);
+
+    return true;
+}
+
 void App::initializeImGui()
 {
     IMGUI_CHECKVERSION();
+    MemoryTracker::installImGuiAllocator();
     ImGui::CreateContext();
     io_ = ImGui::GetIO(); (void)io_;
     ImGui::StyleColorsDark();
@@ -248,37 +448,141 @@ void App::initializeImGui()
         printText("Could not load font.");
     }
 
+    // The OpenGL backend uploads the font atlas as an RGBA texture
+    unsigned char *font_pixels;
+    int font_width, font_height;
+    io_.Fonts->GetTexDataAsRGBA32(&font_pixels, &font_width, &font_height);
+    MemoryTracker::add(MemoryTracker::Category::Textures, (int64_t)font_width * font_height * 4);
+
     ImGui::GetIO() = io_;
 
-    // Setup Platform/Renderer backends
-    ImGui_ImplGlfw_InitForOpenGL(window_, true);
+    // Setup Platform/Renderer backends. Headless runs have no platform
+    // backend, so display size and timing are set by hand in newImGuiFrame()
+    if (!app_params_.headless) {
+        ImGui_ImplGlfw_InitForOpenGL(window_, true);
+    }
     ImGui_ImplOpenGL3_Init("#version 330");
 }
 
+void App::initializeViewCapture()
+{
+    int frame_width, frame_height;
+    getFramebufferSize(&frame_width, &frame_height);
+
+    if (!app_params_.record_view_file.empty()) {
+        if (view_recorder_.start(app_params_.record_view_file, app_params_.record_view_scale,
+                app_params_.record_view_fps, frame_width, frame_height)) {
+            layouts_.addControlPanelSection("View Recorder", [this]() {
+                view_recorder_.drawPanel();
+            });
+        }
+        else {
+            printText("Could not start recording the view to " + app_params_.record_view_file + ".");
+        }
+    }
+
+    if (app_params_.publish_view_rate > 0.0f) {
+        if (view_publisher_.start(node_, "/viewpoint_interface/operator_view", app_params_.publish_view_rate,
+                app_params_.publish_view_width, app_params_.publish_view_compressed, frame_width, frame_height)) {
+            layouts_.addControlPanelSection("View Publisher", [this]() {
+                view_publisher_.drawPanel();
+            });
+        }
+        else {
+            printText("Could not start publishing the operator view.");
+        }
+    }
+}
+
+void App::initializeCompositor()
+{
+    if (!app_params_.batched_compositor) {
+        return;
+    }
+
+    if (!compositor_.init(layouts_.getDisplayManager())) {
+        printText("Could not initialize the display compositor, drawing displays individually.");
+        return;
+    }
+
+    layouts_.setBatchedDisplays(true);
+}
+
 void App::shutdownApp()
 {
+    if (!app_params_.latency_csv_file.empty()) {
+        if (!latency_.exportCsv(app_params_.latency_csv_file)) {
+            printText("Could not write latency CSV to " + app_params_.latency_csv_file);
+        }
+    }
+
     // Triggers when we're shutting down due to window being closed
     if (ros::ok()) {
         ros::shutdown();
     }
     spinner_.stop();
 
+    if (app_params_.headless) {
+        FramePacer::Stats stats(frame_pacer_.getStats());
+        printText("Headless frames: " + std::to_string(headless_frame_count_) + ", mean " +
+                std::to_string(stats.mean_ms) + " ms, std dev " + std::to_string(stats.std_dev_ms) +
+                " ms, max " + std::to_string(stats.max_ms) + " ms, missed " +
+                std::to_string(stats.missed_total), 1, true);
+    }
+
+    if (stream_checker_.hasFrames()) {
+        printText(stream_checker_.getSummary(), 0, true);
+    }
+
+    if (isPlayingBag()) {
+        printText(bag_bench_.getReport(), 1, true);
+    }
+
+    if (view_recorder_.isRecording()) {
+        view_recorder_.stop();
+        printText(view_recorder_.getSummary(), 1, true);
+    }
+    view_publisher_.stop();
+    layout_config_.stop();
+    compositor_.destroy();
+    thumbnails_.destroy();
+    gpu_timer_.destroy();
+    for (auto &texture : display_textures_) {
+        glDeleteTextures(1, &texture.second.id);
+    }
+    display_textures_.clear();
+
     ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
+    if (!app_params_.headless) {
+        ImGui_ImplGlfw_Shutdown();
+    }
     ImGui::DestroyContext();
-    glfwDestroyWindow(window_);
-    glfwTerminate();
+    input_recorder_.close();
+    if (app_params_.headless) {
+        offscreen_.destroy();
+    }
+    else {
+        glfwDestroyWindow(window_);
+        glfwTerminate();
+    }
 }
 
 
 // Input handling
 void App::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
+    // GLFW doesn't timestamp key events, so this is taken when the event is
+    // dispatched from glfwPollEvents()
+    LatencyTracker::TimePoint stamp(LatencyTracker::now());
+
+    // Layout configs can't bind these keys, see isReservedKey() in layout_config.cpp
     if (action == GLFW_PRESS) {
+        bool applied(true);
         switch (key) {
             case GLFW_KEY_ESCAPE:
             {
                 glfwSetWindowShouldClose(window, true);
+                applied = false;
             }   break;
 
             case GLFW_KEY_C:
@@ -291,11 +595,23 @@ void App::keyCallback(GLFWwindow* window, int key, int scancode, int action, int
                 layouts_.toggleButtonPanel();
             }   break;
 
+            case GLFW_KEY_T:
+            {
+                // Doesn't change the picture, so there's no frame to time it against
+                requestTraceCapture();
+                applied = false;
+            }   break;
+
             default:
             {
-                layouts_.handleKeyInput(key, action, mods);
+                applied = layouts_.handleKeyInput(key, action, mods);
             }   break;
         }
+
+        // Keys that do nothing would otherwise be matched to an unrelated frame
+        if (applied) {
+            latency_.commandApplied("key_" + std::to_string(key), stamp, LatencyTracker::CommandSource::Keyboard);
+        }
     }
     else
     {
@@ -375,19 +691,25 @@ const App::AppCommand App::translateStringInputToCommand(std::string input) cons
     else if (input == "toggle_buttons_panel") {
         return AppCommand::TOGGLE_BUTTONS_PANEL;
     }
+    else if (input == "capture_trace") {
+        return AppCommand::CAPTURE_TRACE;
+    }
 
     return AppCommand::NONE;
 }
 
-void App::handleCommandString(std::string in_string)
+void App::handleCommandString(std::string in_string, LatencyTracker::TimePoint stamp,
+        LatencyTracker::CommandSource source)
 {
     AppCommand command(translateStringInputToCommand(in_string));
+    bool applied(true);
 
     switch (command)
     {
         case AppCommand::CLOSE_WINDOW:
         {
-            glfwSetWindowShouldClose(window_, true);                
+            requestClose();
+            applied = false;
         }   break;
 
         case AppCommand::TOGGLE_CONTROL_PANEL:
@@ -399,15 +721,26 @@ void App::handleCommandString(std::string in_string)
         {
             layouts_.toggleButtonPanel();
         }   break;
+
+        case AppCommand::CAPTURE_TRACE:
+        {
+            requestTraceCapture();
+            applied = false;
+        }   break;
     
         default:
         {
-            layouts_.handleStringInput(in_string);
+            applied = layouts_.handleStringInput(in_string);
         }   break;
     }
+
+    // Commands that do nothing would otherwise be matched to an unrelated frame
+    if (applied) {
+        latency_.commandApplied(in_string, stamp, source);
+    }
 }
 
-void App::parseControllerInput(std::string data)
+void App::parseControllerInput(std::string data, LatencyTracker::TimePoint stamp)
 {
     json j = json::parse(data);
 
@@ -416,7 +749,7 @@ void App::parseControllerInput(std::string data)
     }
 
     for (json::iterator it(j.begin()); it != j.end(); ++it) {
-        handleCommandString(it.key());
+        handleCommandString(it.key(), stamp, LatencyTracker::CommandSource::Controller);
     }
 }
 
@@ -426,20 +759,290 @@ void App::handleControllerInput()
     poll_fds.fd = socket_.socket;
     poll_fds.events = POLLIN; // Wait until there's data to read
 
-    while (ros::ok() && !glfwWindowShouldClose(window_))
+    Profiler::setThreadName("controller");
+    while (ros::ok() && !shouldClose())
     {
         if (poll(&poll_fds, 1, 1000.0/(float)app_params_.loop_rate) > 0) {
+            PROFILE_ZONE("controller packet");
+            LatencyTracker::TimePoint stamp(LatencyTracker::now());
             std::string input_data = getSocketData(socket_);
-            parseControllerInput(input_data);
+            pipeline_stats_.controllerPacket();
+            handleInputEvent(InputEventType::ControllerPacket, input_data, stamp);
         }
     }
 
     shutdown(socket_.socket, SHUT_RDWR);
 }
 
+void App::runLatencyTest()
+{
+    int test_socket(socket(AF_INET, SOCK_DGRAM, 0));
+    if (test_socket < 0) {
+        printText("Could not open socket for latency test.");
+        return;
+    }
+
+    sockaddr_in target;
+    memset(&target, 0, sizeof(target));
+    target.sin_family = AF_INET;
+    target.sin_addr.s_addr = inet_addr("127.0.0.1");
+    target.sin_port = htons(socket_.PORT);
+
+    // Cycling the active frame changes the layout on every command without
+    // affecting which displays are shown
+    const std::string packet("{\"active_next\": true}");
+    std::chrono::milliseconds period(app_params_.latency_test_period_ms);
+
+    printText("Running latency test with " + std::to_string(app_params_.latency_test_commands) + " commands...");
+    for (int i(0); i < app_params_.latency_test_commands; ++i) {
+        if (!ros::ok() || shouldClose()) {
+            close(test_socket);
+            return;
+        }
+
+        sendto(test_socket, packet.c_str(), packet.size(), 0, (const sockaddr *)&target, sizeof(target));
+        std::this_thread::sleep_for(period);
+    }
+    close(test_socket);
+
+    // Give the last commands time to reach the screen
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    LatencyTracker::Summary summary(latency_.getSummary());
+    printText("Latency test results (" + std::to_string(summary.count) + " commands):");
+    printText("\tmean: " + std::to_string(summary.mean_ms) + " ms");
+    printText("\tp50:  " + std::to_string(summary.p50_ms) + " ms");
+    printText("\tp95:  " + std::to_string(summary.p95_ms) + " ms");
+    printText("\tp99:  " + std::to_string(summary.p99_ms) + " ms");
+    printText("\tmax:  " + std::to_string(summary.max_ms) + " ms", 1, true);
+}
+
 void App::handleManualCommand(const std_msgs::StringConstPtr& msg)
 {
-    handleCommandString(msg->data);
+    handleInputEvent(InputEventType::ManualCommand, msg->data, LatencyTracker::now());
+}
+
+void App::handleInputEvent(InputEventType type, const std::string &payload, LatencyTracker::TimePoint stamp)
+{
+    // Keep replays deterministic by ignoring anything that isn't in the log, except
+    // for shutting down and capturing traces
+    if (isReplaying() && !isControlCommand(type, payload)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pending_inputs_mutex_);
+        pending_inputs_.push_back(PendingInput{type, payload, stamp});
+    }
+    requestRedraw();
+}
+
+bool App::isControlCommand(InputEventType type, const std::string &payload) const
+{
+    if (type != InputEventType::ManualCommand) {
+        return false;
+    }
+
+    AppCommand command(translateStringInputToCommand(payload));
+    return command == AppCommand::CLOSE_WINDOW || command == AppCommand::CAPTURE_TRACE;
+}
+
+void App::applyPendingInputs()
+{
+    {
+        std::lock_guard<std::mutex> lock(pending_inputs_mutex_);
+        applied_inputs_.swap(pending_inputs_);
+    }
+
+    // Recorded as they are applied, so a replay applies them before the same frame
+    for (const PendingInput &input : applied_inputs_) {
+        input_recorder_.record(input.type, input_frame_, input.payload);
+        dispatchInputEvent(input.type, input.payload, input.stamp);
+    }
+    applied_inputs_.clear();
+}
+
+void App::dispatchInputEvent(InputEventType type, const std::string &payload, LatencyTracker::TimePoint stamp)
+{
+    switch (type)
+    {
+        case InputEventType::ControllerPacket:
+        {
+            parseControllerInput(payload, stamp);
+        }   break;
+
+        case InputEventType::ManualCommand:
+        {
+            handleCommandString(payload, stamp, LatencyTracker::CommandSource::Manual);
+        }   break;
+
+        case InputEventType::ActiveDisplay:
+        {
+            layouts_.setActiveFrame((uint8_t)payload.at(0));
+        }   break;
+
+        case InputEventType::Grasping:
+        {
+            layouts_.setGrabbingState(payload.at(0) != 0);
+        }   break;
+
+        case InputEventType::Clutching:
+        {
+            layouts_.setClutchingState(payload.at(0) != 0);
+        }   break;
+
+        case InputEventType::Collision:
+        {
+            layouts_.handleCollisionMessage(payload);
+        }   break;
+    }
+
+    requestRedraw();
+}
+
+void App::applyReplayedInputs()
+{
+    if (next_replay_event_ >= replay_events_.size()) {
+        return;
+    }
+
+    // At max speed the frames between inputs are skipped, by moving the rest of
+    // the log up to the current frame
+    int64_t frame(input_frame_);
+    if (app_params_.replay_max_speed) {
+        int64_t next_frame((int64_t)replay_events_[next_replay_event_].frame - replay_frame_shift_);
+        replay_frame_shift_ += std::max(next_frame - frame, (int64_t)0);
+    }
+
+    while (next_replay_event_ < replay_events_.size() &&
+            (int64_t)replay_events_[next_replay_event_].frame - replay_frame_shift_ <= frame) {
+        const InputEvent &event(replay_events_[next_replay_event_++]);
+        dispatchInputEvent(event.type, event.payload, LatencyTracker::now());
+    }
+
+    if (next_replay_event_ < replay_events_.size()) {
+        // On-demand pacing would otherwise stop drawing the frames the log waits for
+        requestRedraw();
+        return;
+    }
+
+    std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - replay_start_);
+    printText("Replay finished in " + std::to_string(elapsed.count()) + " s.", 1, true);
+
+    if (app_params_.replay_exit_on_end) {
+        requestClose();
+    }
+}
+
+
+void App::playBag()
+{
+    Profiler::setThreadName("bag player");
+
+    rosbag::Bag bag;
+    try
+    {
+        bag.open(app_params_.bag_file, rosbag::bagmode::Read);
+    }
+    catch (rosbag::BagException &e)
+    {
+        printText("Could not open bag " + app_params_.bag_file + ": " + e.what(), 1, true);
+        requestClose();
+        requestRedraw();
+        return;
+    }
+
+    std::map<std::string, uint> image_topics, matrix_topics;
+    for (int i = 0; i < layouts_.getNumTotalDisplays(); ++i) {
+        const DisplayInfo &info(layouts_.getDisplayInfo(i));
+        image_topics[info.topic] = info.id;
+        matrix_topics[info.topic + "_matrix"] = info.id;
+    }
+
+    rosbag::View view(bag);
+    printText("Playing " + std::to_string(view.size()) + " messages from " + app_params_.bag_file + 
+            (app_params_.bag_rate > 0.0f ? " at " + std::to_string(app_params_.bag_rate) + "x..." : 
+            " as fast as possible..."), 1, true);
+
+    bag_bench_.start();
+    std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+    ros::Time first_time, last_time;
+    uint64_t num_messages(0);
+    for (const rosbag::MessageInstance &message : view) {
+        if (num_messages == 0) {
+            first_time = message.getTime();
+        }
+        last_time = message.getTime();
+
+        if (app_params_.bag_rate > 0.0f) {
+            std::chrono::steady_clock::time_point due(start + std::chrono::duration_cast<
+                    std::chrono::steady_clock::duration>(std::chrono::duration<double>(
+                    (last_time - first_time).toSec() / app_params_.bag_rate)));
+            while (std::chrono::steady_clock::now() < due && ros::ok() && !shouldClose()) {
+                std::this_thread::sleep_until(std::min(due, std::chrono::steady_clock::now() + 
+                        std::chrono::milliseconds(100)));
+            }
+        }
+        if (!ros::ok() || shouldClose()) {
+            break;
+        }
+        ++num_messages;
+
+        const std::string &topic(message.getTopic());
+        std::map<std::string, uint>::const_iterator image(image_topics.find(topic));
+        if (image != image_topics.end()) {
+            sensor_msgs::ImageConstPtr msg(message.instantiate<sensor_msgs::Image>());
+            if (!msg) {
+                continue;
+            }
+
+            if (app_params_.bag_rate <= 0.0f) {
+                bag_bench_.waitForCamera(image->second);
+            }
+            // Counted first, so the render loop can't upload the image before its ingest time is set
+            bag_bench_.imageIngested(image->second, ReplayBenchmark::Clock::now());
+            // Not through cameraImageCallback, which would rename this thread
+            ingestCameraImage(msg, image->second);
+            continue;
+        }
+
+        std::map<std::string, uint>::const_iterator matrix(matrix_topics.find(topic));
+        if (matrix != matrix_topics.end()) {
+            std_msgs::Float32MultiArrayConstPtr msg(message.instantiate<std_msgs::Float32MultiArray>());
+            if (msg) {
+                cameraMatrixCallback(msg, matrix->second);
+            }
+        }
+        else if (topic == "/robot_state/grasping" || topic == "/robot_state/clutching") {
+            std_msgs::BoolConstPtr msg(message.instantiate<std_msgs::Bool>());
+            if (msg && topic == "/robot_state/grasping") {
+                graspingCallback(msg);
+            }
+            else if (msg) {
+                clutchingCallback(msg);
+            }
+        }
+        else if (topic == "/robot_state/collisions") {
+            std_msgs::StringConstPtr msg(message.instantiate<std_msgs::String>());
+            if (msg) {
+                collisionCallback(msg);
+            }
+        }
+    }
+    bag.close();
+
+    // Gives the last image of each camera its chance to reach the screen
+    for (int i = 0; i < layouts_.getNumTotalDisplays(); ++i) {
+        bag_bench_.waitForCamera(layouts_.getDisplayInfo(i).id);
+    }
+    bag_bench_.finish(num_messages, (last_time - first_time).toSec());
+
+    std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - start);
+    printText("Bag " + std::string(num_messages == view.size() ? "finished" : "stopped") + " after " + 
+            std::to_string(elapsed.count()) + " s.", 1, true);
+
+    requestClose();
+    requestRedraw();
 }
 
 
@@ -450,6 +1053,75 @@ void glfwErrorCallback(int code, const char* description)
     printText(description);
 }
 
+bool App::shouldClose() const
+{
+    if (app_params_.headless) {
+        return close_requested_;
+    }
+
+    return glfwWindowShouldClose(window_);
+}
+
+void App::requestClose()
+{
+    if (app_params_.headless) {
+        close_requested_ = true;
+        return;
+    }
+
+    glfwSetWindowShouldClose(window_, true);
+}
+
+void App::getFramebufferSize(int *width, int *height) const
+{
+    if (app_params_.headless) {
+        *width = offscreen_.getWidth();
+        *height = offscreen_.getHeight();
+        return;
+    }
+
+    glfwGetFramebufferSize(window_, width, height);
+}
+
+void App::newImGuiFrame()
+{
+    ImGui_ImplOpenGL3_NewFrame();
+
+    if (app_params_.headless) {
+        std::chrono::steady_clock::time_point now(std::chrono::steady_clock::now());
+        std::chrono::duration<float> delta(0.0f);
+        if (last_headless_frame_.time_since_epoch().count() != 0) {
+            delta = now - last_headless_frame_;
+        }
+        last_headless_frame_ = now;
+
+        ImGuiIO &io(ImGui::GetIO());
+        io.DisplaySize = ImVec2((float)offscreen_.getWidth(), (float)offscreen_.getHeight());
+        io.DisplayFramebufferScale = ImVec2(1.0f, 1.0f);
+        io.DeltaTime = delta.count() > 0.0f ? delta.count() : 1.0f / 60.0f;
+    }
+    else {
+        ImGui_ImplGlfw_NewFrame();
+    }
+
+    ImGui::NewFrame();
+}
+
+void App::presentFrame()
+{
+    if (app_params_.headless) {
+        // Nothing to swap, but waiting for the GPU keeps frame times honest
+        glFinish();
+        ++headless_frame_count_;
+        if (app_params_.headless_frames > 0 && headless_frame_count_ >= (uint64_t)app_params_.headless_frames) {
+            requestClose();
+        }
+        return;
+    }
+
+    glfwSwapBuffers(window_);
+}
+
 void App::transformFramebufferDims(int *x, int *y, int *width, int *height)
 {
     *x = FRAME_X;
@@ -489,7 +1161,8 @@ uint generateGLTextureId()
 
 void App::handleDisplayImageQueue()
 {
-    static std::vector<uint> tex_ids;
+    PROFILE_ZONE("display images");
+    GpuZone gpu_zone(gpu_timer_, "display images");
 
     std::vector<DisplayImageRequest> &queue(layouts_.getImageRequestQueue());
 
@@ -497,59 +1170,438 @@ void App::handleDisplayImageQueue()
         return;
     }
 
-    if (queue.size() > tex_ids.size()) {
-        for (uint i = tex_ids.size(); i < queue.size(); ++i) {
-            uint new_id(generateGLTextureId());
-            tex_ids.push_back(new_id);
+    // Unchanged images are skipped, and Secondary displays are refreshed at a
+    // lower rate and within the frame's upload budget
+    const std::vector<uint> &uploads(upload_scheduler_.schedule(queue, layouts_.getDisplayManager()));
+    for (uint ix : uploads) {
+        DisplayImageRequest &request(queue.at(ix));
+        pipeline_stats_.imageUploaded(request.getDisplayId());
+        if (isPlayingBag()) {
+            bag_bench_.imageUploaded(request.getDisplayId());
+        }
+        if (Profiler::isCapturing()) {
+            uint64_t flow_id(getFrameFlowId(request.getDisplayId()));
+            Profiler::flow("camera frame", Profiler::SampleKind::FlowStep, flow_id);
+            displayed_flows_.push_back(flow_id);
         }
-    }
 
-    for (int i = 0; i < queue.size(); ++i) {
-        DisplayImageRequest &request(queue.at(i));
-        uint cur_id(tex_ids.at(i));
+        // The quality governor may have Secondary displays uploaded below full size. Only
+        // 3-channel images are scaled, as they are the only ones uploaded as RGB below
+        const uchar *data(request.getDataVector().data());
+        int width(request.getWidth()), height(request.getHeight());
+        float scale(upload_scheduler_.getUploadScale(request.getPriority()));
+        uint channels(layouts_.getDisplayInfoById(request.getDisplayId()).dimensions.channels);
+        if (scale < 1.0f && width != 0 && height != 0 && channels == 3) {
+            cv::Mat image(height, width, CV_8UC3, (void*)data);
+            cv::resize(image, scaled_upload_, cv::Size(), scale, scale, cv::INTER_AREA);
+            data = scaled_upload_.data;
+            width = scaled_upload_.cols;
+            height = scaled_upload_.rows;
+        }
 
-        int width, height, x, y;
-        if (request.getWidth() == 0 || request.getHeight() == 0) {
-            glfwGetFramebufferSize(window_, &width, &height);
-            transformFramebufferDims(&x, &y, &width, &height);
+        // Displays the compositor can't hold still get their own texture
+        if (layouts_.getBatchedDisplays() && compositor_.uploadDisplay(request.getDisplayId(),
+                width, height, data)) {
+            continue;
         }
-        else {
-            width = request.getWidth();
-            height = request.getHeight();
+
+        // Each display keeps its own texture, so a display that wasn't uploaded
+        // this frame still shows its own last image
+        std::map<uint, DisplayTexture>::iterator texture(display_textures_.find(request.getDisplayId()));
+        if (texture == display_textures_.end()) {
+            texture = display_textures_.emplace(request.getDisplayId(), DisplayTexture{generateGLTextureId(), 0,
+                    std::chrono::steady_clock::now()}).first;
+        }
+        uint cur_id(texture->second.id);
+
+        int x, y;
+        if (width == 0 || height == 0) {
+            getFramebufferSize(&width, &height);
+            transformFramebufferDims(&x, &y, &width, &height);
         }
 
         glActiveTexture(0);
         glBindTexture(GL_TEXTURE_2D, cur_id);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE,
-                (GLvoid*)request.getDataVector().data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, (GLvoid*)data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        uint64_t bytes((uint64_t)width * height * 3);
+        MemoryTracker::add(MemoryTracker::Category::Textures, (int64_t)bytes - (int64_t)texture->second.bytes);
+        texture->second.bytes = bytes;
+    }
+
+    // Displays that weren't uploaded this frame keep showing their last image
+    std::chrono::steady_clock::time_point now(std::chrono::steady_clock::now());
+    for (const DisplayImageRequest &request : queue) {
+        std::map<uint, DisplayTexture>::iterator texture(display_textures_.find(request.getDisplayId()));
+        if (texture != display_textures_.end()) {
+            texture->second.drawn = now;
+            layouts_.pushImageResponse(DisplayImageResponse{texture->second.id, request.getDisplayId()});
+        }
+    }
 
+    const UploadScheduler::Stats &upload_stats(upload_scheduler_.getStats());
+    pipeline_stats_.bytesUploaded(upload_stats.bytes_uploaded);
+    pipeline_stats_.setQueueDepth(PipelineStats::Queue::ImageRequests, queue.size());
+    pipeline_stats_.setQueueDepth(PipelineStats::Queue::PendingUploads, upload_stats.num_held + upload_stats.num_deferred);
 
-        layouts_.pushImageResponse(DisplayImageResponse{cur_id, request.getDisplayId()});
+    // Held and deferred images still need a frame to be uploaded in
+    if (upload_scheduler_.hasPendingUploads()) {
+        requestRedraw();
     }
 
+    // Adaptive pacing follows the fastest camera being drawn
+    float fastest_rate(0.0f);
+    for (const DisplayImageRequest &request : queue) {
+        fastest_rate = std::max(fastest_rate, layouts_.getDisplayInfoById(request.getDisplayId()).frame_rate.load());
+    }
+    frame_pacer_.setCameraRate(fastest_rate);
+
     queue.clear();
 }
 
+void App::handleThumbnailQueue()
+{
+    PROFILE_ZONE("thumbnails");
+    GpuZone gpu_zone(gpu_timer_, "thumbnails");
+    std::vector<uint> &queue(layouts_.getThumbnailRequestQueue());
+    pipeline_stats_.setQueueDepth(PipelineStats::Queue::ThumbnailRequests, queue.size());
+
+    thumbnail_responses_.clear();
+    thumbnails_.update(queue, layouts_.getDisplayManager(), thumbnail_responses_);
+    for (const DisplayImageResponse &response : thumbnail_responses_) {
+        layouts_.pushThumbnailResponse(response);
+    }
 
-// -- ROS Handling --
-void App::cameraImageCallback(const sensor_msgs::ImageConstPtr& msg, uint id)
+    queue.clear();
+}
+
+void App::updateQualityGovernor()
 {
-    cv_bridge::CvImageConstPtr cur_img;
-    try
+    float target_ms(app_params_.governor_target_ms);
+    if (target_ms <= 0.0f) {
+        // Uncapped and on-demand pacing have no target of their own
+        float target_rate(frame_pacer_.getTargetRate());
+        target_ms = 1000.0f / (target_rate > 0.0f ? target_rate : app_params_.loop_rate);
+    }
+
+    // CPU work before the swap, plus the GPU's share when it's being timed. Waits
+    // for vblank or for a redraw don't count, or an idle GPU would look overloaded
+    float work_ms(frame_pacer_.getWorkTimeMs());
+    float gpu_ms;
+    if (gpu_timer_.getFrameMs(gpu_ms)) {
+        work_ms += gpu_ms;
+    }
+    gpu_timer_.setAlwaysOn(governor_.isEnabled());
+
+    bool changed(governor_.update(work_ms, target_ms));
+    if (changed) {
+        printText("Quality governor: " + governor_.getTransition());
+        applyQualityStage();
+    }
+
+    // Transitions are published straight away, the current stage once a second
+    std::chrono::steady_clock::time_point now(std::chrono::steady_clock::now());
+    if (changed || now - last_diagnostics_time_ >= std::chrono::seconds(1)) {
+        std::lock_guard<std::mutex> lock(diagnostics_mutex_);
+        governor_snapshot_.stage = governor_.getStage();
+        governor_snapshot_.enabled = governor_.isEnabled();
+        governor_snapshot_.work_ms = governor_.getWorkMs();
+        governor_snapshot_.target_ms = governor_.getTargetMs();
+        governor_snapshot_.num_transitions = governor_.getNumTransitions();
+        governor_snapshot_.transition = governor_.getTransition();
+        ++governor_snapshot_version_;
+        last_diagnostics_time_ = now;
+    }
+}
+
+void App::applyQualityStage()
+{
+    typedef QualityGovernor::Stage Stage;
+    Stage stage(governor_.getStage());
+
+    float secondary_rate(app_params_.secondary_upload_rate);
+    if (stage >= Stage::SecondaryRate) {
+        secondary_rate = (secondary_rate > 0.0f) ? std::min(secondary_rate, QualityGovernor::kReducedSecondaryRate) :
+                QualityGovernor::kReducedSecondaryRate;
+    }
+    upload_scheduler_.setSecondaryRate(secondary_rate);
+    upload_scheduler_.setSecondaryScale(stage >= Stage::SecondaryResolution ?
+            QualityGovernor::kReducedSecondaryScale : 1.0f);
+    upload_scheduler_.setPrimaryRate(stage >= Stage::PrimaryDecimation ?
+            QualityGovernor::kDecimatedPrimaryRate : 0.0f);
+}
+
+void App::publishGovernorDiagnostics(uint64_t &published_version)
+{
+    GovernorSnapshot snapshot;
     {
-        cur_img = cv_bridge::toCvShare(msg, sensor_msgs::image_encodings::RGB8);
+        std::lock_guard<std::mutex> lock(diagnostics_mutex_);
+        if (governor_snapshot_version_ == published_version) {
+            return;
+        }
+        snapshot = governor_snapshot_;
+        published_version = governor_snapshot_version_;
     }
-    catch (cv_bridge::Exception& e)
+
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = "viewpoint_interface: Quality governor";
+    status.hardware_id = "viewpoint_interface";
+    status.level = (snapshot.stage == QualityGovernor::Stage::Full) ? diagnostic_msgs::DiagnosticStatus::OK :
+            diagnostic_msgs::DiagnosticStatus::WARN;
+    status.message = QualityGovernor::stageToString(snapshot.stage);
+
+    auto addValue = [&status](const std::string &key, const std::string &value) {
+        diagnostic_msgs::KeyValue key_value;
+        key_value.key = key;
+        key_value.value = value;
+        status.values.push_back(key_value);
+    };
+    addValue("Enabled", snapshot.enabled ? "true" : "false");
+    addValue("Build + render (ms)", std::to_string(snapshot.work_ms));
+    addValue("Target (ms)", std::to_string(snapshot.target_ms));
+    addValue("Transitions", std::to_string(snapshot.num_transitions));
+    addValue("Last transition", snapshot.transition);
+
+    diagnostic_msgs::DiagnosticArray msg;
+    msg.header.stamp = ros::Time::now();
+    msg.status.push_back(status);
+    diagnostics_pub_.publish(msg);
+}
+
+void App::updateMemoryAccounting()
+{
+    std::chrono::steady_clock::time_point now(std::chrono::steady_clock::now());
+    if (now - last_memory_time_ < std::chrono::seconds(1)) {
+        return;
+    }
+    last_memory_time_ = now;
+
+    // Display buffers are sized by the callbacks, so they are summed up rather than tracked
+    uint64_t frame_bytes(0);
+    for (int i = 0; i < layouts_.getNumTotalDisplays(); ++i) {
+        frame_bytes += layouts_.getDisplayInfo(i).data.capacity();
+    }
+    MemoryTracker::set(MemoryTracker::Category::FrameBuffers, frame_bytes);
+
+    evictColdTextures(now);
+    uint64_t evictable_bytes(getEvictableTextureBytes());
+
+    std::lock_guard<std::mutex> lock(diagnostics_mutex_);
+    memory_snapshot_.evictable_texture_bytes = evictable_bytes;
+    memory_snapshot_.num_evicted_textures = num_evicted_textures_;
+    memory_snapshot_.num_evicted_thumbnails = thumbnails_.getNumEvicted();
+    memory_snapshot_.num_cached_layouts = layouts_.getNumCachedLayouts();
+    memory_snapshot_.num_evicted_layouts = layouts_.getNumEvictedLayouts();
+    ++memory_snapshot_version_;
+}
+
+void App::evictColdTextures(std::chrono::steady_clock::time_point now)
+{
+    // Only textures that can be evicted count against the cap. The compositor's texture
+    // array, the font atlas and model textures would otherwise keep it exceeded for good
+    int64_t cap_bytes((int64_t)(app_params_.texture_memory_mb * 1024 * 1024));
+    if (cap_bytes <= 0) {
+        return;
+    }
+    int64_t excess((int64_t)getEvictableTextureBytes() - cap_bytes);
+    if (excess <= 0) {
+        return;
+    }
+
+    // Full-size display textures go first, coldest first, then carousel thumbnails
+    std::chrono::seconds min_age(kColdTextureSeconds);
+    while (excess > 0) {
+        std::map<uint, DisplayTexture>::iterator coldest(display_textures_.end());
+        for (std::map<uint, DisplayTexture>::iterator texture(display_textures_.begin());
+                texture != display_textures_.end(); ++texture) {
+            if (now - texture->second.drawn >= min_age &&
+                    (coldest == display_textures_.end() || texture->second.drawn < coldest->second.drawn)) {
+                coldest = texture;
+            }
+        }
+        if (coldest == display_textures_.end()) {
+            break;
+        }
+
+        // Layouts drop the deleted name, and the display is uploaded afresh into a new texture when
+        // it is back on screen, even if its image hasn't changed
+        glDeleteTextures(1, &coldest->second.id);
+        MemoryTracker::add(MemoryTracker::Category::Textures, -(int64_t)coldest->second.bytes);
+        excess -= coldest->second.bytes;
+        layouts_.forgetDisplayImage(coldest->first);
+        upload_scheduler_.forgetDisplay(coldest->first);
+        display_textures_.erase(coldest);
+        ++num_evicted_textures_;
+    }
+
+    if (excess > 0) {
+        std::vector<uint> evicted_ids;
+        thumbnails_.evictCold(min_age, excess, evicted_ids);
+        for (uint display_id : evicted_ids) {
+            layouts_.forgetThumbnail(display_id);
+        }
+    }
+}
+
+uint64_t App::getEvictableTextureBytes() const
+{
+    uint64_t bytes(thumbnails_.getTotalBytes());
+    for (const auto &texture : display_textures_) {
+        bytes += texture.second.bytes;
+    }
+
+    return bytes;
+}
+
+void App::publishMemoryDiagnostics(uint64_t &published_version)
+{
+    MemorySnapshot snapshot;
     {
-        printText("cv_bridge exception: %s", 0);
-        printText(e.what());
+        std::lock_guard<std::mutex> lock(diagnostics_mutex_);
+        if (memory_snapshot_version_ == published_version) {
+            return;
+        }
+        snapshot = memory_snapshot_;
+        published_version = memory_snapshot_version_;
+    }
+
+    // The byte counts are atomics, read as they are now
+    typedef MemoryTracker::Category Category;
+    bool over_cap(app_params_.texture_memory_mb > 0.0f &&
+            snapshot.evictable_texture_bytes > (uint64_t)(app_params_.texture_memory_mb * 1024 * 1024));
+
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = "viewpoint_interface: Memory";
+    status.hardware_id = "viewpoint_interface";
+    status.level = over_cap ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = over_cap ? "Textures over cap" : "OK";
+
+    auto addValue = [&status](const std::string &key, const std::string &value) {
+        diagnostic_msgs::KeyValue key_value;
+        key_value.key = key;
+        key_value.value = value;
+        status.values.push_back(key_value);
+    };
+    for (int i = 0; i < (int)Category::Count; ++i) {
+        addValue(std::string(MemoryTracker::categoryToString((Category)i)) + " (MB)",
+                std::to_string(MemoryTracker::get((Category)i) / (1024.0 * 1024.0)));
+    }
+    addValue("Total (MB)", std::to_string(MemoryTracker::getTotal() / (1024.0 * 1024.0)));
+    addValue("Texture cap (MB)", std::to_string(app_params_.texture_memory_mb));
+    addValue("Evictable textures (MB)", std::to_string(snapshot.evictable_texture_bytes / (1024.0 * 1024.0)));
+    addValue("Evicted display textures", std::to_string(snapshot.num_evicted_textures));
+    addValue("Evicted thumbnails", std::to_string(snapshot.num_evicted_thumbnails));
+    addValue("Cached layouts", std::to_string(snapshot.num_cached_layouts));
+    addValue("Evicted layouts", std::to_string(snapshot.num_evicted_layouts));
+
+    diagnostic_msgs::DiagnosticArray msg;
+    msg.header.stamp = ros::Time::now();
+    msg.status.push_back(status);
+    diagnostics_pub_.publish(msg);
+}
+
+void App::requestTraceCapture()
+{
+    if (getProfiler().requestCapture()) {
+        printText("Capturing " + std::to_string(app_params_.trace_seconds) + " s trace to " + app_params_.trace_dir);
+    }
+    else {
+        printText("A trace capture is already running.");
+    }
+}
+
+bool App::captureTraceService(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res)
+{
+    res.success = getProfiler().requestCapture();
+    res.message = res.success ? "Capturing " + std::to_string(app_params_.trace_seconds) + " s trace to " +
+            app_params_.trace_dir : "A trace capture is already running";
+    return true;
+}
+
+uint64_t App::getFrameFlowId(uint display_id) const
+{
+    return ((uint64_t)display_id << 32) | (layouts_.getDisplayInfoById(display_id).num_frames.load() & 0xFFFFFFFF);
+}
+
+void App::applyLayoutConfigUpdates()
+{
+    std::string error;
+    if (layout_config_.takeError(error)) {
+        printText("Layout config " + app_params_.layout_config_file + " not reloaded: " + error);
+    }
+
+    // Parsing happened on the watcher thread, so this only swaps descriptions
+    std::vector<LayoutSpec> specs;
+    if (layout_config_.takeUpdate(specs)) {
+        layouts_.setConfigLayouts(specs);
+    }
+}
+
+
+// -- ROS Handling --
+void App::cameraImageCallback(const sensor_msgs::ImageConstPtr& msg, uint id)
+{
+    // The spinner starts its threads itself, so they are named by their first callback
+    Profiler::setThreadName("ros callbacks");
+    ingestCameraImage(msg, id);
+}
+
+void App::ingestCameraImage(const sensor_msgs::ImageConstPtr& msg, uint id)
+{
+    PROFILE_ZONE("ingest");
+
+    float age_ms(-1.0f);
+    if (msg->header.stamp.toSec() > 0.0) {
+        age_ms = (ros::Time::now() - msg->header.stamp).toSec() * 1000.0;
+    }
+    pipeline_stats_.imageReceived(id, age_ms);
+
+    // Images from synthetic_cameras carry their sequence number, which checks
+    // delivery end to end whether or not the display is on screen
+    uint64_t seq;
+    if (msg->width > 0 && msg->data.size() >= msg->step &&
+            readFrameMarker(msg->data.data(), msg->width, msg->step / msg->width, seq)) {
+        stream_checker_.frameReceived(id, seq, age_ms);
+        pipeline_stats_.setDropped(id, stream_checker_.getStats(id).dropped);
+    }
+
+    // Skip the conversion entirely for displays that aren't on screen
+    if (!layouts_.isDisplayVisible(id)) {
         return;
     }
 
     cv::Mat unflipped_mat;
-    cv::flip(cur_img->image, unflipped_mat, 0);
+    {
+        PROFILE_ZONE("convert");
+        std::chrono::steady_clock::time_point convert_start(std::chrono::steady_clock::now());
+        cv_bridge::CvImageConstPtr cur_img;
+        try
+        {
+            cur_img = cv_bridge::toCvShare(msg, sensor_msgs::image_encodings::RGB8);
+        }
+        catch (cv_bridge::Exception& e)
+        {
+            printText("cv_bridge exception: %s", 0);
+            printText(e.what());
+            return;
+        }
+
+        cv::flip(cur_img->image, unflipped_mat, 0);
+
+        std::chrono::duration<float, std::milli> convert_time(std::chrono::steady_clock::now() - convert_start);
+        pipeline_stats_.imageConverted(id, convert_time.count());
+    }
 
-    layouts_.forwardImageForDisplayId(id, unflipped_mat);
+    {
+        PROFILE_ZONE("copy");
+        layouts_.forwardImageForDisplayId(id, unflipped_mat);
+    }
+    if (Profiler::isCapturing()) {
+        Profiler::flow("camera frame", Profiler::SampleKind::FlowStart, getFrameFlowId(id));
+    }
+    requestRedraw();
 }
 
 void App::cameraMatrixCallback(const std_msgs::Float32MultiArrayConstPtr& msg, uint id)
@@ -559,22 +1611,22 @@ void App::cameraMatrixCallback(const std_msgs::Float32MultiArrayConstPtr& msg, u
 
 void App::graspingCallback(const std_msgs::BoolConstPtr& msg)
 {
-    layouts_.setGrabbingState(msg->data);
+    handleInputEvent(InputEventType::Grasping, std::string(1, (char)msg->data), LatencyTracker::now());
 }
 
 void App::clutchingCallback(const std_msgs::BoolConstPtr& msg)
 {
-    layouts_.setClutchingState(msg->data);
+    handleInputEvent(InputEventType::Clutching, std::string(1, (char)msg->data), LatencyTracker::now());
 }
 
 void App::collisionCallback(const std_msgs::StringConstPtr& msg)
 {
-    layouts_.handleCollisionMessage(msg->data);
+    handleInputEvent(InputEventType::Collision, msg->data, LatencyTracker::now());
 }
 
 void App::activeDisplayCallback(const std_msgs::UInt8ConstPtr& msg)
 {
-    layouts_.setActiveFrame(msg->data);
+    handleInputEvent(InputEventType::ActiveDisplay, std::string(1, (char)msg->data), LatencyTracker::now());
 }
 
 void App::publishControlFrameMatrix()
@@ -598,16 +1650,77 @@ void App::publishDisplayBounds()
 
 void App::publishDisplayData()
 {
+    Profiler::setThreadName("publisher");
     ros::Rate loop_rate(app_params_.loop_rate);
-    while (ros::ok() && !glfwWindowShouldClose(window_))
+    while (ros::ok() && !shouldClose())
     {
-        publishControlFrameMatrix();
-        publishDisplayBounds();
+        {
+            PROFILE_ZONE("publish display data");
+            publishControlFrameMatrix();
+            publishDisplayBounds();
+        }
 
         loop_rate.sleep();
     }
 }
 
+void App::publishDiagnostics()
+{
+    Profiler::setThreadName("diagnostics");
+    bool publish_pipeline(app_params_.diagnostics_rate > 0.0f);
+    std::chrono::steady_clock::duration period(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(publish_pipeline ? 1.0 / app_params_.diagnostics_rate : 1.0)));
+    std::chrono::steady_clock::time_point next_pipeline(std::chrono::steady_clock::now() + period);
+    uint64_t governor_version(0), memory_version(0);
+    while (ros::ok() && !shouldClose())
+    {
+        // Wake often enough to pass on governor transitions promptly and not hold up shutdown
+        std::chrono::steady_clock::time_point wake(std::chrono::steady_clock::now() + std::chrono::milliseconds(100));
+        std::this_thread::sleep_until(publish_pipeline ? std::min(next_pipeline, wake) : wake);
+
+        publishGovernorDiagnostics(governor_version);
+        publishMemoryDiagnostics(memory_version);
+
+        if (publish_pipeline && std::chrono::steady_clock::now() >= next_pipeline) {
+            next_pipeline += period;
+
+            PROFILE_ZONE("pipeline diagnostics");
+            diagnostics_pub_.publish(pipeline_stats_.makeDiagnostics());
+        }
+    }
+}
+
+void App::requestRedraw()
+{
+    if (frame_pacer_.requestRedraw() && !app_params_.headless) {
+        glfwPostEmptyEvent();
+    }
+}
+
+bool App::waitForRedraw()
+{
+    frame_pacer_.setIdle(true);
+
+    bool redraw(frame_pacer_.needsRedraw());
+    if (!redraw) {
+        int64_t deadline_ms(layouts_.getNextDeadlineMs());
+        bool has_deadline(deadline_ms >= 0 && deadline_ms < kMaxIdleMs);
+        double timeout((has_deadline ? deadline_ms : kMaxIdleMs) / 1000.0);
+
+        // Window events and requestRedraw() both end the wait early. Running
+        // out the full idle time just means the loop should check for shutdown
+        double wait_start(glfwGetTime());
+        glfwWaitEventsTimeout(timeout);
+        if (has_deadline || glfwGetTime() - wait_start < timeout) {
+            frame_pacer_.markChanged();
+        }
+        redraw = frame_pacer_.needsRedraw();
+    }
+
+    frame_pacer_.setIdle(false);
+    return redraw;
+}
+
 int App::run(int argc, char *argv[])
 {
     if (!initialize()) {
@@ -616,38 +1729,147 @@ int App::run(int argc, char *argv[])
 
     std::thread controller_input(&App::handleControllerInput, this);
     std::thread publish_display_data(&App::publishDisplayData, this);
+    std::thread latency_test;
+    if (app_params_.latency_test_commands > 0) {
+        latency_test = std::thread(&App::runLatencyTest, this);
+    }
+    std::thread diagnostics(&App::publishDiagnostics, this);
+    std::thread bag_player;
+    if (isPlayingBag()) {
+        bag_player = std::thread(&App::playBag, this);
+    }
 
-    ros::Rate loop_rate(app_params_.loop_rate);
-    while (ros::ok() && !glfwWindowShouldClose(window_))
+    Profiler::setThreadName("render");
+    while (ros::ok() && !shouldClose())
     {
-        glfwPollEvents();
+        getProfiler().frameMark();
+        gpu_timer_.frameMark();
+        std::string trace_result;
+        if (getProfiler().takeCaptureResult(trace_result)) {
+            printText(trace_result);
+        }
 
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+        // Input and camera images are sampled after this returns, so waiting
+        // here (rather than after the swap) keeps them as fresh as possible
+        {
+            PROFILE_ZONE("wait");
+            frame_pacer_.waitForFrameStart();
+        }
 
-        // ImGui::ShowDemoWindow();
+        int swap_interval;
+        if (frame_pacer_.consumeSwapIntervalChange(swap_interval) && !app_params_.headless) {
+            glfwSwapInterval(swap_interval);
+        }
 
-        layouts_.draw();
+        if (frame_pacer_.getMode() == FramePacer::Mode::OnDemand) {
+            PROFILE_ZONE("wait for redraw");
+            if (!waitForRedraw()) {
+                continue;
+            }
+            frame_pacer_.restartFrame();
+        }
+        else if (!app_params_.headless) {
+            PROFILE_ZONE("poll events");
+            glfwPollEvents();
+        }
 
-        handleDisplayImageQueue();
+        {
+            PROFILE_ZONE("pending inputs");
+            applyPendingInputs();
+        }
 
-        glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // Replayed inputs are applied between frames, before the frame they
+        // reached when they were recorded, so a replay doesn't depend on timing
+        if (isReplaying()) {
+            PROFILE_ZONE("replay inputs");
+            applyReplayedInputs();
+        }
+        ++input_frame_;
 
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        // Per-frame temporaries from the last frame are no longer referenced
+        getFrameArena().reset();
+        uint64_t frame_start_allocations(getThreadHeapAllocations());
 
-        glfwSwapBuffers(window_);
+        {
+            PROFILE_ZONE("imgui build");
+            newImGuiFrame();
 
-        // ImGui::EndFrame();
+            // ImGui::ShowDemoWindow();
 
-        loop_rate.sleep();
+            latency_.frameStarted();
+            applyLayoutConfigUpdates();
+
+            PROFILE_ZONE("layout");
+            layouts_.draw();
+        }
+
+        {
+            PROFILE_ZONE("upload");
+            handleDisplayImageQueue();
+            handleThumbnailQueue();
+        }
+
+        {
+            PROFILE_ZONE("render");
+            glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            ImGui::Render();
+            if (layouts_.getBatchedDisplays()) {
+                PROFILE_ZONE("compositor");
+                GpuZone gpu_zone(gpu_timer_, "compositor");
+                ImVec2 display_size(ImGui::GetIO().DisplaySize);
+                compositor_.draw(layouts_.getDisplayQuads(), display_size.x, display_size.y);
+            }
+
+            PROFILE_ZONE("imgui render");
+            GpuZone gpu_zone(gpu_timer_, "imgui render");
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+
+        int frame_width, frame_height;
+        getFramebufferSize(&frame_width, &frame_height);
+        {
+            PROFILE_ZONE("view capture");
+            view_recorder_.frameRendered(frame_width, frame_height);
+            view_publisher_.frameRendered(frame_width, frame_height);
+        }
+
+        frame_pacer_.frameRendered();
+        {
+            PROFILE_ZONE("swap");
+            presentFrame();
+
+            // Camera frames uploaded this frame are on screen from this swap
+            for (uint64_t flow_id : displayed_flows_) {
+                Profiler::flow("camera frame", Profiler::SampleKind::FlowEnd, flow_id);
+            }
+            displayed_flows_.clear();
+            if (isPlayingBag()) {
+                bag_bench_.frameSwapped();
+            }
+        }
+        frame_pacer_.frameSwapped();
+        latency_.frameSwapped();
+        pipeline_stats_.frameSwapped();
+        updateQualityGovernor();
+        updateMemoryAccounting();
+
+        last_frame_allocations_ = getThreadHeapAllocations() - frame_start_allocations;
+
+        // ImGui::EndFrame();
     }
 
     controller_input.join();
     publish_display_data.join();
+    if (latency_test.joinable()) {
+        latency_test.join();
+    }
+    diagnostics.join();
+    if (bag_player.joinable()) {
+        bag_player.join();
+    }
     shutdownApp();
 
-    return 0;
+    return (isPlayingBag() && !bag_bench_.passed()) ? 1 : 0;
 }
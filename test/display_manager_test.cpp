@@ -0,0 +1,64 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "viewpoint_interface/display.hpp"
+
+
+namespace viewpoint_interface
+{
+
+static Display makeDisplay(const std::string &name)
+{
+    std::string internal(name), external(name), topic("/test/" + name);
+    return Display(internal, external, topic, DisplayDims(64, 48, 3));
+}
+
+TEST(DisplayManagerTest, LooksUpDisplaysById)
+{
+    DisplayManager displays;
+    std::vector<uint> ids;
+    for (uint i(0); i < 4; ++i) {
+        Display display(makeDisplay("camera_" + std::to_string(i)));
+        ids.push_back(display.getId());
+        displays.addDisplay(display);
+    }
+
+    for (uint i(0); i < ids.size(); ++i) {
+        EXPECT_EQ(displays.getDisplayIxById(ids[i]), i);
+        EXPECT_EQ(displays.getDisplayInternalNameById(ids[i]), "camera_" + std::to_string(i));
+    }
+    EXPECT_FALSE(displays.isValidId(0));
+    EXPECT_FALSE(displays.isValidId(ids.front() - 1));
+    EXPECT_FALSE(displays.isValidId(ids.back() + 1));
+    EXPECT_THROW(displays.getDisplayInfoById(ids.back() + 1), std::out_of_range);
+
+    displays.swapDisplays(0, 3);
+    EXPECT_EQ(displays.getDisplayIxById(ids[0]), 3u);
+    EXPECT_EQ(displays.getDisplayIxById(ids[3]), 0u);
+    EXPECT_EQ(displays.getDisplayInternalNameById(ids[0]), "camera_0");
+}
+
+// Ids come from a counter shared by every display, so a manager may be given
+// displays in any order and far from the first id
+TEST(DisplayManagerTest, AcceptsDisplaysOutOfIdOrder)
+{
+    for (uint i(0); i < 1000; ++i) {
+        makeDisplay("unused");
+    }
+    Display first(makeDisplay("first")), second(makeDisplay("second")), third(makeDisplay("third"));
+
+    DisplayManager displays;
+    displays.addDisplay(third);
+    displays.addDisplay(first);
+    displays.addDisplay(second);
+
+    EXPECT_EQ(displays.getDisplayIxById(third.getId()), 0u);
+    EXPECT_EQ(displays.getDisplayIxById(first.getId()), 1u);
+    EXPECT_EQ(displays.getDisplayIxById(second.getId()), 2u);
+    EXPECT_FALSE(displays.isValidId(first.getId() - 1));
+}
+
+} // viewpoint_interface
@@ -0,0 +1,578 @@
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "viewpoint_interface/layout.hpp"
+
+
+/**
+ * Checks the DisplayRing, which keeps roles as per-slot bits with cached role
+ * lists, against the map-based ring it replaced. Both are driven with the same
+ * random command sequences and must agree after every command.
+ */
+
+namespace viewpoint_interface
+{
+
+static const uint kNumSequences = 200;
+static const uint kCommandsPerSequence = 300;
+static const uint kMaxDisplays = 16;
+
+
+// Exposes the protected display state classes and draws nothing
+class TestLayout : public Layout
+{
+public:
+    using Layout::DisplayRing;
+    using Layout::LayoutDisplayStates;
+
+    TestLayout(DisplayManager &displays) : Layout(LayoutType::GRID, displays) {}
+
+    virtual void displayLayoutParams() override {}
+    virtual void draw() override {}
+
+    LayoutDisplayStates& getDisplayStates() { return display_states_; }
+};
+
+// The DisplayRing as it was before the role bits, with roles kept in maps and
+// every list and count recomputed on each call
+class MapDisplayRing
+{
+public:
+    MapDisplayRing() : active_frame_(0) {}
+
+    const std::vector<uint>& getRing() const { return ring_; }
+
+    void pushDisplay(uint id) { ring_.emplace_back(id); }
+
+    void removeDisplay(uint id)
+    {
+        if (isDisplayRole(id, LayoutDisplayRole::Primary)) {
+            roles(LayoutDisplayRole::Primary)[getNextIdWithoutRole(id, LayoutDisplayRole::Primary)] = true;
+        }
+        if (isDisplayRole(id, LayoutDisplayRole::Secondary)) {
+            roles(LayoutDisplayRole::Secondary)[getNextIdWithoutRole(id, LayoutDisplayRole::Secondary)] = true;
+        }
+        unsetRoles(id);
+
+        ring_.erase(ring_.begin() + getIndexForDisplayId(id));
+        if (active_frame_ >= ring_.size()) {
+            setActiveFrameByIndex(0);
+        }
+    }
+
+    void swapDisplays(uint id, float delta)
+    {
+        int first_ix(getIndexForDisplayId(id));
+        int second_ix(-1);
+        if (delta < 0 && first_ix > 0) {
+            second_ix = first_ix-1;
+        }
+        else if (delta > 0 && first_ix < int(ring_.size())-1) {
+            second_ix = first_ix+1;
+        }
+        else {
+            return;
+        }
+
+        std::swap(ring_[first_ix], ring_[second_ix]);
+    }
+
+    void toNextDisplay(LayoutDisplayRole role) { moveDisplay(role, true); }
+    void toPrevDisplay(LayoutDisplayRole role) { moveDisplay(role, false); }
+
+    void setDisplayRole(uint id, LayoutDisplayRole role) { roles(role)[id] = true; }
+    void unsetDisplayRole(uint id, LayoutDisplayRole role) { roles(role)[id] = false; }
+
+    void unsetRoles(uint id)
+    {
+        primary_displays_[id] = false;
+        secondary_displays_[id] = false;
+    }
+
+    void unsetAllForRole(LayoutDisplayRole role)
+    {
+        for (auto &entry : roles(role)) {
+            entry.second = false;
+        }
+    }
+
+    bool isDisplayRole(uint id, LayoutDisplayRole role) const
+    {
+        const std::map<uint, bool> &role_map(role == LayoutDisplayRole::Primary ?
+                primary_displays_ : secondary_displays_);
+        auto entry(role_map.find(id));
+        return entry != role_map.end() && entry->second;
+    }
+
+    std::vector<uint> getDisplayRoleList(LayoutDisplayRole role) const
+    {
+        std::vector<uint> list;
+        for (uint id : ring_) {
+            if (isDisplayRole(id, role)) {
+                list.emplace_back(id);
+            }
+        }
+
+        return list;
+    }
+
+    uint getNumForRole(LayoutDisplayRole role) const
+    {
+        const std::map<uint, bool> &role_map(role == LayoutDisplayRole::Primary ?
+                primary_displays_ : secondary_displays_);
+        uint count(0);
+        for (const auto &entry : role_map) {
+            count += entry.second;
+        }
+
+        return count;
+    }
+
+    void setActiveFrameByIndex(uint ix)
+    {
+        if (ix > ring_.size()) {
+            return;
+        }
+
+        active_frame_ = ix;
+    }
+
+    void setActiveFrameById(uint id)
+    {
+        std::vector<uint> prim_vec(getDisplayRoleList(LayoutDisplayRole::Primary));
+        for (uint i(0); i < prim_vec.size(); ++i) {
+            if (prim_vec[i] == id) {
+                setActiveFrameByIndex(i);
+                return;
+            }
+        }
+    }
+
+    uint getActiveFrameIndex() const { return active_frame_; }
+
+    uint getActiveFrameDisplayId() const
+    {
+        if (ring_.empty()) {
+            return 0;
+        }
+
+        return getDisplayRoleList(LayoutDisplayRole::Primary).at(active_frame_);
+    }
+
+    void toNextActiveFrame()
+    {
+        ++active_frame_;
+        if (active_frame_ == getNumForRole(LayoutDisplayRole::Primary)) {
+            active_frame_ = 0;
+        }
+    }
+
+    void toPrevActiveFrame()
+    {
+        if (active_frame_ == 0) {
+            active_frame_ = getNumForRole(LayoutDisplayRole::Primary)-1;
+        }
+        else {
+            --active_frame_;
+        }
+    }
+
+private:
+    std::vector<uint> ring_;
+    std::map<uint, bool> primary_displays_;
+    std::map<uint, bool> secondary_displays_;
+    uint active_frame_;
+
+    std::map<uint, bool>& roles(LayoutDisplayRole role)
+    {
+        return role == LayoutDisplayRole::Primary ? primary_displays_ : secondary_displays_;
+    }
+
+    void moveDisplay(LayoutDisplayRole role, bool forward)
+    {
+        if (ring_.size() < 2 || getNumForRole(role) == 0) {
+            return;
+        }
+
+        uint cur_frame_id(getActiveFrameDisplayId());
+        if (!isDisplayRole(cur_frame_id, role)) {
+            std::vector<uint> role_vec(getDisplayRoleList(role));
+            if (role_vec.size() > 1) {
+                return;
+            }
+            cur_frame_id = role_vec.at(0);
+        }
+
+        uint new_id(forward ? getNextIdWithoutRole(cur_frame_id, role) :
+                getPrevIdWithoutRole(cur_frame_id, role));
+        if (cur_frame_id != new_id) {
+            unsetDisplayRole(cur_frame_id, role);
+            setDisplayRole(new_id, role);
+            setActiveFrameById(new_id);
+        }
+    }
+
+    uint getNextIdWithoutRole(uint start_id, LayoutDisplayRole role) const
+    {
+        int cur_ix(getIndexForDisplayId(start_id));
+        for (int i(cur_ix+1); i < int(ring_.size()); ++i) {
+            if (!isDisplayRole(ring_[i], role)) {
+                return ring_[i];
+            }
+        }
+        for (int i(0); i < cur_ix; ++i) {
+            if (!isDisplayRole(ring_[i], role)) {
+                return ring_[i];
+            }
+        }
+
+        return start_id;
+    }
+
+    uint getPrevIdWithoutRole(uint start_id, LayoutDisplayRole role) const
+    {
+        int cur_ix(getIndexForDisplayId(start_id));
+        for (int i(cur_ix-1); i >= 0; --i) {
+            if (!isDisplayRole(ring_[i], role)) {
+                return ring_[i];
+            }
+        }
+        for (int i(int(ring_.size())-1); i > cur_ix; --i) {
+            if (!isDisplayRole(ring_[i], role)) {
+                return ring_[i];
+            }
+        }
+
+        return start_id;
+    }
+
+    int getIndexForDisplayId(uint id) const
+    {
+        for (uint ix(0); ix < ring_.size(); ++ix) {
+            if (ring_[ix] == id) {
+                return ix;
+            }
+        }
+
+        return -1;
+    }
+};
+
+
+static const LayoutDisplayRole kRoles[] = { LayoutDisplayRole::Primary, LayoutDisplayRole::Secondary };
+
+static std::string roleName(LayoutDisplayRole role)
+{
+    return role == LayoutDisplayRole::Primary ? "primary" : "secondary";
+}
+
+// The active frame lookup throws when the active frame is past the end of the
+// primary list, which has to happen for both rings alike
+static bool getActiveFrameDisplayId(const TestLayout::DisplayRing &ring, uint &id)
+{
+    try {
+        id = ring.getActiveFrameDisplayId();
+        return true;
+    }
+    catch (const std::out_of_range &) {
+        return false;
+    }
+}
+
+static bool getActiveFrameDisplayId(const MapDisplayRing &ring, uint &id)
+{
+    try {
+        id = ring.getActiveFrameDisplayId();
+        return true;
+    }
+    catch (const std::out_of_range &) {
+        return false;
+    }
+}
+
+// The cached role list has to match the list recomputed from the ring slots
+static void expectRoleListsMatchSlots(const TestLayout::DisplayRing &ring, const std::string &context)
+{
+    for (LayoutDisplayRole role : kRoles) {
+        std::vector<uint> recomputed;
+        for (auto it(ring.loopStart()); it != ring.loopEnd(); ++it) {
+            if (ring.isDisplayRole(*it, role)) {
+                recomputed.push_back(*it);
+            }
+        }
+
+        EXPECT_EQ(*ring.getDisplayRoleList(role), recomputed) << roleName(role) << ", " << context;
+        EXPECT_EQ(ring.getNumForRole(role), recomputed.size()) << roleName(role) << ", " << context;
+    }
+}
+
+static void expectRingsMatch(const TestLayout::DisplayRing &ring, const MapDisplayRing &expected,
+        const std::string &context)
+{
+    std::vector<uint> ring_ids(ring.loopStart(), ring.loopEnd());
+    ASSERT_EQ(ring_ids, expected.getRing()) << context;
+
+    for (LayoutDisplayRole role : kRoles) {
+        EXPECT_EQ(*ring.getDisplayRoleList(role), expected.getDisplayRoleList(role)) << roleName(role) << ", " << context;
+        EXPECT_EQ(ring.getNumForRole(role), expected.getNumForRole(role)) << roleName(role) << ", " << context;
+        for (uint id : ring_ids) {
+            EXPECT_EQ(ring.isDisplayRole(id, role), expected.isDisplayRole(id, role))
+                    << roleName(role) << " display " << id << ", " << context;
+        }
+    }
+    expectRoleListsMatchSlots(ring, context);
+
+    EXPECT_EQ(ring.getActiveFrameIndex(), expected.getActiveFrameIndex()) << context;
+    uint active_id(0), expected_active_id(0);
+    bool has_active(getActiveFrameDisplayId(ring, active_id));
+    ASSERT_EQ(has_active, getActiveFrameDisplayId(expected, expected_active_id)) << context;
+    EXPECT_EQ(active_id, expected_active_id) << context;
+}
+
+// Runs one random command against both rings, returning its name. Commands
+// only name displays in the ring, as the layouts do.
+static std::string applyRandomCommand(std::mt19937 &rng, TestLayout::DisplayRing &ring,
+        MapDisplayRing &expected, uint &next_id)
+{
+    const std::vector<uint> &ids(expected.getRing());
+    std::uniform_int_distribution<uint> command_dist(0, 12);
+    LayoutDisplayRole role(kRoles[rng() % 2]);
+
+    uint command(command_dist(rng));
+    if (ids.empty() || (command == 0 && ids.size() < kMaxDisplays)) {
+        ring.pushDisplay(next_id);
+        expected.pushDisplay(next_id);
+        return "pushDisplay(" + std::to_string(next_id++) + ")";
+    }
+
+    uint id(ids[rng() % ids.size()]);
+    std::string arg(std::to_string(id) + ", " + roleName(role));
+    switch (command)
+    {
+        case 0:
+        case 1:
+        {
+            ring.removeDisplay(id);
+            expected.removeDisplay(id);
+            return "removeDisplay(" + std::to_string(id) + ")";
+        }
+
+        case 2:
+        {
+            float delta(rng() % 2 ? 1.0f : -1.0f);
+            ring.swapDisplays(id, delta);
+            expected.swapDisplays(id, delta);
+            return "swapDisplays(" + std::to_string(id) + ", " + std::to_string(delta) + ")";
+        }
+
+        case 3:
+        {
+            // Both rings can throw out of here, so only compare whether they did
+            bool threw(false), expected_threw(false);
+            try { ring.toNextDisplay(role); } catch (const std::out_of_range &) { threw = true; }
+            try { expected.toNextDisplay(role); } catch (const std::out_of_range &) { expected_threw = true; }
+            EXPECT_EQ(threw, expected_threw) << "toNextDisplay(" << roleName(role) << ")";
+            return "toNextDisplay(" + roleName(role) + ")";
+        }
+
+        case 4:
+        {
+            bool threw(false), expected_threw(false);
+            try { ring.toPrevDisplay(role); } catch (const std::out_of_range &) { threw = true; }
+            try { expected.toPrevDisplay(role); } catch (const std::out_of_range &) { expected_threw = true; }
+            EXPECT_EQ(threw, expected_threw) << "toPrevDisplay(" << roleName(role) << ")";
+            return "toPrevDisplay(" + roleName(role) + ")";
+        }
+
+        case 5:
+        case 6:
+        {
+            ring.setDisplayRole(id, role);
+            expected.setDisplayRole(id, role);
+            return "setDisplayRole(" + arg + ")";
+        }
+
+        case 7:
+        {
+            ring.unsetDisplayRole(id, role);
+            expected.unsetDisplayRole(id, role);
+            return "unsetDisplayRole(" + arg + ")";
+        }
+
+        case 8:
+        {
+            ring.unsetRoles(id);
+            expected.unsetRoles(id);
+            return "unsetRoles(" + std::to_string(id) + ")";
+        }
+
+        case 9:
+        {
+            ring.unsetAllForRole(role);
+            expected.unsetAllForRole(role);
+            return "unsetAllForRole(" + roleName(role) + ")";
+        }
+
+        case 10:
+        {
+            uint ix(rng() % (ids.size() + 2));
+            ring.setActiveFrameByIndex(ix);
+            expected.setActiveFrameByIndex(ix);
+            return "setActiveFrameByIndex(" + std::to_string(ix) + ")";
+        }
+
+        case 11:
+        {
+            ring.setActiveFrameById(id);
+            expected.setActiveFrameById(id);
+            return "setActiveFrameById(" + std::to_string(id) + ")";
+        }
+
+        default:
+        {
+            if (rng() % 2) {
+                ring.toNextActiveFrame();
+                expected.toNextActiveFrame();
+                return "toNextActiveFrame()";
+            }
+            ring.toPrevActiveFrame();
+            expected.toPrevActiveFrame();
+            return "toPrevActiveFrame()";
+        }
+    }
+}
+
+
+TEST(DisplayRingTest, MatchesMapRingAfterRandomCommands)
+{
+    for (uint seed(0); seed < kNumSequences; ++seed) {
+        std::mt19937 rng(seed);
+        TestLayout::DisplayRing ring;
+        MapDisplayRing expected;
+        uint next_id(0);
+
+        for (uint i(0); i < kCommandsPerSequence; ++i) {
+            std::string command(applyRandomCommand(rng, ring, expected, next_id));
+            expectRingsMatch(ring, expected, "seed " + std::to_string(seed) +
+                    ", command " + std::to_string(i) + ": " + command);
+            if (::testing::Test::HasFailure()) {
+                return;
+            }
+        }
+    }
+}
+
+TEST(DisplayRingTest, RoleListSnapshotsDoNotChange)
+{
+    std::mt19937 rng(1);
+    TestLayout::DisplayRing ring;
+    MapDisplayRing expected;
+    uint next_id(0);
+    for (uint i(0); i < kMaxDisplays; ++i) {
+        ring.pushDisplay(next_id);
+        expected.pushDisplay(next_id);
+        ring.setDisplayRole(next_id, LayoutDisplayRole::Primary);
+        expected.setDisplayRole(next_id++, LayoutDisplayRole::Primary);
+    }
+
+    for (uint i(0); i < kCommandsPerSequence; ++i) {
+        TestLayout::DisplayRing::RoleList snapshot(ring.getDisplayRoleList(LayoutDisplayRole::Primary));
+        std::vector<uint> contents(*snapshot);
+        uint generation(ring.getGeneration());
+
+        std::string command(applyRandomCommand(rng, ring, expected, next_id));
+        ASSERT_EQ(*snapshot, contents) << command;
+        if (*ring.getDisplayRoleList(LayoutDisplayRole::Primary) != contents) {
+            EXPECT_NE(ring.getGeneration(), generation) << command;
+        }
+    }
+}
+
+// The generation keys the cached layout geometry, so it only moves when something changed
+TEST(DisplayRingTest, GenerationIgnoresRolesDisplaysAlreadyHave)
+{
+    TestLayout::DisplayRing ring;
+    ring.pushDisplay(0);
+    ring.pushDisplay(1);
+    ring.setDisplayRole(0, LayoutDisplayRole::Primary);
+
+    uint generation(ring.getGeneration());
+    ring.setDisplayRole(0, LayoutDisplayRole::Primary);
+    ring.unsetDisplayRole(1, LayoutDisplayRole::Secondary);
+    ring.unsetAllForRole(LayoutDisplayRole::Secondary);
+    EXPECT_EQ(ring.getGeneration(), generation);
+
+    ring.setDisplayRole(1, LayoutDisplayRole::Secondary);
+    EXPECT_NE(ring.getGeneration(), generation);
+
+    // Reordering displays without roles changes the ring, if not the role lists
+    generation = ring.getGeneration();
+    ring.pushDisplay(2);
+    EXPECT_NE(ring.getGeneration(), generation);
+    generation = ring.getGeneration();
+    ring.swapDisplays(2, -1.0f);
+    EXPECT_NE(ring.getGeneration(), generation);
+}
+
+TEST(DisplayRingTest, RoleListsFollowDisplayStates)
+{
+    const uint kNumDisplays(12);
+
+    DisplayManager displays;
+    for (uint i(0); i < kNumDisplays; ++i) {
+        std::string name("camera_" + std::to_string(i)), topic("/test/camera_" + std::to_string(i));
+        displays.addDisplay(Display(name, name, topic, DisplayDims(64, 48, 3)));
+    }
+
+    for (uint seed(0); seed < kNumSequences; ++seed) {
+        std::mt19937 rng(seed);
+        TestLayout layout(displays);
+        TestLayout::LayoutDisplayStates &states(layout.getDisplayStates());
+        TestLayout::DisplayRing &ring(states.getDisplayRing());
+
+        for (uint i(0); i < kCommandsPerSequence / 10; ++i) {
+            uint id(displays.getDisplayId(rng() % kNumDisplays));
+            LayoutDisplayRole role(kRoles[rng() % 2]);
+            std::string command;
+            switch (rng() % 4)
+            {
+                case 0:
+                {
+                    if (!states.isDisplayActive(id)) {
+                        states.activateDisplay(id);
+                    }
+                    command = "activateDisplay(" + std::to_string(id) + ")";
+                }   break;
+
+                case 1:
+                {
+                    if (states.isDisplayActive(id)) {
+                        states.deactivateDisplay(id);
+                    }
+                    command = "deactivateDisplay(" + std::to_string(id) + ")";
+                }   break;
+
+                default:
+                {
+                    int num(int(rng() % (kNumDisplays + 1)) - 1);
+                    uint role_count(states.setNumDisplaysForRole(num, role));
+                    EXPECT_EQ(role_count, ring.getNumForRole(role));
+                    command = "setNumDisplaysForRole(" + std::to_string(num) + ", " + roleName(role) + ")";
+                }   break;
+            }
+
+            std::string context("seed " + std::to_string(seed) + ", command " + std::to_string(i) + ": " + command);
+            expectRoleListsMatchSlots(ring, context);
+            if (::testing::Test::HasFailure()) {
+                return;
+            }
+        }
+    }
+}
+
+} // viewpoint_interface
@@ -0,0 +1,139 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ros/ros.h"
+#include <std_msgs/Bool.h>
+
+#include "viewpoint_interface/frame_arena.hpp"
+#include "viewpoint_interface/layout_manager.hpp"
+
+
+/**
+ * Draws each built-in layout through LayoutManager for a number of frames the
+ * way App::run does, with the control panel open, answering its image and
+ * thumbnail requests in between, and checks that once the layout has warmed
+ * up a frame makes no heap allocations.
+ */
+
+namespace viewpoint_interface
+{
+
+static const uint kNumDisplays = 8;
+static const uint kWarmUpFrames = 30;
+static const uint kMeasuredFrames = 300;
+
+
+class FrameAllocationsTest : public ::testing::TestWithParam<LayoutType>
+{
+protected:
+    LayoutManager layouts_;
+    std::vector<DisplayImageResponse> thumbnail_responses_; // Reused as App::handleThumbnailQueue does
+
+    virtual void SetUp() override
+    {
+        ImGui::CreateContext();
+        ImGuiIO &io(ImGui::GetIO());
+        io.IniFilename = NULL;
+        io.DisplaySize = ImVec2(1920.0f, 1080.0f);
+        io.DeltaTime = 1.0f / 60.0f;
+        unsigned char *pixels;
+        int width, height;
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+        for (uint i(0); i < kNumDisplays; ++i) {
+            std::string name("camera_" + std::to_string(i)), topic("/test/camera_" + std::to_string(i));
+            layouts_.addDisplay(Display(name, name, topic, DisplayDims(64, 48, 3)));
+        }
+        layouts_.activateLayout(GetParam());
+    }
+
+    virtual void TearDown() override
+    {
+        ImGui::DestroyContext();
+    }
+
+    // One iteration of the render loop, without the GL uploads
+    void drawFrame()
+    {
+        getFrameArena().reset();
+        ImGui::NewFrame();
+        layouts_.draw();
+
+        // Every requested display and thumbnail gets a texture, as it would
+        // once its first image was uploaded
+        std::vector<DisplayImageRequest> &requests(layouts_.getImageRequestQueue());
+        for (const DisplayImageRequest &request : requests) {
+            layouts_.pushImageResponse(DisplayImageResponse{request.getDisplayId() + 1, request.getDisplayId()});
+        }
+        requests.clear();
+
+        // Thumbnail responses go through a reused list, as ThumbnailCache::update fills it
+        std::vector<uint> &thumbnails(layouts_.getThumbnailRequestQueue());
+        thumbnail_responses_.clear();
+        for (uint id : thumbnails) {
+            thumbnail_responses_.push_back(DisplayImageResponse{id + 1, id});
+        }
+        for (const DisplayImageResponse &response : thumbnail_responses_) {
+            layouts_.pushThumbnailResponse(response);
+        }
+        thumbnails.clear();
+
+        ImGui::Render();
+    }
+
+    // Returns: heap allocations made while drawing the frames
+    uint64_t drawFrames(uint num_frames)
+    {
+        uint64_t allocations_before(getThreadHeapAllocations());
+        for (uint i(0); i < num_frames; ++i) {
+            drawFrame();
+        }
+
+        return getThreadHeapAllocations() - allocations_before;
+    }
+};
+
+INSTANTIATE_TEST_CASE_P(BuiltInLayouts, FrameAllocationsTest, ::testing::Values(LayoutType::GRID, LayoutType::PIP,
+        LayoutType::SPLIT, LayoutType::CAROUSEL, LayoutType::DOUBLE_PIP, LayoutType::DYNAMIC, LayoutType::TIMED_PIP,
+        LayoutType::TWINNED, LayoutType::TWINNED_PIP, LayoutType::WIDE));
+
+TEST_P(FrameAllocationsTest, SteadyStateFramesDoNotAllocate)
+{
+    drawFrames(kWarmUpFrames);
+    uint64_t num_allocations(drawFrames(kMeasuredFrames));
+
+    EXPECT_EQ(num_allocations, 0u) << "Layout " << (int)GetParam() << " allocated " << num_allocations <<
+            " times in " << kMeasuredFrames << " frames";
+    EXPECT_EQ(getFrameArena().getNumOverflows(), 0u);
+}
+
+TEST_P(FrameAllocationsTest, BatchedFramesDoNotAllocate)
+{
+    layouts_.setBatchedDisplays(true);
+    drawFrames(kWarmUpFrames);
+
+    EXPECT_EQ(drawFrames(kMeasuredFrames), 0u) << "Layout " << (int)GetParam();
+}
+
+// Commands rebuild the role lists and geometry once, after which frames go
+// back to not allocating
+TEST_P(FrameAllocationsTest, FramesAfterCommandsDoNotAllocate)
+{
+    const std::vector<std::string> kCommands{ "toggle", "primary_next", "pip_next", "active_right", "page_next",
+            "active_next", "toggle" };
+
+    // Pages of four, so paging has something to do
+    layouts_.setMaxDisplaysPerPage(4);
+    drawFrames(kWarmUpFrames);
+    for (const std::string &command : kCommands) {
+        layouts_.handleStringInput(command);
+        layouts_.setGrabbingState(command == "toggle");
+        drawFrames(kWarmUpFrames);
+
+        EXPECT_EQ(drawFrames(kMeasuredFrames), 0u) << "Layout " << (int)GetParam() << " after " << command;
+    }
+}
+
+} // viewpoint_interface
@@ -0,0 +1,140 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+#include "viewpoint_interface/input_log.hpp"
+
+
+namespace viewpoint_interface
+{
+
+class InputLogTest : public ::testing::Test
+{
+protected:
+    std::string path_;
+
+    virtual void SetUp() override
+    {
+        path_ = ::testing::TempDir() + "input_log_test.vpil";
+    }
+
+    virtual void TearDown() override
+    {
+        std::remove(path_.c_str());
+    }
+
+    void writeLog(const std::vector<std::pair<InputEventType, std::string>> &inputs)
+    {
+        InputRecorder recorder;
+        ASSERT_TRUE(recorder.open(path_));
+        for (uint i(0); i < inputs.size(); ++i) {
+            recorder.record(inputs[i].first, 10 * i, inputs[i].second);
+        }
+    }
+
+    // Appends one raw record, so invalid ones can be written
+    void appendRecord(uint8_t type, uint32_t size, const std::string &payload)
+    {
+        std::ofstream file(path_, std::ios::binary | std::ios::app);
+        int64_t time_ns(0);
+        uint64_t frame(0);
+        file.write(reinterpret_cast<const char *>(&type), sizeof(type));
+        file.write(reinterpret_cast<const char *>(&time_ns), sizeof(time_ns));
+        file.write(reinterpret_cast<const char *>(&frame), sizeof(frame));
+        file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        file.write(payload.data(), payload.size());
+    }
+};
+
+TEST_F(InputLogTest, LoadsRecordedInputs)
+{
+    writeLog({ { InputEventType::ControllerPacket, "{\"toggle\": true}" },
+            { InputEventType::ActiveDisplay, std::string(1, 3) },
+            { InputEventType::Grasping, std::string(1, 0) },
+            { InputEventType::Collision, "" } });
+
+    std::vector<InputEvent> events;
+    std::string error;
+    ASSERT_TRUE(loadInputLog(path_, events, error)) << error;
+    ASSERT_EQ(events.size(), 4u);
+
+    EXPECT_EQ(events[0].type, InputEventType::ControllerPacket);
+    EXPECT_EQ(events[0].payload, "{\"toggle\": true}");
+    EXPECT_EQ(events[1].type, InputEventType::ActiveDisplay);
+    EXPECT_EQ(events[1].payload, std::string(1, 3));
+    EXPECT_EQ(events[3].payload, "");
+    for (uint i(0); i < events.size(); ++i) {
+        EXPECT_EQ(events[i].frame, 10u * i);
+    }
+    for (uint i(1); i < events.size(); ++i) {
+        EXPECT_GE(events[i].time_ns, events[i - 1].time_ns);
+    }
+}
+
+TEST_F(InputLogTest, RejectsWrongPayloadSizes)
+{
+    for (InputEventType type : { InputEventType::ActiveDisplay, InputEventType::Grasping,
+            InputEventType::Clutching }) {
+        for (std::string payload : { std::string(), std::string(2, 1) }) {
+            writeLog({ { InputEventType::ManualCommand, "toggle" } });
+            appendRecord((uint8_t)type, payload.size(), payload);
+
+            std::vector<InputEvent> events;
+            std::string error;
+            EXPECT_FALSE(loadInputLog(path_, events, error)) << (int)type << ", " << payload.size() << " bytes";
+            EXPECT_TRUE(events.empty());
+            EXPECT_NE(error.find("record 1"), std::string::npos) << error;
+        }
+    }
+}
+
+TEST_F(InputLogTest, RejectsUnknownTypes)
+{
+    writeLog({});
+    appendRecord((uint8_t)InputEventType::Collision + 1, 1, "x");
+
+    std::vector<InputEvent> events;
+    std::string error;
+    EXPECT_FALSE(loadInputLog(path_, events, error));
+    EXPECT_NE(error.find("unknown input type"), std::string::npos) << error;
+}
+
+TEST_F(InputLogTest, RejectsTruncatedRecords)
+{
+    // The size promises more payload than the file holds
+    writeLog({ { InputEventType::ManualCommand, "toggle" } });
+    appendRecord((uint8_t)InputEventType::Collision, 100, "collision");
+
+    std::vector<InputEvent> events;
+    std::string error;
+    EXPECT_FALSE(loadInputLog(path_, events, error));
+    EXPECT_NE(error.find("truncated"), std::string::npos) << error;
+
+    // The file ends inside a record's header
+    writeLog({ { InputEventType::ManualCommand, "toggle" } });
+    {
+        std::ofstream file(path_, std::ios::binary | std::ios::app);
+        file.put((char)InputEventType::Grasping);
+    }
+    EXPECT_FALSE(loadInputLog(path_, events, error));
+    EXPECT_NE(error.find("truncated"), std::string::npos) << error;
+}
+
+TEST_F(InputLogTest, RejectsOtherFiles)
+{
+    std::vector<InputEvent> events;
+    std::string error;
+    EXPECT_FALSE(loadInputLog(path_ + ".missing", events, error));
+
+    {
+        std::ofstream file(path_, std::ios::binary);
+        file << "not an input log";
+    }
+    EXPECT_FALSE(loadInputLog(path_, events, error));
+    EXPECT_TRUE(events.empty());
+}
+
+} // viewpoint_interface
@@ -0,0 +1,38 @@
+#include <cstdio>
+#include <string>
+#include <sstream>
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+#include "viewpoint_interface/latency_tracker.hpp"
+
+
+namespace viewpoint_interface
+{
+
+TEST(LatencyTrackerTest, QuotesCommandsInCsv)
+{
+    LatencyTracker tracker;
+    tracker.commandApplied("layout,next", LatencyTracker::now(), LatencyTracker::CommandSource::Manual);
+    tracker.commandApplied("say \"hi\"", LatencyTracker::now(), LatencyTracker::CommandSource::Keyboard);
+    tracker.frameStarted();
+    tracker.frameSwapped();
+
+    std::string path(::testing::TempDir() + "latency_tracker_test.csv");
+    ASSERT_TRUE(tracker.exportCsv(path));
+    std::ifstream file(path);
+    std::string header, first, second, extra;
+    std::getline(file, header);
+    std::getline(file, first);
+    std::getline(file, second);
+    EXPECT_FALSE(std::getline(file, extra));
+    file.close();
+    std::remove(path.c_str());
+
+    EXPECT_EQ(header, "source,command,latency_ms");
+    EXPECT_EQ(first.rfind("manual,\"layout,next\",", 0), 0u) << first;
+    EXPECT_EQ(second.rfind("keyboard,\"say \"\"hi\"\"\",", 0), 0u) << second;
+}
+
+} // viewpoint_interface
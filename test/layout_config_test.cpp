@@ -0,0 +1,66 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "viewpoint_interface/layout_config.hpp"
+
+
+namespace viewpoint_interface
+{
+
+// A layout with a primary window and the given "keys" object
+static std::string makeConfig(const std::string &keys)
+{
+    return "{ \"layouts\": [ { \"name\": \"Test\", \"components\": [ { \"type\": \"primary\" } ], "
+            "\"keys\": " + keys + " } ] }";
+}
+
+TEST(LayoutConfigTest, ParsesKeyBindings)
+{
+    std::vector<LayoutSpec> specs;
+    std::string error;
+    ASSERT_TRUE(parseLayoutConfig(makeConfig("{ \"P\": \"toggle\", \"F2\": \"page_next\", \"left\": \"primary_prev\" }"),
+            specs, error)) << error;
+    ASSERT_EQ(specs.size(), 1u);
+    ASSERT_EQ(specs[0].key_bindings.size(), 3u);
+
+    bool found_p(false), found_f2(false), found_left(false);
+    for (const LayoutKeyBinding &binding : specs[0].key_bindings) {
+        found_p |= binding.key == GLFW_KEY_P && binding.command == LayoutCommand::TOGGLE;
+        found_f2 |= binding.key == GLFW_KEY_F2 && binding.command == LayoutCommand::PAGE_NEXT;
+        found_left |= binding.key == GLFW_KEY_LEFT && binding.command == LayoutCommand::PRIMARY_PREV;
+    }
+    EXPECT_TRUE(found_p);
+    EXPECT_TRUE(found_f2);
+    EXPECT_TRUE(found_left);
+}
+
+TEST(LayoutConfigTest, RejectsReservedKeys)
+{
+    for (const char *key : { "C", "b", "T" }) {
+        std::vector<LayoutSpec> specs;
+        std::string error;
+        EXPECT_FALSE(parseLayoutConfig(makeConfig(std::string("{ \"") + key + "\": \"toggle\" }"), specs, error))
+                << key;
+        EXPECT_NE(error.find("reserved"), std::string::npos) << error;
+        EXPECT_TRUE(specs.empty());
+    }
+}
+
+TEST(LayoutConfigTest, RejectsUnknownKeysAndCommands)
+{
+    std::vector<LayoutSpec> specs;
+    std::string error;
+    for (const char *key : { "F13", "F1x", "F1 ", "F0" }) {
+        EXPECT_FALSE(parseLayoutConfig(makeConfig(std::string("{ \"") + key + "\": \"toggle\" }"), specs, error))
+                << key;
+        EXPECT_NE(error.find("unknown key"), std::string::npos) << error;
+    }
+
+    EXPECT_FALSE(parseLayoutConfig(makeConfig("{ \"P\": \"no_such_command\" }"), specs, error));
+    EXPECT_NE(error.find("unknown command"), std::string::npos) << error;
+    EXPECT_TRUE(specs.empty());
+}
+
+} // viewpoint_interface
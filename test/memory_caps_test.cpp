@@ -0,0 +1,171 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ros/ros.h"
+#include <std_msgs/Bool.h>
+
+#include "viewpoint_interface/layout_manager.hpp"
+#include "viewpoint_interface/memory_tracker.hpp"
+
+
+/**
+ * Checks the pieces of memory accounting that don't need a GL context: the
+ * tracker's counters, the cap on cached layouts, and layouts forgetting the
+ * textures that eviction deleted.
+ */
+
+namespace viewpoint_interface
+{
+
+TEST(MemoryTrackerTest, CountsBytesByCategory)
+{
+    for (int i(0); i < (int)MemoryTracker::Category::Count; ++i) {
+        MemoryTracker::set((MemoryTracker::Category)i, 0);
+        EXPECT_NE(std::string(MemoryTracker::categoryToString((MemoryTracker::Category)i)), "");
+    }
+
+    // Owners add and subtract from any thread
+    std::vector<std::thread> threads;
+    for (uint i(0); i < 4; ++i) {
+        threads.emplace_back([]() {
+            for (uint j(0); j < 10000; ++j) {
+                MemoryTracker::add(MemoryTracker::Category::Textures, 3);
+                MemoryTracker::add(MemoryTracker::Category::Textures, -1);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    MemoryTracker::add(MemoryTracker::Category::FrameBuffers, 100);
+
+    EXPECT_EQ(MemoryTracker::get(MemoryTracker::Category::Textures), 4 * 10000 * 2);
+    EXPECT_EQ(MemoryTracker::get(MemoryTracker::Category::FrameBuffers), 100);
+    EXPECT_EQ(MemoryTracker::getTotal(), 4 * 10000 * 2 + 100);
+
+    MemoryTracker::set(MemoryTracker::Category::Textures, 0);
+    MemoryTracker::set(MemoryTracker::Category::FrameBuffers, 0);
+    EXPECT_EQ(MemoryTracker::getTotal(), 0);
+}
+
+
+class LayoutCacheTest : public ::testing::Test
+{
+protected:
+    LayoutManager layouts_;
+
+    // A request left in the active layout's queue survives for as long as that
+    // layout object does, which tells a cached layout from a newly made one
+    void markActiveLayout()
+    {
+        layouts_.getImageRequestQueue().emplace_back(1, 1, marker_data_, 0);
+    }
+
+    bool isActiveLayoutMarked() { return !layouts_.getImageRequestQueue().empty(); }
+
+private:
+    std::vector<uchar> marker_data_;
+};
+
+TEST_F(LayoutCacheTest, KeepsAllLayoutsWithoutACap)
+{
+    for (LayoutType type : { LayoutType::GRID, LayoutType::PIP, LayoutType::SPLIT, LayoutType::WIDE }) {
+        layouts_.activateLayout(type);
+        markActiveLayout();
+    }
+    for (LayoutType type : { LayoutType::GRID, LayoutType::PIP, LayoutType::SPLIT }) {
+        layouts_.activateLayout(type);
+        EXPECT_TRUE(isActiveLayoutMarked()) << (int)type;
+    }
+    EXPECT_EQ(layouts_.getNumEvictedLayouts(), 0u);
+}
+
+TEST_F(LayoutCacheTest, DropsLeastRecentlyActiveLayoutsOverTheCap)
+{
+    layouts_.setMaxCachedLayouts(4);
+    for (LayoutType type : { LayoutType::GRID, LayoutType::PIP, LayoutType::SPLIT }) {
+        layouts_.activateLayout(type);
+        markActiveLayout();
+    }
+
+    // Grid was active again more recently than PiP, so PiP is dropped first
+    layouts_.activateLayout(LayoutType::GRID);
+    EXPECT_TRUE(isActiveLayoutMarked());
+    layouts_.activateLayout(LayoutType::WIDE);
+    layouts_.activateLayout(LayoutType::DYNAMIC);
+    EXPECT_LE(layouts_.getNumCachedLayouts(), 4u);
+    EXPECT_EQ(layouts_.getNumEvictedLayouts(), 1u);
+
+    layouts_.activateLayout(LayoutType::GRID);
+    EXPECT_TRUE(isActiveLayoutMarked());
+
+    // A dropped layout starts again from its defaults
+    layouts_.activateLayout(LayoutType::PIP);
+    EXPECT_FALSE(isActiveLayoutMarked());
+}
+
+TEST_F(LayoutCacheTest, LoweringTheCapTrimsTheCache)
+{
+    for (LayoutType type : { LayoutType::GRID, LayoutType::PIP, LayoutType::SPLIT, LayoutType::WIDE }) {
+        layouts_.activateLayout(type);
+    }
+    uint num_cached(layouts_.getNumCachedLayouts());
+
+    layouts_.setMaxCachedLayouts(2);
+    EXPECT_LE(layouts_.getNumCachedLayouts(), 2u);
+    EXPECT_EQ(layouts_.getNumEvictedLayouts(), num_cached - layouts_.getNumCachedLayouts());
+}
+
+
+// Exposes the display ring's texture ids and draws nothing
+class TextureLayout : public Layout
+{
+public:
+    TextureLayout(DisplayManager &displays) : Layout(LayoutType::GRID, displays) {}
+
+    virtual void displayLayoutParams() override {}
+    virtual void draw() override {}
+
+    using Layout::handleImageResponse;
+
+    uint getImageId(uint display_id) { return display_states_.getDisplayRing().getImageIdForDisplayId(display_id); }
+    uint getThumbnailId(uint display_id)
+    {
+        return display_states_.getDisplayRing().getThumbnailIdForDisplayId(display_id);
+    }
+};
+
+TEST(ForgetTextureTest, EvictedTexturesAreNotDrawn)
+{
+    DisplayManager displays;
+    std::string name("camera"), topic("/test/camera");
+    Display display(name, name, topic, DisplayDims(64, 48, 3));
+    uint id(display.getId());
+    displays.addDisplay(display);
+    TextureLayout layout(displays);
+
+    layout.pushImageResponse(DisplayImageResponse{7, id});
+    layout.pushThumbnailResponse(DisplayImageResponse{8, id});
+    layout.handleImageResponse();
+    EXPECT_EQ(layout.getImageId(id), 7u);
+    EXPECT_EQ(layout.getThumbnailId(id), 8u);
+
+    layout.forgetImage(id);
+    layout.forgetThumbnail(id);
+    EXPECT_EQ(layout.getImageId(id), 0u);
+    EXPECT_EQ(layout.getThumbnailId(id), 0u);
+
+    // Responses still queued for the deleted textures are dropped as well
+    layout.pushImageResponse(DisplayImageResponse{7, id});
+    layout.pushThumbnailResponse(DisplayImageResponse{8, id});
+    layout.forgetImage(id);
+    layout.forgetThumbnail(id);
+    layout.handleImageResponse();
+    EXPECT_EQ(layout.getImageId(id), 0u);
+    EXPECT_EQ(layout.getThumbnailId(id), 0u);
+}
+
+} // viewpoint_interface
@@ -0,0 +1,139 @@
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "ros/ros.h"
+
+#include "viewpoint_interface/pipeline_stats.hpp"
+
+
+namespace viewpoint_interface
+{
+
+static const uint kCameraId = 100;
+
+// Returns: the value under key, or an empty string if the status has none
+static std::string getValue(const diagnostic_msgs::DiagnosticStatus &status, const std::string &key)
+{
+    for (const diagnostic_msgs::KeyValue &value : status.values) {
+        if (value.key == key) {
+            return value.value;
+        }
+    }
+
+    return std::string();
+}
+
+
+class PipelineStatsTest : public ::testing::Test
+{
+protected:
+    PipelineStats stats_;
+
+    virtual void SetUp() override
+    {
+        // Stamping the diagnostics needs ROS time, which needs no master
+        ros::Time::init();
+        stats_.addCamera(kCameraId, "front");
+    }
+
+    // The pipeline status comes first, then one per camera
+    diagnostic_msgs::DiagnosticArray report()
+    {
+        diagnostic_msgs::DiagnosticArray msg(stats_.makeDiagnostics());
+        EXPECT_EQ(msg.status.size(), 2u);
+        return msg;
+    }
+};
+
+TEST_F(PipelineStatsTest, WarnsAboutCamerasWithoutImages)
+{
+    diagnostic_msgs::DiagnosticArray msg(report());
+    EXPECT_EQ(msg.status[1].name, "viewpoint_interface: Camera front");
+    EXPECT_EQ((int)msg.status[1].level, (int)diagnostic_msgs::DiagnosticStatus::WARN);
+    EXPECT_EQ(msg.status[1].message, "No images yet");
+
+    stats_.imageReceived(kCameraId, -1.0f);
+    msg = report();
+    EXPECT_EQ((int)msg.status[1].level, (int)diagnostic_msgs::DiagnosticStatus::OK);
+
+    // Images stopped coming since the last report
+    msg = report();
+    EXPECT_EQ((int)msg.status[1].level, (int)diagnostic_msgs::DiagnosticStatus::WARN);
+    EXPECT_EQ(msg.status[1].message, "No images");
+}
+
+TEST_F(PipelineStatsTest, ReportsDropsOnlyWhenKnown)
+{
+    stats_.imageReceived(kCameraId, -1.0f);
+    EXPECT_EQ(getValue(report().status[1], "Dropped"), "unknown");
+
+    stats_.setDropped(kCameraId, 3);
+    EXPECT_EQ(getValue(report().status[1], "Dropped"), "3");
+
+    // Images for cameras that weren't added are ignored
+    stats_.imageReceived(kCameraId + 1, 1.0f);
+    stats_.setDropped(kCameraId + 1, 5);
+    EXPECT_EQ(report().status.size(), 2u);
+}
+
+TEST_F(PipelineStatsTest, AveragesAgesAndConversionsPerReport)
+{
+    stats_.imageReceived(kCameraId, 10.0f);
+    stats_.imageReceived(kCameraId, 30.0f);
+    stats_.imageReceived(kCameraId, -1.0f);
+    stats_.imageConverted(kCameraId, 1.0f);
+    stats_.imageConverted(kCameraId, 2.0f);
+
+    diagnostic_msgs::DiagnosticStatus camera(report().status[1]);
+    EXPECT_EQ(getValue(camera, "Frame age (ms)"), "20.00");
+    EXPECT_EQ(getValue(camera, "Frame age max (ms)"), "30.00");
+    EXPECT_EQ(getValue(camera, "Conversion (ms)"), "1.50");
+
+    // Only what arrived since the previous report counts
+    stats_.imageReceived(kCameraId, 4.0f);
+    camera = report().status[1];
+    EXPECT_EQ(getValue(camera, "Frame age (ms)"), "4.00");
+    EXPECT_EQ(getValue(camera, "Frame age max (ms)"), "4.00");
+    EXPECT_EQ(getValue(camera, "Conversion (ms)"), "0.00");
+}
+
+TEST_F(PipelineStatsTest, ReportsFrameTimesAndQueues)
+{
+    diagnostic_msgs::DiagnosticStatus pipeline(report().status[0]);
+    EXPECT_EQ((int)pipeline.level, (int)diagnostic_msgs::DiagnosticStatus::WARN);
+    EXPECT_EQ(pipeline.message, "No frames");
+
+    stats_.frameSwapped();
+    for (uint i(0); i < 3; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        stats_.frameSwapped();
+    }
+    stats_.setQueueDepth(PipelineStats::Queue::PendingUploads, 2);
+
+    pipeline = report().status[0];
+    EXPECT_EQ((int)pipeline.level, (int)diagnostic_msgs::DiagnosticStatus::OK);
+    EXPECT_GE(std::stof(getValue(pipeline, "Frame time p50 (ms)")), 5.0f);
+    EXPECT_GE(std::stof(getValue(pipeline, "Frame time max (ms)")), 5.0f);
+    EXPECT_EQ(getValue(pipeline, "Pending uploads"), "2");
+    EXPECT_EQ(getValue(pipeline, "Image requests"), "0");
+
+    // The histogram is cleared by each report
+    EXPECT_EQ(report().status[0].message, "No frames");
+}
+
+TEST_F(PipelineStatsTest, ReportsStallsBeyondTheHistogram)
+{
+    float histogram_ms(PipelineStats::kNumBins * PipelineStats::kBinMs);
+    stats_.frameSwapped();
+    std::this_thread::sleep_for(std::chrono::milliseconds((int)histogram_ms + 20));
+    stats_.frameSwapped();
+
+    diagnostic_msgs::DiagnosticStatus pipeline(report().status[0]);
+    EXPECT_EQ(std::stof(getValue(pipeline, "Frame time p99 (ms)")), histogram_ms);
+    EXPECT_GE(std::stof(getValue(pipeline, "Frame time max (ms)")), histogram_ms + 20.0f);
+}
+
+} // viewpoint_interface
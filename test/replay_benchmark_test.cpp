@@ -0,0 +1,149 @@
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "viewpoint_interface/replay_benchmark.hpp"
+
+
+namespace viewpoint_interface
+{
+
+static const uint kCameraId = 100;
+
+// Returns: the ingested, uploaded and displayed counts in the report's line for the camera
+static std::vector<uint64_t> getCameraCounts(const std::string &report, const std::string &name)
+{
+    std::istringstream lines(report);
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::istringstream fields(line);
+        std::string first;
+        uint64_t ingested, uploaded, displayed;
+        if (fields >> first && first == name && fields >> ingested >> uploaded >> displayed) {
+            return { ingested, uploaded, displayed };
+        }
+    }
+
+    return {};
+}
+
+
+class ReplayBenchmarkTest : public ::testing::Test
+{
+protected:
+    ReplayBenchmark bench_;
+
+    virtual void SetUp() override
+    {
+        bench_.addCamera(kCameraId, "camera");
+        bench_.start();
+    }
+};
+
+TEST_F(ReplayBenchmarkTest, FailsWhenPlaybackNeverFinished)
+{
+    EXPECT_FALSE(bench_.passed());
+    EXPECT_NE(bench_.getReport().find("FAILED"), std::string::npos);
+}
+
+TEST_F(ReplayBenchmarkTest, CountsImagesThroughThePipeline)
+{
+    // The second image replaces the first before it is uploaded, the third is
+    // uploaded but the bag ends before it is swapped
+    ReplayBenchmark::Clock::time_point now(ReplayBenchmark::Clock::now());
+    bench_.imageIngested(kCameraId, now);
+    bench_.imageIngested(kCameraId, now);
+    bench_.imageUploaded(kCameraId);
+    bench_.frameSwapped();
+    bench_.frameSwapped();
+    bench_.imageIngested(kCameraId, now);
+    bench_.imageUploaded(kCameraId);
+    bench_.imageIngested(kCameraId + 1, now);
+    bench_.finish(4, 1.0);
+
+    EXPECT_EQ(getCameraCounts(bench_.getReport(), "camera"), (std::vector<uint64_t>{ 3, 2, 1 }));
+    EXPECT_TRUE(bench_.passed());
+}
+
+TEST_F(ReplayBenchmarkTest, ChecksLatencyFromIngestToSwap)
+{
+    bench_.imageIngested(kCameraId, ReplayBenchmark::Clock::now() - std::chrono::milliseconds(50));
+    bench_.imageUploaded(kCameraId);
+    bench_.frameSwapped();
+    bench_.finish(1, 1.0);
+
+    ReplayBenchmark::Thresholds thresholds;
+    thresholds.max_latency_ms = 40.0f;
+    bench_.setThresholds(thresholds);
+    EXPECT_FALSE(bench_.passed());
+    EXPECT_NE(bench_.getReport().find("EXCEEDED"), std::string::npos);
+
+    thresholds.max_latency_ms = 60000.0f;
+    bench_.setThresholds(thresholds);
+    EXPECT_TRUE(bench_.passed()) << bench_.getReport();
+}
+
+TEST_F(ReplayBenchmarkTest, IgnoresUploadsWithoutANewIngest)
+{
+    // The scheduler uploads displays it hasn't seen yet before the bag thread
+    // ingests anything, and may upload an image again
+    bench_.imageUploaded(kCameraId);
+    bench_.frameSwapped();
+    bench_.imageIngested(kCameraId, ReplayBenchmark::Clock::now());
+    bench_.imageUploaded(kCameraId);
+    bench_.imageUploaded(kCameraId);
+    bench_.frameSwapped();
+    bench_.finish(1, 1.0);
+
+    ReplayBenchmark::Thresholds thresholds;
+    thresholds.max_latency_ms = 1000.0f;
+    bench_.setThresholds(thresholds);
+    EXPECT_EQ(getCameraCounts(bench_.getReport(), "camera"), (std::vector<uint64_t>{ 1, 1, 1 }));
+    EXPECT_TRUE(bench_.passed()) << bench_.getReport();
+}
+
+TEST_F(ReplayBenchmarkTest, WaitsForTheRenderLoopToTakeAnImage)
+{
+    // Nothing was ingested, so there's nothing to wait for
+    bench_.waitForCamera(kCameraId);
+
+    bench_.imageIngested(kCameraId, ReplayBenchmark::Clock::now());
+    std::thread render([this]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        bench_.imageUploaded(kCameraId);
+        bench_.frameSwapped();
+    });
+
+    ReplayBenchmark::Clock::time_point start(ReplayBenchmark::Clock::now());
+    bench_.waitForCamera(kCameraId);
+    std::chrono::duration<float, std::milli> waited(ReplayBenchmark::Clock::now() - start);
+    render.join();
+
+    EXPECT_LT(waited.count(), (float)ReplayBenchmark::kMaxCameraWaitMs);
+}
+
+TEST_F(ReplayBenchmarkTest, GivesUpOnImagesThatArentUploaded)
+{
+    bench_.imageIngested(kCameraId, ReplayBenchmark::Clock::now());
+    for (uint i(0); i < ReplayBenchmark::kSwapsPerImage; ++i) {
+        bench_.frameSwapped();
+    }
+
+    ReplayBenchmark::Clock::time_point start(ReplayBenchmark::Clock::now());
+    bench_.waitForCamera(kCameraId);
+    std::chrono::duration<float, std::milli> waited(ReplayBenchmark::Clock::now() - start);
+    EXPECT_LT(waited.count(), (float)ReplayBenchmark::kMaxCameraWaitMs);
+
+    // Without swaps the wait times out, give or take the clock's rounding
+    bench_.imageIngested(kCameraId, ReplayBenchmark::Clock::now());
+    start = ReplayBenchmark::Clock::now();
+    bench_.waitForCamera(kCameraId);
+    waited = ReplayBenchmark::Clock::now() - start;
+    EXPECT_GE(waited.count(), ReplayBenchmark::kMaxCameraWaitMs - 1.0f);
+}
+
+} // viewpoint_interface
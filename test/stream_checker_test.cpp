@@ -0,0 +1,113 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "viewpoint_interface/frame_marker.hpp"
+#include "viewpoint_interface/stream_checker.hpp"
+
+
+namespace viewpoint_interface
+{
+
+static const uint kStreamId = 100;
+
+
+TEST(FrameMarkerTest, ReadsBackWrittenSequences)
+{
+    for (uint bytes_per_pixel : { 1, 3, 4, 6 }) {
+        for (uint64_t seq : { 0ull, 1ull, 0x123456789ABCDEFull, ~0ull }) {
+            std::vector<uint8_t> row(kFrameMarkerPixels * bytes_per_pixel, 0x7F);
+            ASSERT_TRUE(writeFrameMarker(row.data(), kFrameMarkerPixels, bytes_per_pixel, seq));
+
+            uint64_t read(0);
+            EXPECT_TRUE(readFrameMarker(row.data(), kFrameMarkerPixels, bytes_per_pixel, read));
+            EXPECT_EQ(read, seq) << bytes_per_pixel << " bytes per pixel";
+        }
+    }
+}
+
+TEST(FrameMarkerTest, RejectsUnmarkedAndNarrowRows)
+{
+    std::vector<uint8_t> row(kFrameMarkerPixels * 3, 0x00);
+    uint64_t seq(42);
+    EXPECT_FALSE(readFrameMarker(row.data(), kFrameMarkerPixels, 3, seq));
+    EXPECT_EQ(seq, 42u);
+
+    EXPECT_FALSE(writeFrameMarker(row.data(), kFrameMarkerPixels - 1, 3, 1));
+    ASSERT_TRUE(writeFrameMarker(row.data(), kFrameMarkerPixels, 3, 1));
+    EXPECT_FALSE(readFrameMarker(row.data(), kFrameMarkerPixels - 1, 3, seq));
+}
+
+
+class StreamCheckerTest : public ::testing::Test
+{
+protected:
+    StreamChecker checker_;
+
+    virtual void SetUp() override
+    {
+        checker_.addStream(kStreamId, "camera");
+    }
+
+    void receive(const std::vector<uint64_t> &seqs)
+    {
+        for (uint64_t seq : seqs) {
+            checker_.frameReceived(kStreamId, seq, -1.0f);
+        }
+    }
+};
+
+TEST_F(StreamCheckerTest, CountsGapsAsDropped)
+{
+    EXPECT_FALSE(checker_.hasFrames());
+
+    // A stream may start anywhere, only gaps after its first frame are drops
+    receive({ 5, 6, 7, 10, 11, 15 });
+    StreamChecker::Stats stats(checker_.getStats(kStreamId));
+    EXPECT_EQ(stats.received, 6u);
+    EXPECT_EQ(stats.dropped, 5u);
+    EXPECT_EQ(stats.reordered, 0u);
+    EXPECT_TRUE(checker_.hasFrames());
+}
+
+TEST_F(StreamCheckerTest, LateFramesAreReorderedNotDropped)
+{
+    receive({ 1, 2, 4, 5, 3 });
+    StreamChecker::Stats stats(checker_.getStats(kStreamId));
+    EXPECT_EQ(stats.received, 5u);
+    EXPECT_EQ(stats.dropped, 0u);
+    EXPECT_EQ(stats.reordered, 1u);
+}
+
+TEST_F(StreamCheckerTest, CountsDuplicatesAndRestarts)
+{
+    receive({ 1, 2, 2, 3, 0, 1, 2 });
+    StreamChecker::Stats stats(checker_.getStats(kStreamId));
+    EXPECT_EQ(stats.received, 7u);
+    EXPECT_EQ(stats.duplicates, 1u);
+    EXPECT_EQ(stats.restarts, 1u);
+    EXPECT_EQ(stats.dropped, 0u);
+    EXPECT_EQ(stats.reordered, 0u);
+}
+
+TEST_F(StreamCheckerTest, TracksImageAge)
+{
+    checker_.frameReceived(kStreamId, 1, 10.0f);
+    checker_.frameReceived(kStreamId, 2, 30.0f);
+    checker_.frameReceived(kStreamId, 3, -1.0f);
+
+    StreamChecker::Stats stats(checker_.getStats(kStreamId));
+    EXPECT_EQ(stats.max_age_ms, 30.0f);
+    EXPECT_GT(stats.mean_age_ms, 10.0f);
+    EXPECT_LT(stats.mean_age_ms, 30.0f);
+}
+
+TEST_F(StreamCheckerTest, IgnoresUnknownStreams)
+{
+    checker_.frameReceived(kStreamId + 1, 1, 1.0f);
+    EXPECT_FALSE(checker_.hasFrames());
+    EXPECT_EQ(checker_.getStats(kStreamId + 1).received, 0u);
+    EXPECT_TRUE(checker_.getSummary().empty());
+}
+
+} // viewpoint_interface
@@ -0,0 +1,163 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <opencv2/opencv.hpp>
+
+#include "viewpoint_interface/upload_scheduler.hpp"
+
+
+namespace viewpoint_interface
+{
+
+static const uint kNumDisplays = 4;
+static const uint kWidth = 64, kHeight = 48;
+static const uint64_t kImageBytes = kWidth * kHeight * 3;
+
+
+class UploadSchedulerTest : public ::testing::Test
+{
+protected:
+    DisplayManager displays_;
+    UploadScheduler scheduler_;
+    std::vector<uint> ids_;
+    std::vector<DisplayImageRequest> queue_;
+
+    virtual void SetUp() override
+    {
+        for (uint i(0); i < kNumDisplays; ++i) {
+            std::string name("camera_" + std::to_string(i)), topic("/test/camera_" + std::to_string(i));
+            Display display(name, name, topic, DisplayDims(kWidth, kHeight, 3));
+            ids_.push_back(display.getId());
+            displays_.addDisplay(display);
+        }
+    }
+
+    void newImage(uint id)
+    {
+        displays_.copyImageToDisplay(id, cv::Mat(kHeight, kWidth, CV_8UC3));
+    }
+
+    void request(uint id, UploadPriority priority)
+    {
+        queue_.emplace_back(kWidth, kHeight, data_, id, priority);
+    }
+
+    // Returns: the display ids uploaded, in upload order
+    std::vector<uint> schedule()
+    {
+        std::vector<uint> uploaded;
+        for (uint ix : scheduler_.schedule(queue_, displays_)) {
+            uploaded.push_back(queue_[ix].getDisplayId());
+        }
+        return uploaded;
+    }
+
+private:
+    std::vector<uchar> data_;
+};
+
+TEST_F(UploadSchedulerTest, UploadsOnlyChangedImages)
+{
+    scheduler_.setSecondaryRate(0.0f);
+    scheduler_.setBudget(0);
+    for (uint id : ids_) {
+        newImage(id);
+        request(id, UploadPriority::Primary);
+    }
+
+    EXPECT_EQ(schedule().size(), kNumDisplays);
+    EXPECT_TRUE(schedule().empty());
+    EXPECT_EQ(scheduler_.getStats().num_unchanged, kNumDisplays);
+    EXPECT_FALSE(scheduler_.hasPendingUploads());
+
+    newImage(ids_[2]);
+    EXPECT_EQ(schedule(), std::vector<uint>{ ids_[2] });
+}
+
+TEST_F(UploadSchedulerTest, UploadsMostUrgentRoleFirst)
+{
+    scheduler_.setSecondaryRate(0.0f);
+    scheduler_.setBudget(0);
+    request(ids_[0], UploadPriority::Secondary);
+    request(ids_[1], UploadPriority::Primary);
+    request(ids_[2], UploadPriority::ActiveFrame);
+    request(ids_[3], UploadPriority::Secondary);
+
+    std::vector<uint> uploaded(schedule());
+    ASSERT_EQ(uploaded.size(), 4u);
+    EXPECT_EQ(uploaded[0], ids_[2]);
+    EXPECT_EQ(uploaded[1], ids_[1]);
+}
+
+TEST_F(UploadSchedulerTest, HoldsSecondaryDisplaysToTheirRate)
+{
+    scheduler_.setSecondaryRate(0.01f);
+    scheduler_.setBudget(0);
+    for (uint id : ids_) {
+        newImage(id);
+    }
+    request(ids_[0], UploadPriority::Primary);
+    request(ids_[1], UploadPriority::Secondary);
+    schedule();
+
+    newImage(ids_[0]);
+    newImage(ids_[1]);
+    EXPECT_EQ(schedule(), std::vector<uint>{ ids_[0] });
+    EXPECT_EQ(scheduler_.getStats().num_held, 1u);
+    EXPECT_TRUE(scheduler_.hasPendingUploads());
+
+    // Forgotten displays are uploaded as if seen for the first time
+    scheduler_.forgetDisplay(ids_[1]);
+    EXPECT_EQ(schedule(), std::vector<uint>{ ids_[1] });
+}
+
+TEST_F(UploadSchedulerTest, DefersSecondaryDisplaysOverBudget)
+{
+    scheduler_.setSecondaryRate(0.0f);
+    scheduler_.setBudget(2 * kImageBytes);
+    request(ids_[0], UploadPriority::Primary);
+    request(ids_[1], UploadPriority::Primary);
+    request(ids_[2], UploadPriority::Secondary);
+
+    // The primaries use up the budget, so the secondary waits, but only for
+    // kMaxDeferrals frames
+    uint frames_deferred(0);
+    while (true) {
+        for (uint id : ids_) {
+            newImage(id);
+        }
+        std::vector<uint> uploaded(schedule());
+        ASSERT_GE(uploaded.size(), 2u);
+        if (uploaded.size() == 3) {
+            EXPECT_EQ(uploaded[2], ids_[2]);
+            break;
+        }
+        EXPECT_EQ(scheduler_.getStats().num_deferred, 1u);
+        ASSERT_LE(++frames_deferred, UploadScheduler::kMaxDeferrals);
+    }
+    EXPECT_EQ(frames_deferred, UploadScheduler::kMaxDeferrals);
+
+    // Primaries are never deferred, even when they alone exceed the budget
+    scheduler_.setBudget(kImageBytes / 2);
+    newImage(ids_[0]);
+    newImage(ids_[1]);
+    EXPECT_EQ(schedule().size(), 2u);
+}
+
+TEST_F(UploadSchedulerTest, ScalesSecondaryUploads)
+{
+    scheduler_.setSecondaryRate(0.0f);
+    scheduler_.setBudget(0);
+    scheduler_.setSecondaryScale(0.5f);
+    EXPECT_EQ(scheduler_.getUploadScale(UploadPriority::Primary), 1.0f);
+    EXPECT_EQ(scheduler_.getUploadScale(UploadPriority::Secondary), 0.5f);
+
+    newImage(ids_[0]);
+    request(ids_[0], UploadPriority::Secondary);
+    schedule();
+    EXPECT_EQ(scheduler_.getStats().bytes_uploaded, kImageBytes / 4);
+}
+
+} // viewpoint_interface